@@ -21,3 +21,5 @@ int main (int argc, char* argv[])
 #include "catch2/catch_test_macros.hpp"
 
 #include "Benchmarks.cpp"
+#include "DspBenchmarks.cpp"
+#include "ImportBenchmarks.cpp"
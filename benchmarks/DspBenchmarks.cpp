@@ -0,0 +1,292 @@
+#include "SyntheticPlayHead.h"
+#include <iostream>
+#include <limits>
+
+// ==========================================================
+// PROCESSBLOCK THROUGHPUT
+// ==========================================================
+// "DSP performance" runs a few representative engine setups through Catch2's
+// own benchmark reporter. "[matrix]" is the full sweep: every mode, modifier,
+// Ghost path and sidechain source at 512 samples / 48 kHz, then every block
+// size from 16 to 4096 against every sample rate from 44.1 to 192 kHz for a
+// few heavy setups. It's hidden from the default run because it takes a while:
+//
+//     ./Benchmarks "[matrix]"
+//
+// Results are reported as ns per sample frame (both channels) and as realtime
+// factor (seconds of audio per second of CPU), and written as JSON to
+// $RIDER_BENCHMARK_JSON, or processBlock-benchmarks.json in the working directory.
+namespace DspBench
+{
+    struct EngineSetup
+    {
+        int mode { 0 };
+        bool flip { false };
+        int shred { 0 }; // 0 = off, 1..3 = SHRED I..III
+        bool chop { false };
+        int ghost { 0 }; // 0 = off, 1 = record, 2 = read, 3 = frozen
+        bool externalSidechain { false };
+
+        juce::String describe() const
+        {
+            juce::StringArray parts { "mode " + juce::String (mode) };
+
+            if (flip) parts.add ("FLIP");
+            if (shred > 0) parts.add ("SHRED " + juce::String::repeatedString ("I", shred));
+            if (chop) parts.add ("CHOP");
+            if (ghost == 1) parts.add ("ghost record");
+            if (ghost == 2) parts.add ("ghost read");
+            if (ghost == 3) parts.add ("frozen");
+            parts.add (externalSidechain ? "EXT" : "INT");
+
+            return parts.joinIntoString (" ");
+        }
+    };
+
+    struct Result
+    {
+        EngineSetup setup;
+        int blockSize { 0 };
+        double sampleRate { 0.0 };
+        double nsPerSample { 0.0 };
+        double realtimeFactor { 0.0 };
+    };
+
+    // Owns a prepared processor, an input with a musical-ish level contour on both buses and a transport
+    class Rig
+    {
+    public:
+        Rig (const EngineSetup& setupToUse, int blockSizeToUse, double sampleRateToUse, double secondsOfAudio)
+            : setup (setupToUse), blockSize (blockSizeToUse), sampleRate (sampleRateToUse),
+              numBlocks (juce::jmax (1, (int) (secondsOfAudio * sampleRateToUse) / blockSizeToUse))
+        {
+            playHead.sampleRate = sampleRate;
+            plugin.setPlayHead (&playHead);
+            plugin.setNonRealtime (false);
+            plugin.prepareToPlay (sampleRate, blockSize);
+
+            plugin.parameters.mode = setup.mode;
+            plugin.parameters.ratio = 1; // 3:1
+            plugin.parameters.flip = setup.flip;
+            plugin.parameters.shred = setup.shred > 0;
+            plugin.parameters.shredMode = juce::jmax (1, setup.shred) - 1;
+            plugin.parameters.chop = setup.chop;
+            plugin.parameters.externalSidechain = setup.externalSidechain;
+
+            // Pages for the whole timeline up front, as the pager would have them in a session, on
+            // the grid a map recorded at this tempo gets, plus a quarter note to spare
+            const auto resolution = GhostMap::resolutionFor (playHead.bpm);
+            const auto indicesPerSecond = resolution * playHead.bpm / 60.0;
+            const auto lastIndex = (int) std::ceil ((double) numBlocks * blockSize / sampleRate * indicesPerSecond + resolution);
+            plugin.ghostLibrary.editActiveSlot().allocateRange (0, lastIndex);
+            plugin.frozenGainMap.allocateRange (0, lastIndex);
+
+            const auto numChannels = plugin.getTotalNumInputChannels();
+            const auto numSamples = numBlocks * blockSize;
+            source.setSize (numChannels, numSamples);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                const auto frequency = (ch < 2) ? 110.0 : 165.0;
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    const auto t = (double) i / sampleRate;
+                    const auto contour = 0.3 + 0.25 * std::sin (juce::MathConstants<double>::twoPi * ((ch < 2) ? 0.7 : 1.3) * t);
+                    source.setSample (ch, i, (float) (contour * std::sin (juce::MathConstants<double>::twoPi * frequency * t)));
+                }
+            }
+
+            buffer.setSize (numChannels, blockSize);
+
+            // Replay needs something to replay, and freeze a fader captured on a read pass
+            if (setup.ghost >= 2)
+            {
+                plugin.isGhostRecording.store (true);
+                runTimeline();
+                plugin.isGhostRecording.store (false);
+            }
+
+            if (setup.ghost == 3)
+            {
+                plugin.isGhostReading.store (true);
+                runTimeline();
+            }
+
+            plugin.isGhostRecording.store (setup.ghost == 1);
+            plugin.isGhostReading.store (setup.ghost >= 2);
+            plugin.isFrozen.store (setup.ghost == 3);
+        }
+
+        ~Rig()
+        {
+            plugin.setPlayHead (nullptr);
+        }
+
+        // Plays the whole timeline from the top, returns the last output sample so the work can't be optimised away
+        float runTimeline()
+        {
+            playHead.playing = true;
+            playHead.jumpTo (0.0);
+
+            for (int block = 0; block < numBlocks; ++block)
+            {
+                for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                    buffer.copyFrom (ch, 0, source, ch, block * blockSize, blockSize);
+
+                plugin.processBlock (buffer, midi);
+                playHead.advance (blockSize);
+            }
+
+            return buffer.getSample (0, blockSize - 1);
+        }
+
+        int getNumSamples() const noexcept { return numBlocks * blockSize; }
+
+    private:
+        EngineSetup setup;
+        int blockSize;
+        double sampleRate;
+        int numBlocks;
+
+        PluginProcessor plugin;
+        SyntheticPlayHead playHead;
+        juce::AudioBuffer<float> source, buffer;
+        juce::MidiBuffer midi;
+    };
+
+    // Best of a few timeline passes, after one untimed warm-up pass
+    inline Result measure (const EngineSetup& setup, int blockSize, double sampleRate, double secondsOfAudio = 1.0, int passes = 3)
+    {
+        Rig rig (setup, blockSize, sampleRate, secondsOfAudio);
+        volatile float sink = rig.runTimeline();
+
+        double bestSeconds = std::numeric_limits<double>::max();
+
+        for (int pass = 0; pass < passes; ++pass)
+        {
+            const auto start = juce::Time::getHighResolutionTicks();
+            sink = rig.runTimeline();
+            const auto elapsed = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+            bestSeconds = std::min (bestSeconds, elapsed);
+        }
+
+        juce::ignoreUnused (sink);
+
+        Result result;
+        result.setup = setup;
+        result.blockSize = blockSize;
+        result.sampleRate = sampleRate;
+        result.nsPerSample = bestSeconds * 1.0e9 / (double) rig.getNumSamples();
+        result.realtimeFactor = ((double) rig.getNumSamples() / sampleRate) / juce::jmax (bestSeconds, 1.0e-12);
+        return result;
+    }
+
+    inline juce::var toJson (const Result& r)
+    {
+        auto* object = new juce::DynamicObject();
+        object->setProperty ("name", r.setup.describe());
+        object->setProperty ("mode", r.setup.mode);
+        object->setProperty ("flip", r.setup.flip);
+        object->setProperty ("shred", r.setup.shred);
+        object->setProperty ("chop", r.setup.chop);
+        object->setProperty ("ghost", juce::StringArray { "off", "record", "read", "frozen" }[r.setup.ghost]);
+        object->setProperty ("sidechain", r.setup.externalSidechain ? "external" : "internal");
+        object->setProperty ("blockSize", r.blockSize);
+        object->setProperty ("sampleRate", r.sampleRate);
+        object->setProperty ("nsPerSample", r.nsPerSample);
+        object->setProperty ("realtimeFactor", r.realtimeFactor);
+        return object;
+    }
+
+    inline juce::File getJsonFile()
+    {
+        const auto path = juce::SystemStats::getEnvironmentVariable ("RIDER_BENCHMARK_JSON", {});
+
+        if (path.isNotEmpty())
+            return juce::File::getCurrentWorkingDirectory().getChildFile (path);
+
+        return juce::File::getCurrentWorkingDirectory().getChildFile ("processBlock-benchmarks.json");
+    }
+
+    inline std::vector<EngineSetup> allEngineSetups()
+    {
+        std::vector<EngineSetup> setups;
+
+        for (int mode = 0; mode < 4; ++mode)
+            for (const bool flip : { false, true })
+                for (int shred = 0; shred <= 3; ++shred)
+                    for (const bool chop : { false, true })
+                        for (int ghost = 0; ghost <= 2; ++ghost)
+                            for (const bool external : { false, true })
+                                setups.push_back ({ mode, flip, shred, chop, ghost, external });
+
+        return setups;
+    }
+}
+
+TEST_CASE ("DSP performance", "[dsp]")
+{
+    using DspBench::EngineSetup;
+
+    const std::pair<const char*, EngineSetup> setups[] {
+        { "processBlock: mode 0, 512 @ 48k", EngineSetup {} },
+        { "processBlock: mode 2 SHRED II CHOP, ghost read EXT, 512 @ 48k", EngineSetup { 2, false, 2, true, 2, true } },
+        { "processBlock: mode 3 FLIP, ghost record, 512 @ 48k", EngineSetup { 3, true, 0, false, 1, false } },
+        { "processBlock: mode 2 SHRED II CHOP, frozen EXT, 512 @ 48k", EngineSetup { 2, false, 2, true, 3, true } },
+    };
+
+    for (const auto& [name, setup] : setups)
+    {
+        DspBench::Rig rig (setup, 512, 48000.0, 0.25);
+
+        BENCHMARK (name)
+        {
+            return rig.runTimeline();
+        };
+    }
+}
+
+TEST_CASE ("processBlock throughput matrix", "[.][matrix]")
+{
+    std::vector<DspBench::Result> results;
+
+    auto report = [&results] (const DspBench::Result& r) {
+        std::cout << r.setup.describe() << ", " << r.blockSize << " @ " << r.sampleRate << " Hz: "
+                  << juce::String (r.nsPerSample, 2) << " ns/sample, "
+                  << juce::String (r.realtimeFactor, 1) << "x realtime" << std::endl;
+        results.push_back (r);
+    };
+
+    // Every engine path at a typical session setting
+    for (const auto& setup : DspBench::allEngineSetups())
+        report (DspBench::measure (setup, 512, 48000.0));
+
+    // Block size and sample rate sweep for the cheapest and the heaviest paths
+    const DspBench::EngineSetup sweepSetups[] {
+        {},
+        { 2, false, 2, true, 2, true },
+        { 3, true, 3, true, 1, true },
+    };
+
+    for (const auto& setup : sweepSetups)
+        for (const double sampleRate : { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 })
+            for (int blockSize = 16; blockSize <= 4096; blockSize *= 2)
+                report (DspBench::measure (setup, blockSize, sampleRate));
+
+    juce::Array<juce::var> entries;
+    for (const auto& r : results)
+        entries.add (DspBench::toJson (r));
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty ("benchmark", "processBlock");
+    root->setProperty ("plugin", JucePlugin_Name);
+    root->setProperty ("juceVersion", juce::SystemStats::getJUCEVersion());
+    root->setProperty ("results", entries);
+
+    const auto file = DspBench::getJsonFile();
+    REQUIRE (file.replaceWithText (juce::JSON::toString (juce::var (root))));
+    std::cout << "Wrote " << results.size() << " results to " << file.getFullPathName() << std::endl;
+
+    CHECK (results.size() == DspBench::allEngineSetups().size() + 3 * 6 * 9);
+}
@@ -0,0 +1,52 @@
+// ==========================================================
+// GHOST IMPORT THROUGHPUT
+// ==========================================================
+// A 5 minute stereo 48 kHz reference, imported as a Ghost at 120 bpm, once on
+// one core and once split across all of them.
+TEST_CASE ("Ghost import performance", "[import]")
+{
+    constexpr double sampleRate = 48000.0;
+    const auto numSamples = (int) (5.0 * 60.0 * sampleRate);
+
+    auto file = juce::File::getSpecialLocation (juce::File::tempDirectory).getNonexistentChildFile ("ghost-import-benchmark", ".wav");
+
+    {
+        juce::AudioBuffer<float> chunk (2, 48000);
+        std::unique_ptr<juce::OutputStream> stream (file.createOutputStream());
+
+        const auto options = juce::AudioFormatWriterOptions {}
+                                 .withSampleRate (sampleRate)
+                                 .withNumChannels (2)
+                                 .withBitsPerSample (24);
+
+        auto writer = juce::WavAudioFormat().createWriterFor (stream, options);
+        REQUIRE (writer != nullptr);
+
+        for (int start = 0; start < numSamples; start += chunk.getNumSamples())
+        {
+            for (int ch = 0; ch < 2; ++ch)
+                for (int i = 0; i < chunk.getNumSamples(); ++i)
+                {
+                    const auto t = (double) (start + i) / sampleRate;
+                    const auto contour = 0.3 + 0.25 * std::sin (juce::MathConstants<double>::twoPi * (ch == 0 ? 0.7 : 1.3) * t);
+                    chunk.setSample (ch, i, (float) (contour * std::sin (juce::MathConstants<double>::twoPi * 110.0 * t)));
+                }
+
+            writer->writeFromAudioSampleBuffer (chunk, 0, chunk.getNumSamples());
+        }
+    }
+
+    for (const int numThreads : { 1, 0 })
+    {
+        GhostImport::Settings settings;
+        settings.numThreads = numThreads;
+
+        BENCHMARK (numThreads == 1 ? "5 minute import, one core" : "5 minute import, all cores")
+        {
+            GhostMap map;
+            return GhostImport::analyseFile (file, settings, map).wasOk();
+        };
+    }
+
+    file.deleteFile();
+}
@@ -0,0 +1,20 @@
+# A console renderer that runs audio files through the plugin outside a host
+file(GLOB_RECURSE RenderFiles CONFIGURE_DEPENDS "${CMAKE_CURRENT_SOURCE_DIR}/render/*.cpp" "${CMAKE_CURRENT_SOURCE_DIR}/render/*.h")
+
+# Organize the render source in the render/ folder in the IDE
+source_group(TREE ${CMAKE_CURRENT_SOURCE_DIR}/render PREFIX "" FILES ${RenderFiles})
+
+add_executable(RiderRender ${RenderFiles})
+target_compile_features(RiderRender PRIVATE cxx_std_20)
+
+# The renderer drives our plugin code directly...
+target_include_directories(RiderRender PRIVATE ${CMAKE_CURRENT_SOURCE_DIR}/source)
+
+# Copy over compile definitions from our plugin target so it has all the JUCEy goodness
+target_compile_definitions(RiderRender PRIVATE $<TARGET_PROPERTY:${PROJECT_NAME},COMPILE_DEFINITIONS>)
+
+# And links our shared code
+target_link_libraries(RiderRender PRIVATE SharedCode)
+
+# Make an Xcode Scheme for the renderer so it can be run and profiled in the IDE
+set_target_properties(RiderRender PROPERTIES XCODE_GENERATE_SCHEME ON)
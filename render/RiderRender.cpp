@@ -0,0 +1,180 @@
+// RiderRender: runs an audio file through the rider offline, outside a host.
+//
+//   RiderRender vocal.wav -o vocal_ridden.wav --bpm=96 --mode=vox --ratio=3
+//   RiderRender --batch=dialog --out-dir=dialog_ridden --mode=vox
+//
+// It's the same engine as the plugin, driven through processBlock by a
+// synthetic transport, so a render matches what a host playing the file from
+// the top at that tempo would print.
+
+#include "BatchRenderer.h"
+#include <juce_gui_basics/juce_gui_basics.h>
+#include <iostream>
+
+namespace
+{
+    const juce::StringArray modeNames { "off", "vox", "space", "punch" };
+
+    OfflineRenderer::Settings settingsFrom (juce::ArgumentList& args)
+    {
+        OfflineRenderer::Settings settings;
+
+        if (args.containsOption ("--bpm"))
+            settings.bpm = args.removeValueForOption ("--bpm").getDoubleValue();
+
+        if (args.containsOption ("--mode"))
+        {
+            const auto name = args.removeValueForOption ("--mode").toLowerCase();
+            settings.mode = modeNames.indexOf (name);
+
+            if (settings.mode < 0)
+                juce::ConsoleApplication::fail ("Unknown mode '" + name + "': use off, vox, space or punch");
+        }
+
+        settings.flip = args.removeOptionIfFound ("--flip");
+
+        if (args.containsOption ("--shred"))
+            settings.shredMode = args.removeValueForOption ("--shred").getIntValue();
+
+        if (args.containsOption ("--chop"))
+            settings.chopThreshold = args.removeValueForOption ("--chop").getFloatValue();
+
+        if (args.containsOption ("--ratio"))
+            settings.ratio = args.removeValueForOption ("--ratio").getIntValue();
+
+        settings.lookahead = args.removeOptionIfFound ("--lookahead");
+
+        if (args.containsOption ("--block"))
+            settings.blockSize = args.removeValueForOption ("--block").getIntValue();
+
+        return settings;
+    }
+
+    void render (const juce::ArgumentList& arguments)
+    {
+        auto args = arguments;
+        OfflineRenderer::Job job;
+
+        args.failIfOptionIsMissing ("--output|-o");
+        job.output = args.getFileForOptionAndRemove ("--output|-o");
+
+        if (args.containsOption ("--sidechain"))
+            job.sidechain = args.getExistingFileForOptionAndRemove ("--sidechain");
+
+        job.settings = settingsFrom (args);
+
+        // What's left is the input
+        if (args.size() != 1 || args[0].isOption())
+            juce::ConsoleApplication::fail ("Expected one input file, then options (see --help)");
+
+        job.input = args[0].resolveAsExistingFile();
+
+        OfflineRenderer renderer;
+        const auto startTime = juce::Time::getMillisecondCounterHiRes();
+        const auto result = renderer.render (job);
+
+        if (result.failed())
+            juce::ConsoleApplication::fail (result.getErrorMessage());
+
+        const auto seconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+        const auto audioSeconds = renderer.getLastLengthInSeconds();
+
+        std::cout << job.output.getFullPathName() << ": " << juce::String (audioSeconds, 1) << " s in "
+                  << juce::String (seconds, 2) << " s (" << juce::roundToInt (audioSeconds / juce::jmax (seconds, 1.0e-6))
+                  << "x realtime)" << std::endl;
+    }
+
+    void renderBatch (const juce::ArgumentList& arguments)
+    {
+        auto args = arguments;
+
+        const auto inputFolder = args.getExistingFolderForOptionAndRemove ("--batch");
+        args.failIfOptionIsMissing ("--out-dir");
+        const auto outputFolder = args.getFileForOptionAndRemove ("--out-dir");
+
+        juce::File sidechainFolder;
+
+        if (args.containsOption ("--sidechain-dir"))
+            sidechainFolder = args.getExistingFolderForOptionAndRemove ("--sidechain-dir");
+
+        const auto numWorkers = args.containsOption ("--jobs") ? args.removeValueForOption ("--jobs").getIntValue() : 0;
+        const auto settings = settingsFrom (args);
+
+        if (args.size() > 0)
+            juce::ConsoleApplication::fail ("Unexpected argument " + args[0].text + " (see --help)");
+
+        // Every audio file under the folder, to the same place under the output folder, as WAV.
+        // A sidechain is the file at the same place under the sidechain folder.
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        std::vector<OfflineRenderer::Job> jobs;
+
+        for (const auto& entry : juce::RangedDirectoryIterator (inputFolder, true, formats.getWildcardForAllFormats(), juce::File::findFiles))
+        {
+            const auto relativePath = entry.getFile().getRelativePathFrom (inputFolder);
+            OfflineRenderer::Job job { entry.getFile(), {}, outputFolder.getChildFile (relativePath).withFileExtension (".wav"), settings };
+
+            if (sidechainFolder != juce::File())
+                job.sidechain = sidechainFolder.getChildFile (relativePath);
+
+            jobs.push_back (job);
+        }
+
+        if (jobs.empty())
+            juce::ConsoleApplication::fail ("No audio files in " + inputFolder.getFullPathName());
+
+        BatchRenderer batch (numWorkers);
+        std::cout << "Rendering " << jobs.size() << " files on " << batch.getNumWorkers() << " workers" << std::endl;
+
+        const auto startTime = juce::Time::getMillisecondCounterHiRes();
+        const auto results = batch.render (jobs);
+        const auto seconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+        int numFailed = 0;
+
+        for (size_t i = 0; i < jobs.size(); ++i)
+        {
+            if (results[i].failed())
+            {
+                std::cerr << jobs[i].input.getFullPathName() << ": " << results[i].getErrorMessage() << std::endl;
+                ++numFailed;
+            }
+        }
+
+        std::cout << (int) jobs.size() - numFailed << " rendered, " << numFailed << " failed, in "
+                  << juce::String (seconds, 2) << " s" << std::endl;
+
+        if (numFailed > 0)
+            juce::ConsoleApplication::fail (juce::String (numFailed) + " of " + juce::String ((int) jobs.size()) + " files failed");
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    // The processor's parameters want a message manager, as they do in the tests
+    juce::ScopedJuceInitialiser_GUI gui;
+
+    juce::ConsoleApplication app;
+    app.addVersionCommand ("--version", juce::String (PRODUCT_NAME_WITHOUT_VERSION) + " RiderRender " + VERSION);
+    app.addHelpCommand ("--help|-h", "Renders an audio file through the rider, as fast as the CPU allows.", false);
+
+    app.addDefaultCommand ({ "",
+                             "input -o file [--sidechain=file] [--bpm=120] [--mode=off|vox|space|punch] [--flip] "
+                             "[--shred=1..3] [--chop=threshold] [--ratio=1|3|6|9] [--lookahead] [--block=samples]",
+                             "Renders input to a WAV at its own rate, length and bit depth (-o or --output=file)",
+                             "The transport plays from the top at --bpm (default 120). Mode defaults to vox, ratio to 1, "
+                             "and SHRED and CHOP are off unless given. A --sidechain file switches the guide to EXT. "
+                             "--block sets how many samples go through processBlock at a time (default 8192).",
+                             render });
+
+    app.addCommand ({ "--batch",
+                      "--batch=folder --out-dir=folder [--sidechain-dir=folder] [--jobs=N] [options as above]",
+                      "Renders every audio file under a folder, across all cores",
+                      "Each file goes to the same place under --out-dir, as WAV, and files that would land on the same WAV "
+                      "(take.flac and take.wav) fail without rendering. With --sidechain-dir, each file's guide "
+                      "is the file at the same place under that folder. --jobs sets the number of workers (default one per core).",
+                      renderBatch });
+
+    return app.findAndRunCommand (argc, argv);
+}
@@ -0,0 +1,132 @@
+#include "BatchRenderer.h"
+#include <algorithm>
+#include <map>
+#include <numeric>
+
+namespace
+{
+    int workersFor (int numWorkers)
+    {
+        return numWorkers > 0 ? numWorkers : juce::SystemStats::getNumCpus();
+    }
+}
+
+//==============================================================================
+BatchRenderer::BatchRenderer (int numWorkers)
+    : pool (juce::ThreadPoolOptions {}.withThreadName ("Batch Render").withNumberOfThreads (workersFor (numWorkers)))
+{
+    for (int i = 0; i < workersFor (numWorkers); ++i)
+        workers.push_back (std::make_unique<Worker>());
+}
+
+BatchRenderer::~BatchRenderer()
+{
+    pool.removeAllJobs (true, -1);
+}
+
+bool BatchRenderer::takeJob (size_t self, size_t& job)
+{
+    {
+        auto& own = *workers[self];
+        std::scoped_lock lock (own.queueLock);
+
+        if (! own.queue.empty())
+        {
+            job = own.queue.front();
+            own.queue.pop_front();
+            return true;
+        }
+    }
+
+    // Steal the shortest job someone else has left, so their long ones stay with them
+    for (size_t i = 1; i < workers.size(); ++i)
+    {
+        auto& victim = *workers[(self + i) % workers.size()];
+        std::scoped_lock lock (victim.queueLock);
+
+        if (! victim.queue.empty())
+        {
+            job = victim.queue.back();
+            victim.queue.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::vector<juce::Result> BatchRenderer::render (const std::vector<OfflineRenderer::Job>& jobs,
+                                                 std::atomic<float>* progress, const std::function<bool()>& shouldExit)
+{
+    std::vector<juce::Result> results (jobs.size(), juce::Result::fail ("Cancelled"));
+
+    if (jobs.empty())
+        return results;
+
+    // Jobs that share an output would race each other to write it, so none of them runs
+    std::map<juce::File, int> numWriters;
+
+    for (const auto& job : jobs)
+        ++numWriters[job.output];
+
+    // Input size stands in for length: it's what the work scales with, and it's known without opening anything
+    std::vector<juce::int64> sizes (jobs.size(), 0);
+    std::vector<size_t> longestFirst;
+
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        if (numWriters[jobs[i].output] > 1)
+        {
+            results[i] = juce::Result::fail ("Another file in the batch renders to " + jobs[i].output.getFullPathName());
+            continue;
+        }
+
+        sizes[i] = jobs[i].input.getSize();
+        longestFirst.push_back (i);
+    }
+
+    std::stable_sort (longestFirst.begin(), longestFirst.end(), [&] (size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+    for (size_t i = 0; i < longestFirst.size(); ++i)
+        workers[i % workers.size()]->queue.push_back (longestFirst[i]);
+
+    const auto totalBytes = std::max<juce::int64> (1, std::accumulate (sizes.begin(), sizes.end(), (juce::int64) 0));
+    std::atomic<juce::int64> bytesDone { 0 };
+    std::atomic<bool> cancelled { false };
+    std::atomic<int> numRunning { getNumWorkers() };
+    juce::WaitableEvent allDone;
+
+    for (size_t w = 0; w < workers.size(); ++w)
+    {
+        pool.addJob ([&, w] {
+            size_t job = 0;
+
+            while (! cancelled.load (std::memory_order_relaxed) && takeJob (w, job))
+            {
+                results[job] = workers[w]->renderer.render (jobs[job]);
+                bytesDone.fetch_add (sizes[job], std::memory_order_relaxed);
+            }
+
+            if (numRunning.fetch_sub (1) == 1)
+                allDone.signal();
+        });
+    }
+
+    while (! allDone.wait (20.0))
+    {
+        if (progress != nullptr)
+            progress->store ((float) bytesDone.load() / (float) totalBytes);
+
+        if (shouldExit && shouldExit())
+            cancelled.store (true);
+    }
+
+    // A cancelled batch leaves jobs behind; the next one starts from empty queues
+    for (auto& worker : workers)
+        worker->queue.clear();
+
+    if (progress != nullptr && ! cancelled.load())
+        progress->store (1.0f);
+
+    return results;
+}
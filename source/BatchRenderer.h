@@ -0,0 +1,54 @@
+#pragma once
+
+#include "OfflineRenderer.h"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// ==========================================================
+// THE BATCH RENDERER
+// ==========================================================
+// Renders many files across every core. Each worker owns an OfflineRenderer,
+// so it has its own PluginProcessor, its own buffers and its own I/O thread,
+// and keeps them from one batch to the next.
+//
+// A file can't be split, since the rider's state runs through it from start
+// to finish, so the jobs are balanced instead. They are dealt out to the
+// workers longest first. Each worker takes from the front of its own queue,
+// and when that's empty it steals from the back of someone else's. The long
+// files start straight away, and the short ones fill in around them.
+class BatchRenderer
+{
+public:
+    explicit BatchRenderer (int numWorkers = 0); // 0 = one per core
+    ~BatchRenderer();
+
+    // Renders every job and returns one result per job, in the same order. Blocking.
+    // progress (0..1, by input size) and shouldExit are polled from the calling thread.
+    // Once shouldExit returns true, the files already started finish and the rest fail as cancelled.
+    // Jobs that share an output file all fail without rendering.
+    std::vector<juce::Result> render (const std::vector<OfflineRenderer::Job>& jobs,
+                                      std::atomic<float>* progress = nullptr,
+                                      const std::function<bool()>& shouldExit = {});
+
+    int getNumWorkers() const noexcept { return (int) workers.size(); }
+
+private:
+    struct Worker
+    {
+        OfflineRenderer renderer;
+
+        std::mutex queueLock;
+        std::deque<size_t> queue; // indices into the batch's jobs
+    };
+
+    // The next job for a worker: its own first, then one stolen. False once every queue is empty.
+    bool takeJob (size_t self, size_t& job);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    juce::ThreadPool pool;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BatchRenderer)
+};
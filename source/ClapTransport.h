@@ -0,0 +1,63 @@
+#pragma once
+
+#include "TransportTracker.h"
+#include <clap/events.h>
+#include <clap/fixedpoint.h>
+
+// ==========================================================
+// THE CLAP TRANSPORT
+// ==========================================================
+// The host position as a CLAP host reports it: once with the process call, and
+// again with every transport event inside the block. When the block is split
+// at events, each piece starts from the position the last report implies for
+// its first sample, walking forward at the reported tempo and tempo slope.
+class ClapTransport
+{
+public:
+    // From the transport the host reported at sample `time` of the block (nullptr if it reported none)
+    void set (const clap_event_transport* transport, int time) noexcept
+    {
+        reportedAt = time;
+        reported = {};
+        bpmPerSample = 0.0;
+
+        if (transport == nullptr)
+            return;
+
+        if ((transport->flags & CLAP_TRANSPORT_HAS_TEMPO) != 0)
+        {
+            reported.bpm = transport->tempo;
+            bpmPerSample = transport->tempo_inc;
+        }
+
+        if ((transport->flags & CLAP_TRANSPORT_HAS_BEATS_TIMELINE) != 0)
+        {
+            reported.ppq = (double) transport->song_pos_beats / CLAP_BEATTIME_FACTOR;
+            reported.hasPPQ = true;
+            reported.loopStartPPQ = (double) transport->loop_start_beats / CLAP_BEATTIME_FACTOR;
+        }
+
+        reported.isPlaying = (transport->flags & CLAP_TRANSPORT_IS_PLAYING) != 0;
+        reported.isLooping = (transport->flags & CLAP_TRANSPORT_IS_LOOP_ACTIVE) != 0;
+    }
+
+    // Where the transport is at `time`, a sample at or after the last report
+    TransportTracker::Position at (int time, double sampleRate) const noexcept
+    {
+        auto position = reported;
+        const auto elapsed = (double) (time - reportedAt);
+
+        if (position.isPlaying && elapsed > 0.0 && sampleRate > 0.0)
+        {
+            position.ppq += elapsed * ((reported.bpm + 0.5 * bpmPerSample * elapsed) / 60.0) / sampleRate;
+            position.bpm += bpmPerSample * elapsed;
+        }
+
+        return position;
+    }
+
+private:
+    TransportTracker::Position reported;
+    double bpmPerSample { 0.0 };
+    int reportedAt { 0 };
+};
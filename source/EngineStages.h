@@ -0,0 +1,544 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "FastMath.h"
+#include "GainCurves.h"
+#include "GhostMap.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// ==========================================================
+// THE BLOCK PIPELINE
+// ==========================================================
+// processBlock runs these stages one after the other over whole sub-blocks:
+//
+//   detect -> Ghost IO -> gain computer -> ballistics -> modifiers -> clip
+//
+// Every stage reads and writes contiguous per-channel arrays, so each one can
+// be benchmarked on its own. Only detect, ballistics and SHRED II carry state
+// from sample to sample; the rest are plain element-wise loops the compiler can
+// vectorise. Switches that used to be tested per sample are template
+// parameters here, and processBlock picks the instantiations once per block.
+//
+// When frozen, only replayFrozenGain, SHRED and the clip run: the gain captured
+// on an earlier Ghost read pass is multiplied straight onto the input.
+namespace EngineStages
+{
+    // ==========================================================
+    // STAGE 1: ENVELOPE DETECTION
+    // ==========================================================
+    // Time constants of the RMS and peak followers
+    inline constexpr double rmsFollowerSeconds = 0.010;
+    inline constexpr double peakReleaseSeconds = 0.050;
+
+    struct DetectorState
+    {
+        float envLive { 0.0f };
+        float envGuide { 0.0f };
+        float peakLive { 0.0f };
+        float peakGuide { 0.0f };
+    };
+
+    struct DetectorOutput
+    {
+        float* liveRMS;
+        float* guideRMS;
+        float* peakLive;
+        float* peakGuide;
+    };
+
+    // Scalar reference for one channel; processBlock runs all channels at once through the
+    // SIMD StereoDetector, which falls back to this when SIMD isn't available.
+    // guide == nullptr means the guide is silent (EXT forced without a sidechain)
+    inline void detect (const float* live, const float* guide, int numSamples,
+                        float envCoeff, float peakReleaseCoeff,
+                        DetectorState& state, const DetectorOutput& out) noexcept
+    {
+        auto envLive = state.envLive;
+        auto envGuide = state.envGuide;
+        auto peakLive = state.peakLive;
+        auto peakGuide = state.peakGuide;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float liveSample = live[i];
+            const float guideSample = (guide != nullptr) ? guide[i] : 0.0f;
+
+            envLive = envCoeff * envLive + (1.0f - envCoeff) * (liveSample * liveSample);
+            envGuide = envCoeff * envGuide + (1.0f - envCoeff) * (guideSample * guideSample);
+            peakLive = std::max (std::abs (liveSample), peakLive * peakReleaseCoeff);
+            peakGuide = std::max (std::abs (guideSample), peakGuide * peakReleaseCoeff);
+
+            out.liveRMS[i] = envLive;
+            out.guideRMS[i] = envGuide;
+            out.peakLive[i] = peakLive;
+            out.peakGuide[i] = peakGuide;
+        }
+
+        state = { envLive, envGuide, peakLive, peakGuide };
+
+        // The square roots don't feed back into the recursion, so they run as a separate pass
+        for (int i = 0; i < numSamples; ++i)
+        {
+            out.liveRMS[i] = std::sqrt (out.liveRMS[i]);
+            out.guideRMS[i] = std::sqrt (out.guideRMS[i]);
+        }
+    }
+
+    // ==========================================================
+    // STAGE 2: GHOST IO
+    // ==========================================================
+    // Maps block sample positions onto the Ghost index grid. While the tempo ramps, the
+    // quarters per sample change linearly across the block, so the position is interpolated
+    // per sample rather than stepped once per playhead update.
+    struct GhostClock
+    {
+        double startPPQ { 0.0 };
+        double ppqPerSample { 0.0 };
+        double ppqPerSampleRamp { 0.0 }; // change in ppqPerSample per sample
+        double ppqResolution { 0.0 };
+
+        double ppqAt (int sample) const noexcept { return startPPQ + (sample * (ppqPerSample + 0.5 * sample * ppqPerSampleRamp)); }
+
+        static int indexFor (double exactIndex) noexcept
+        {
+            return (exactIndex < (double) (std::numeric_limits<int>::max() - 1)) ? (int) exactIndex : -1;
+        }
+    };
+
+    // Phase-Locked Capture: writes only ONCE on each index boundary, bridging small gaps. With
+    // an index about a millisecond long, gaps only open up where one block's position doesn't
+    // quite meet the next's.
+    // Returns the PPQ of the last index written, or -1 if nothing was written.
+    // Also captures the fader for freeze, with the fader in place of the guide level.
+    inline double recordGhost (GhostMap& map, int channel, const float* guideRMS,
+                               int firstSample, int numSamples, const GhostClock& clock,
+                               int& lastWrittenIdx) noexcept
+    {
+        double lastPPQ = -1.0;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto samplePPQ = clock.ppqAt (firstSample + i);
+            const auto arrayIdx = GhostClock::indexFor (samplePPQ * clock.ppqResolution);
+
+            if (! GhostMap::isValidIndex (arrayIdx) || arrayIdx == lastWrittenIdx)
+                continue;
+
+            if (lastWrittenIdx >= 0 && arrayIdx > lastWrittenIdx + 1 && arrayIdx - lastWrittenIdx < 50)
+                for (int fill = lastWrittenIdx + 1; fill < arrayIdx; ++fill)
+                    map.write (channel, fill, guideRMS[i]);
+
+            map.write (channel, arrayIdx, guideRMS[i]);
+            lastWrittenIdx = arrayIdx;
+            lastPPQ = samplePPQ;
+        }
+
+        return lastPPQ;
+    }
+
+    namespace detail
+    {
+        // Writes the log2 level interpolated between the two indices around each sample, and
+        // 1/0 into present depending on whether both had data. Returns the last sample that did,
+        // or -1. The map holds log2 codes, so this is a straight line in dB.
+        inline int interpolateLog2 (const GhostMap& map, int channel, int firstSample, int numSamples,
+                                    const GhostClock& clock, float* log2Level, float* present) noexcept
+        {
+            int lastPresent = -1;
+
+            // An index spans dozens of samples, so the map is only looked up when it changes
+            int segmentIdx = -1;
+            bool segmentPresent = false;
+            float segmentStart = 0.0f, segmentDelta = 0.0f;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto exactIndex = clock.ppqAt (firstSample + i) * clock.ppqResolution;
+                const auto arrayIdx = GhostClock::indexFor (exactIndex);
+
+                log2Level[i] = 0.0f;
+                present[i] = 0.0f;
+
+                if (! GhostMap::isValidIndex (arrayIdx))
+                    continue;
+
+                if (arrayIdx != segmentIdx)
+                {
+                    const auto code1 = map.readCode (channel, arrayIdx);
+                    const auto code2 = map.readCode (channel, arrayIdx + 1);
+
+                    segmentIdx = arrayIdx;
+                    segmentPresent = code1 != GhostCodec::noDataCode && code2 != GhostCodec::noDataCode;
+                    segmentStart = GhostCodec::toLog2 (code1);
+                    segmentDelta = GhostCodec::toLog2 (code2) - segmentStart;
+                }
+
+                if (segmentPresent)
+                {
+                    const float fraction = (float) (exactIndex - (double) arrayIdx);
+
+                    log2Level[i] = segmentStart + fraction * segmentDelta;
+                    present[i] = 1.0f;
+                    lastPresent = i;
+                }
+            }
+
+            return lastPresent;
+        }
+    }
+
+    // Sliding extreme over windowSize consecutive codes (van Herk / Gil-Werman): out[j] is the
+    // max (or min) of in[j .. j + windowSize - 1], for j in [0, count - windowSize]. Three
+    // comparisons per code whatever the window size; the final pass vectorises.
+    template <bool Max>
+    void slidingExtreme (const std::uint16_t* in, int count, int windowSize,
+                         std::uint16_t* prefix, std::uint16_t* suffix, std::uint16_t* out) noexcept
+    {
+        const auto pick = [] (std::uint16_t a, std::uint16_t b) noexcept { return Max ? std::max (a, b) : std::min (a, b); };
+
+        for (int blockStart = 0; blockStart < count; blockStart += windowSize)
+        {
+            const int blockEnd = std::min (blockStart + windowSize, count);
+
+            prefix[blockStart] = in[blockStart];
+            for (int j = blockStart + 1; j < blockEnd; ++j)
+                prefix[j] = pick (prefix[j - 1], in[j]);
+
+            suffix[blockEnd - 1] = in[blockEnd - 1];
+            for (int j = blockEnd - 2; j >= blockStart; --j)
+                suffix[j] = pick (suffix[j + 1], in[j]);
+        }
+
+        for (int j = 0; j <= count - windowSize; ++j)
+            out[j] = pick (suffix[j], prefix[j + windowSize - 1]);
+    }
+
+    // Zero-latency lookahead for Ghost replay: the map already knows the level at every future
+    // index, so each sample's target is pulled towards the extreme of the next windowIndices
+    // indices. The fader then starts moving one attack time early and lands on a level change
+    // as it happens, with no delay line and no reported latency. The window extreme follows the
+    // fader's fast direction: the minimum where it attacks downwards, the maximum for PUNCH.
+    struct GhostLookahead
+    {
+        static constexpr int maxWindowIndices = 255;
+        static constexpr int capacity = 1024; // indices looked at per run of samples
+
+        int windowIndices { 0 }; // 0 = off
+        bool towardsMax { false };
+
+        // Applies the lookahead to log2 targets from interpolateLog2(), where present
+        void apply (const GhostMap& map, int channel, int firstSample, int numSamples,
+                    const GhostClock& clock, float* log2Target, const float* present) noexcept
+        {
+            if (windowIndices <= 0)
+                return;
+
+            const int window = std::min (windowIndices, maxWindowIndices);
+
+            // Samples are handled in runs whose indices, plus the window, fit in the scratch
+            for (int i = 0; i < numSamples;)
+            {
+                const auto runStart = GhostClock::indexFor (clock.ppqAt (firstSample + i) * clock.ppqResolution);
+
+                if (! GhostMap::isValidIndex (runStart))
+                {
+                    ++i;
+                    continue;
+                }
+
+                int runEnd = i, lastIndex = runStart;
+
+                for (; runEnd < numSamples; ++runEnd)
+                {
+                    const auto index = GhostClock::indexFor (clock.ppqAt (firstSample + runEnd) * clock.ppqResolution);
+
+                    if (index < runStart || index - runStart + window + 1 > capacity)
+                        break;
+
+                    lastIndex = index;
+                }
+
+                // Sample at index k looks at indices k + 1 .. k + window
+                const int numWindows = lastIndex - runStart + 1;
+                const int count = numWindows + window - 1;
+
+                for (int k = 0; k < count; ++k)
+                {
+                    const auto code = map.readCode (channel, runStart + 1 + k);
+                    codes[k] = (code == GhostCodec::noDataCode && ! towardsMax) ? noDataForMin : code;
+                }
+
+                if (towardsMax)
+                    slidingExtreme<true> (codes, count, window, prefix, suffix, extremes);
+                else
+                    slidingExtreme<false> (codes, count, window, prefix, suffix, extremes);
+
+                for (; i < runEnd; ++i)
+                {
+                    if (present[i] <= 0.0f)
+                        continue;
+
+                    const auto index = GhostClock::indexFor (clock.ppqAt (firstSample + i) * clock.ppqResolution);
+                    const auto ahead = extremes[index - runStart];
+
+                    if (ahead == GhostCodec::noDataCode || ahead == noDataForMin)
+                        continue;
+
+                    const auto aheadLog2 = GhostCodec::toLog2 (ahead);
+                    log2Target[i] = towardsMax ? std::max (log2Target[i], aheadLog2) : std::min (log2Target[i], aheadLog2);
+                }
+            }
+        }
+
+    private:
+        // For the minimum, missing indices must lose every comparison
+        static constexpr std::uint16_t noDataForMin = 0xffff;
+
+        std::uint16_t codes[capacity];
+        std::uint16_t prefix[capacity];
+        std::uint16_t suffix[capacity];
+        std::uint16_t extremes[capacity];
+    };
+
+    // Fills target with the interpolated Ghost level and present with 1/0 depending on whether
+    // the map had data there. Where it didn't, target falls back to the live guide level.
+    // Returns the last target found, or -1 if the map had nothing for this block.
+    //
+    // The lookup pass stays scalar; the exp2 back to linear runs as a separate, vectorisable
+    // pass over the block.
+    inline float replayGhost (const GhostMap& map, int channel, const float* guideRMS,
+                              int firstSample, int numSamples, const GhostClock& clock,
+                              float* target, float* present, GhostLookahead* lookahead = nullptr) noexcept
+    {
+        const auto lastPresent = detail::interpolateLog2 (map, channel, firstSample, numSamples, clock, target, present);
+
+        if (lookahead != nullptr)
+            lookahead->apply (map, channel, firstSample, numSamples, clock, target, present);
+
+        for (int i = 0; i < numSamples; ++i)
+            target[i] = present[i] > 0.0f ? FastMath::exp2 (target[i]) : guideRMS[i];
+
+        return lastPresent >= 0 ? target[lastPresent] : -1.0f;
+    }
+
+    // Freeze: fills gain with the fader captured at this position, unity where nothing was
+    // captured. present is scratch.
+    inline void replayFrozenGain (const GhostMap& map, int channel, int firstSample, int numSamples,
+                                  const GhostClock& clock, float* gain, float* present) noexcept
+    {
+        detail::interpolateLog2 (map, channel, firstSample, numSamples, clock, gain, present);
+
+        for (int i = 0; i < numSamples; ++i)
+            gain[i] = present[i] > 0.0f ? FastMath::exp2 (gain[i]) : 1.0f;
+    }
+
+    // ==========================================================
+    // STAGE 3: GAIN COMPUTER (stateless)
+    // ==========================================================
+    struct GainComputerInput
+    {
+        const float* target;
+        const float* liveRMS;
+        const float* peakLive;
+        const float* peakGuide;
+        const float* ghostPresent; // only read when replaying a Ghost
+    };
+
+    template <int Mode, bool Replay>
+    void computeGain (const GainComputerInput& in, int ratio, float* gain, int numSamples) noexcept
+    {
+        [[maybe_unused]] const auto mode2Curve = GainCurves::Mode2Curve::forRatio (ratio);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float targetRMS = in.target[i];
+            const float currentLiveRMS = in.liveRMS[i];
+            float targetGain = 1.0f;
+
+            if (currentLiveRMS >= 0.00001f)
+            {
+                if (targetRMS < 0.00001f)
+                {
+                    targetGain = 0.0f;
+                }
+                else
+                {
+                    float desiredLevel = targetRMS;
+
+                    if constexpr (Mode == 2)
+                    {
+                        if (desiredLevel < GainCurves::threshX)
+                            desiredLevel = mode2Curve.apply (desiredLevel);
+                    }
+
+                    targetGain = desiredLevel / currentLiveRMS;
+
+                    if constexpr (Mode == 1)
+                    {
+                        if (ratio > 1)
+                            targetGain = GainCurves::ratioPower (targetGain, ratio);
+                    }
+
+                    if constexpr (Mode == 3)
+                    {
+                        const float peakGuide = in.peakGuide[i];
+                        float dryCrest = peakGuide / (targetRMS + 0.00001f);
+                        float inCrest = in.peakLive[i] / (currentLiveRMS + 0.00001f);
+                        float loudComp = 1.0f + (1.0f - juce::jmin (1.0f, peakGuide));
+
+                        if (dryCrest > inCrest + 0.05f)
+                            targetGain *= ((dryCrest / inCrest) * loudComp * 0.8f);
+                        else if (std::abs (dryCrest - inCrest) <= 0.05f && dryCrest > 2.0f)
+                            targetGain *= std::min (1.0f + (0.09f * ratio * dryCrest * loudComp), 3.0f);
+                    }
+
+                    targetGain = std::clamp (targetGain, 0.0f, 32.0f);
+
+                    if constexpr (Mode == 2)
+                    {
+                        if (currentLiveRMS >= 0.25f)
+                            targetGain = 1.0f;
+                    }
+                }
+            }
+
+            // With no Ghost data under the playhead the fader closes
+            if constexpr (Replay)
+                targetGain *= in.ghostPresent[i];
+
+            gain[i] = targetGain;
+        }
+    }
+
+    // ==========================================================
+    // STAGE 4: FADER BALLISTICS
+    // ==========================================================
+    // PUNCH attacks upwards (fast when opening), the other modes attack downwards.
+    template <bool FastOnRise>
+    void applyBallistics (const float* targetGain, float* fader, int numSamples,
+                          float attackCoeff, float releaseCoeff, float& state, bool snapFirst) noexcept
+    {
+        auto current = state;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float target = targetGain[i];
+
+            if (snapFirst && i == 0)
+            {
+                current = target;
+            }
+            else
+            {
+                const bool useFast = FastOnRise ? (target > current) : (target < current);
+                current += (useFast ? attackCoeff : releaseCoeff) * (target - current);
+            }
+
+            fader[i] = current;
+        }
+
+        state = current;
+    }
+
+    // ==========================================================
+    // STAGE 5: MODIFIERS (FLIP / SHRED / CHOP)
+    // ==========================================================
+    struct ShredState
+    {
+        float heldSample { 0.0f };
+        int holdCounter { 0 };
+    };
+
+    struct ModifierInput
+    {
+        const float* live;
+        const float* fader;
+        const float* target;
+        const float* peakGuide;
+    };
+
+    // The gain FLIP applies for a fader value: the fader's inverse, floored so it never boosts past 20 dB
+    inline void flipGain (const float* fader, float* gain, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+            gain[i] = 1.0f / std::max (fader[i], 0.1f);
+    }
+
+    template <bool Flip, int Shred, bool Chop>
+    void applyModifiers (const ModifierInput& in, float* wet, int numSamples,
+                         float chopThresh, int holdTarget, ShredState& shred) noexcept
+    {
+        if constexpr (Flip)
+        {
+            for (int i = 0; i < numSamples; ++i)
+                wet[i] = in.live[i] * (1.0f / std::max (in.fader[i], 0.1f));
+        }
+        else
+        {
+            juce::FloatVectorOperations::multiply (wet, in.live, in.fader, numSamples);
+        }
+
+        if constexpr (Shred == 1)
+        {
+            for (int i = 0; i < numSamples; ++i)
+                wet[i] = (wet[i] * 0.5f) + (std::sin (wet[i] * 25.0f) * 0.25f);
+        }
+        else if constexpr (Shred == 2)
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                float outSample = wet[i];
+
+                if (shred.holdCounter >= holdTarget)
+                {
+                    shred.heldSample = outSample;
+                    shred.holdCounter = 0;
+                }
+                else
+                {
+                    outSample = shred.heldSample;
+                    shred.holdCounter++;
+                }
+
+                float fatDry = FastMath::tanh (in.live[i] * 2.0f) * 0.5f;
+                wet[i] = fatDry + (outSample * 0.8f);
+            }
+        }
+        else if constexpr (Shred == 3)
+        {
+            for (int i = 0; i < numSamples; ++i)
+                wet[i] = FastMath::tanh (wet[i] * 50.0f) * 0.3f;
+        }
+        else
+        {
+            // Keeps SHRED II seamless when it gets switched on
+            if (numSamples > 0)
+                shred = { wet[numSamples - 1], 0 };
+        }
+
+        if constexpr (Chop)
+        {
+            for (int i = 0; i < numSamples; ++i)
+                wet[i] = (in.target[i] < (in.peakGuide[i] * chopThresh)) ? 0.0f : wet[i];
+        }
+    }
+
+    // ==========================================================
+    // STAGE 6: OUTPUT CLIP (stateless)
+    // ==========================================================
+    template <bool SoftClip>
+    void clipOutput (const float* wet, float* out, int numSamples) noexcept
+    {
+        if constexpr (SoftClip)
+        {
+            for (int i = 0; i < numSamples; ++i)
+                out[i] = FastMath::tanh (wet[i] * 1.05f);
+        }
+        else
+        {
+            juce::FloatVectorOperations::clip (out, wet, -1.0f, 1.0f, numSamples);
+        }
+    }
+}
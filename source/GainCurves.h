@@ -0,0 +1,152 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "FastMath.h"
+#include <array>
+
+// ==========================================================
+// THE GAIN CURVES
+// ==========================================================
+// The ratio buttons only ever give 1:1, 3:1, 6:1 or 9:1, so the curves that
+// depend on the ratio are fixed ahead of time instead of being worked out with
+// pow() per sample:
+//
+//   mode 1  gain^ratio (the old 10^(ratio * dB / 20)), an exact integer power
+//   mode 2  the level curve, as a constexpr multiplier table per ratio,
+//           read with linear interpolation
+//
+// Any other ratio falls back to FastMath.
+namespace GainCurves
+{
+    // ==========================================================
+    // MODE 1: RATIO SCALING
+    // ==========================================================
+    inline float ratioPower (float gain, int ratio) noexcept
+    {
+        switch (ratio)
+        {
+            case 1: return gain;
+            case 3: return gain * gain * gain;
+            case 6: { const auto cubed = gain * gain * gain; return cubed * cubed; }
+            case 9: { const auto cubed = gain * gain * gain; return cubed * cubed * cubed; }
+            default: return FastMath::pow (gain, (float) ratio);
+        }
+    }
+
+    // ==========================================================
+    // MODE 2: LEVEL CURVE
+    // ==========================================================
+    // Between threshY and threshX the curve is threshX * (level / threshX)^e, e = 1/ratio
+    // (1/2 at 1:1). The table holds that as a multiplier, (level / threshX)^(e - 1), which
+    // is far smoother to interpolate than the curve itself. Below threshY the curve fades
+    // in as level * (1 + (maxMult - 1) * level / threshY), which is computed directly.
+    inline constexpr float threshX = 0.25f;
+    inline constexpr float threshY = 0.01f;
+    inline constexpr int tableSize = 1024; // segments; worst interpolation error ~0.001 dB at 9:1
+
+    using Mode2Table = std::array<float, tableSize + 1>;
+
+    namespace detail
+    {
+        // Just enough constexpr maths to build the tables at compile time
+        constexpr double ln (double x)
+        {
+            int exponent = 0;
+            while (x >= 1.0) { x *= 0.5; ++exponent; }
+            while (x < 0.5) { x *= 2.0; --exponent; }
+
+            const auto t = (x - 1.0) / (x + 1.0);
+            double sum = 0.0, power = t;
+
+            for (int k = 1; k < 60; k += 2, power *= t * t)
+                sum += power / k;
+
+            return 2.0 * sum + exponent * 0.69314718055994530942;
+        }
+
+        constexpr double exp (double x)
+        {
+            // e^x = (e^(x / 1024))^1024, with a short Taylor series for the small argument
+            const auto small = x / 1024.0;
+            double sum = 1.0, term = 1.0;
+
+            for (int k = 1; k < 16; ++k)
+            {
+                term *= small / k;
+                sum += term;
+            }
+
+            for (int i = 0; i < 10; ++i)
+                sum *= sum;
+
+            return sum;
+        }
+
+        constexpr double pow (double x, double y) { return exp (y * ln (x)); }
+
+        constexpr double exponentFor (int ratio) { return ratio == 1 ? 0.5 : 1.0 / ratio; }
+
+        constexpr Mode2Table makeMode2Table (int ratio)
+        {
+            Mode2Table table {};
+            const auto e = exponentFor (ratio);
+
+            for (int i = 0; i <= tableSize; ++i)
+            {
+                const auto level = (double) threshY + (double) (threshX - threshY) * i / tableSize;
+                table[(size_t) i] = (float) pow (level / threshX, e - 1.0);
+            }
+
+            return table;
+        }
+
+        constexpr float maxMultFor (int ratio) { return (float) pow ((double) threshX / threshY, exponentFor (ratio)); }
+    }
+
+    inline constexpr Mode2Table mode2Table1 = detail::makeMode2Table (1);
+    inline constexpr Mode2Table mode2Table3 = detail::makeMode2Table (3);
+    inline constexpr Mode2Table mode2Table6 = detail::makeMode2Table (6);
+    inline constexpr Mode2Table mode2Table9 = detail::makeMode2Table (9);
+
+    // Resolved once per block from the ratio
+    struct Mode2Curve
+    {
+        const Mode2Table* table { nullptr }; // nullptr for ratios without a table
+        float maxMult { 1.0f };
+        float exponent { 0.5f };
+
+        static Mode2Curve forRatio (int ratio) noexcept
+        {
+            switch (ratio)
+            {
+                case 1: return { &mode2Table1, detail::maxMultFor (1), 0.5f };
+                case 3: return { &mode2Table3, detail::maxMultFor (3), 1.0f / 3.0f };
+                case 6: return { &mode2Table6, detail::maxMultFor (6), 1.0f / 6.0f };
+                case 9: return { &mode2Table9, detail::maxMultFor (9), 1.0f / 9.0f };
+                default: break;
+            }
+
+            const auto exponent = 1.0f / (float) juce::jmax (1, ratio);
+            return { nullptr, FastMath::pow (threshX / threshY, exponent), exponent };
+        }
+
+        // The curved level for 0 < level < threshX
+        float apply (float level) const noexcept
+        {
+            if (level <= threshY)
+                return level * (1.0f + ((maxMult - 1.0f) * (level / threshY)));
+
+            if (table == nullptr)
+                return threshX * FastMath::pow (level / threshX, exponent);
+
+            constexpr float scale = (float) tableSize / (threshX - threshY);
+
+            const auto position = (level - threshY) * scale;
+            const auto index = juce::jmin ((int) position, tableSize - 1);
+            const auto fraction = position - (float) index;
+            const auto lower = (*table)[(size_t) index];
+
+            return level * (lower + fraction * ((*table)[(size_t) index + 1] - lower));
+        }
+    };
+}
@@ -0,0 +1,309 @@
+#include "GhostBackingStore.h"
+
+#if JUCE_WINDOWS
+ #include <windows.h>
+#else
+ #include <cerrno>
+ #include <fcntl.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+    // Windows maps views from multiples of its 64 KiB allocation granularity (JUCE rounds the start
+    // down to one), so every segment has to start on one or its pages would land early
+    constexpr size_t segmentAlignment = 65536;
+
+    constexpr char zeros[65536] {};
+
+    // Extends the file over [start, end) with real, zeroed disk space. Filling it up front means a full
+    // disk shows up here as a failure, rather than as a SIGBUS when a page is first touched. The handle
+    // shares reading, writing and deletion, as the segments already mapped from the file do.
+    bool preallocate (const juce::File& file, juce::int64 start, juce::int64 end)
+    {
+       #if JUCE_WINDOWS
+        auto handle = CreateFileW (file.getFullPathName().toWideCharPointer(), GENERIC_READ | GENERIC_WRITE,
+                                   FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                   OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+        if (handle == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER position;
+        position.QuadPart = start;
+        bool ok = SetFilePointerEx (handle, position, nullptr, FILE_BEGIN) != 0;
+
+        for (auto remaining = end - start; ok && remaining > 0;)
+        {
+            const auto n = (DWORD) juce::jmin<juce::int64> (remaining, (juce::int64) sizeof (zeros));
+            DWORD written = 0;
+            ok = WriteFile (handle, zeros, n, &written, nullptr) != 0 && written == n;
+            remaining -= n;
+        }
+
+        CloseHandle (handle);
+        return ok;
+       #else
+        const auto fd = open (file.getFullPathName().toRawUTF8(), O_CREAT | O_RDWR, 0644);
+
+        if (fd == -1)
+            return false;
+
+        bool ok = false;
+
+       #if JUCE_LINUX || JUCE_BSD
+        const auto allocated = posix_fallocate (fd, (off_t) start, (off_t) (end - start));
+        ok = allocated == 0;
+
+        // Only a file system that can't preallocate falls through to writing the zeros out
+        if (allocated != EINVAL && allocated != EOPNOTSUPP)
+        {
+            close (fd);
+            return ok;
+        }
+       #endif
+
+        ok = true;
+
+        for (auto position = start; ok && position < end;)
+        {
+            const auto n = (size_t) juce::jmin<juce::int64> (end - position, (juce::int64) sizeof (zeros));
+            const auto written = pwrite (fd, zeros, n, (off_t) position);
+            ok = written == (ssize_t) n;
+            position += (juce::int64) n;
+        }
+
+        close (fd);
+        return ok;
+       #endif
+    }
+}
+
+GhostBackingStore::GhostBackingStore (const juce::File& fileToUse, size_t slotSizeBytes, int slotsPerSegmentToUse)
+    : file (fileToUse),
+      slotBytes ((slotSizeBytes + 63) & ~(size_t) 63),
+      slotsPerSegment (juce::jmax (1, slotsPerSegmentToUse)),
+      segmentBytes ((slotBytes * (size_t) slotsPerSegment + segmentAlignment - 1) / segmentAlignment * segmentAlignment)
+{
+    file.deleteFile();
+}
+
+GhostBackingStore::~GhostBackingStore()
+{
+    segments.clear();
+    file.deleteFile();
+}
+
+bool GhostBackingStore::addSegment()
+{
+    const auto start = (juce::int64) (segments.size() * segmentBytes);
+    const auto end = start + (juce::int64) segmentBytes;
+
+    if (! file.getParentDirectory().createDirectory())
+        return false;
+
+    if (! preallocate (file, start, end))
+        return false;
+
+    auto segment = std::make_unique<juce::MemoryMappedFile> (file, juce::Range<juce::int64> (start, end),
+                                                             juce::MemoryMappedFile::readWrite, false);
+
+    if (segment->getData() == nullptr || segment->getSize() < segmentBytes)
+        return false;
+
+    segments.push_back (std::move (segment));
+    return true;
+}
+
+void* GhostBackingStore::allocateSlot()
+{
+    const auto segment = (size_t) (numSlotsUsed / slotsPerSegment);
+
+    if (segment >= segments.size() && ! addSegment())
+        return nullptr;
+
+    auto* base = static_cast<char*> (segments[segment]->getData());
+    return base + (size_t) (numSlotsUsed++ % slotsPerSegment) * slotBytes;
+}
+
+bool GhostBackingStore::contains (const void* address) const noexcept
+{
+    for (auto& segment : segments)
+    {
+        auto* base = static_cast<const char*> (segment->getData());
+
+        if (address >= base && address < base + segmentBytes)
+            return true;
+    }
+
+    return false;
+}
+
+//==============================================================================
+namespace
+{
+   #if JUCE_WINDOWS
+    using LockHandle = HANDLE;
+    const LockHandle noLock = INVALID_HANDLE_VALUE;
+   #else
+    using LockHandle = int;
+    constexpr LockHandle noLock = -1;
+   #endif
+
+    const juce::String sessionPrefix ("Session-");
+    const juce::String lockSuffix (".lock");
+    const juce::String backingFilePattern ("*.ghostpages");
+
+    // Takes the lock file for this process without waiting, creating it if need be. Fails while
+    // another process holds it; on Windows the file goes when the handle closes, crash or not.
+    LockHandle tryLock (const juce::File& lockFile)
+    {
+       #if JUCE_WINDOWS
+        return CreateFileW (lockFile.getFullPathName().toWideCharPointer(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+                            OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+       #else
+        const auto fd = open (lockFile.getFullPathName().toRawUTF8(), O_CREAT | O_RDWR, 0644);
+
+        if (fd == -1)
+            return noLock;
+
+        struct flock fl {};
+        fl.l_type = F_WRLCK;
+        fl.l_whence = SEEK_SET;
+
+        if (fcntl (fd, F_SETLK, &fl) == -1)
+        {
+            close (fd);
+            return noLock;
+        }
+
+        return fd;
+       #endif
+    }
+
+    // Deletes the lock file, then lets go of it
+    void unlock (LockHandle handle, const juce::File& lockFile)
+    {
+       #if JUCE_WINDOWS
+        juce::ignoreUnused (lockFile);
+        CloseHandle (handle);
+       #else
+        lockFile.deleteFile();
+        close (handle);
+       #endif
+    }
+}
+
+struct GhostScratchFolders::Folder
+{
+    juce::File directory, path, lockFile;
+    LockHandle handle;
+};
+
+GhostScratchFolders::GhostScratchFolders()
+    : folderName (sessionPrefix + juce::Uuid().toString())
+{
+    const auto defaultDirectory = getDefaultDirectory();
+
+    if (defaultDirectory.isDirectory())
+        sweep (defaultDirectory);
+}
+
+GhostScratchFolders::~GhostScratchFolders()
+{
+    // A folder something still has files in stays, and the next sweep takes it
+    for (auto& folder : folders)
+    {
+        folder->path.deleteFile();
+        unlock (folder->handle, folder->lockFile);
+    }
+}
+
+juce::File GhostScratchFolders::getDefaultDirectory()
+{
+    return juce::File::getSpecialLocation (juce::File::tempDirectory).getChildFile (juce::String (JucePlugin_Name) + " Ghosts");
+}
+
+juce::File GhostScratchFolders::createFileIn (const juce::File& directory, const juce::String& prefix)
+{
+    const juce::ScopedLock sl (lock);
+
+    if (auto* folder = folderIn (directory))
+        return folder->path.getChildFile (prefix + "-" + juce::Uuid().toString() + backingFilePattern.substring (1));
+
+    return {};
+}
+
+GhostScratchFolders::Folder* GhostScratchFolders::folderIn (const juce::File& directory)
+{
+    for (auto& folder : folders)
+        if (folder->directory == directory)
+            return folder.get();
+
+    if (! directory.createDirectory())
+        return nullptr;
+
+    sweep (directory);
+
+    // The lock comes before the folder, so a sweep never finds a live folder without one
+    auto folder = std::make_unique<Folder>();
+    folder->directory = directory;
+    folder->path = directory.getChildFile (folderName);
+    folder->lockFile = directory.getChildFile (folderName + lockSuffix);
+    folder->handle = tryLock (folder->lockFile);
+
+    if (folder->handle == noLock)
+        return nullptr;
+
+    if (! folder->path.createDirectory())
+    {
+        unlock (folder->handle, folder->lockFile);
+        return nullptr;
+    }
+
+    folders.push_back (std::move (folder));
+    return folders.back().get();
+}
+
+int GhostScratchFolders::sweep (const juce::File& directory)
+{
+    int removed = 0;
+
+    // Taking a folder's lock means its owner is gone. Hold it while the folder goes, so nobody
+    // else sweeping at the same moment sees a half-deleted one as theirs.
+    for (auto& path : directory.findChildFiles (juce::File::findDirectories, false, sessionPrefix + "*"))
+    {
+        if (path.getFileName() == folderName)
+            continue;
+
+        const auto lockFile = path.getSiblingFile (path.getFileName() + lockSuffix);
+        const auto handle = tryLock (lockFile);
+
+        if (handle == noLock)
+            continue;
+
+        if (path.deleteRecursively())
+            ++removed;
+
+        unlock (handle, lockFile);
+    }
+
+    // A lock file whose folder never got made
+    for (auto& lockFile : directory.findChildFiles (juce::File::findFiles, false, sessionPrefix + "*" + lockSuffix))
+    {
+        if (lockFile.getFileNameWithoutExtension() == folderName || lockFile.withFileExtension ({}).isDirectory())
+            continue;
+
+        const auto handle = tryLock (lockFile);
+
+        if (handle != noLock)
+            unlock (handle, lockFile);
+    }
+
+    // Files from before the session folders
+    for (auto& file : directory.findChildFiles (juce::File::findFiles, false, backingFilePattern))
+        if (file.deleteFile())
+            ++removed;
+
+    return removed;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <memory>
+#include <vector>
+
+// ==========================================================
+// THE GHOST BACKING STORE
+// ==========================================================
+// A scratch file that GhostMap pages can live in instead of the heap, for
+// programs long enough that keeping every page in RAM would hurt. The file
+// grows a segment at a time, and each segment is a juce::MemoryMappedFile,
+// so pages are plain memory to the audio thread while the OS is free to
+// write them back and drop them under memory pressure. The GhostPager keeps
+// the pages around the playhead faulted in (see GhostMap::servicePages).
+//
+// Slots are handed out in allocation order, whatever the page numbers, so a
+// sparse timeline still makes a dense file. Segments are whole multiples of
+// 64 KiB, so each one maps from exactly where it starts on every platform.
+// Each segment's disk space is allocated as it's added, zero-filled, which is
+// GhostCodec's "no data": a full disk fails allocateSlot() rather than the
+// first touch of a page. The file is deleted with the store.
+//
+// Only ever touched by the pager or the message thread, under the map's
+// allocation lock.
+class GhostBackingStore
+{
+public:
+    GhostBackingStore (const juce::File& fileToUse, size_t slotSizeBytes, int slotsPerSegment = 256);
+    ~GhostBackingStore();
+
+    // The next free slot, zero-filled, or nullptr if the file can't grow
+    void* allocateSlot();
+
+    bool contains (const void* address) const noexcept;
+
+    const juce::File& getFile() const noexcept { return file; }
+    size_t getFileSize() const noexcept { return segments.size() * segmentBytes; }
+
+private:
+    bool addSegment();
+
+    juce::File file;
+    size_t slotBytes;
+    int slotsPerSegment;
+    size_t segmentBytes;
+
+    std::vector<std::unique_ptr<juce::MemoryMappedFile>> segments;
+    int numSlotsUsed { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GhostBackingStore)
+};
+
+// ==========================================================
+// THE GHOST SCRATCH FOLDERS
+// ==========================================================
+// Backing files go in a folder of the process's own inside a scratch
+// directory, next to a lock file the process keeps locked while it's there.
+// The first time a process uses a scratch directory, it deletes every folder
+// in it whose lock nobody holds: what a crashed host left behind. A folder is
+// removed when the process lets go of it, once its stores have deleted their
+// files. One per process, through a SharedResourcePointer.
+class GhostScratchFolders
+{
+public:
+    GhostScratchFolders();
+    ~GhostScratchFolders();
+
+    // Where Ghost pages go when nothing better is known: a folder in the temp directory. Swept
+    // when the first GhostScratchFolders in a process is made, whether or not anything uses it.
+    static juce::File getDefaultDirectory();
+
+    // A new backing file name in this process's folder in directory, or an empty File if the
+    // folder can't be made
+    juce::File createFileIn (const juce::File& directory, const juce::String& prefix);
+
+    // Deletes the folders in directory no live process holds, except this process's own, and any
+    // loose backing files. Returns how many went.
+    int sweep (const juce::File& directory);
+
+private:
+    struct Folder;
+
+    Folder* folderIn (const juce::File& directory);
+
+    const juce::String folderName;
+    std::vector<std::unique_ptr<Folder>> folders;
+    juce::CriticalSection lock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GhostScratchFolders)
+};
@@ -0,0 +1,135 @@
+#include "GhostCodec.h"
+
+namespace
+{
+    void writeVarint (juce::MemoryOutputStream& out, std::uint32_t value)
+    {
+        while (value >= 0x80u)
+        {
+            out.writeByte ((char) (value | 0x80u));
+            value >>= 7;
+        }
+
+        out.writeByte ((char) value);
+    }
+
+    bool readVarint (juce::MemoryInputStream& in, std::uint32_t& value)
+    {
+        value = 0;
+
+        for (int shift = 0; shift < 35; shift += 7)
+        {
+            if (in.isExhausted())
+                return false;
+
+            const auto byte = (std::uint8_t) in.readByte();
+            value |= (std::uint32_t) (byte & 0x7fu) << shift;
+
+            if ((byte & 0x80u) == 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    std::uint32_t zigZag (int delta) noexcept { return (std::uint32_t) ((delta << 1) ^ (delta >> 31)); }
+    int unZigZag (std::uint32_t value) noexcept { return (int) (value >> 1) ^ -(int) (value & 1u); }
+}
+
+bool GhostCodec::encodePage (int pageNumber, const std::uint16_t* const* codes, int numChannels, int pageSize,
+                             juce::MemoryOutputStream& out)
+{
+    juce::MemoryOutputStream payload;
+    bool hasData = false;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const auto* channel = codes[ch];
+        int previous = 0;
+
+        for (int start = 0; start < pageSize;)
+        {
+            const bool isData = channel[start] != noDataCode;
+            int end = start + 1;
+
+            while (end < pageSize && (channel[end] != noDataCode) == isData)
+                ++end;
+
+            writeVarint (payload, ((std::uint32_t) (end - start) << 1) | (isData ? 1u : 0u));
+
+            if (isData)
+            {
+                hasData = true;
+
+                for (int i = start; i < end; ++i)
+                {
+                    writeVarint (payload, zigZag ((int) channel[i] - previous));
+                    previous = channel[i];
+                }
+            }
+
+            start = end;
+        }
+    }
+
+    if (! hasData)
+        return false;
+
+    writeVarint (out, (std::uint32_t) pageNumber);
+    writeVarint (out, (std::uint32_t) payload.getDataSize());
+    out.write (payload.getData(), payload.getDataSize());
+    return true;
+}
+
+int GhostCodec::decodePage (juce::MemoryInputStream& in, std::uint16_t* const* codes, int numChannels, int pageSize)
+{
+    std::uint32_t pageNumber = 0, payloadSize = 0;
+
+    if (! readVarint (in, pageNumber) || ! readVarint (in, payloadSize)
+        || pageNumber > (std::uint32_t) std::numeric_limits<int>::max()
+        || (juce::int64) payloadSize > in.getNumBytesRemaining())
+        return -1;
+
+    juce::MemoryInputStream payload ((const char*) in.getData() + in.getPosition(), payloadSize, false);
+    in.skipNextBytes (payloadSize);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* channel = codes[ch];
+        int previous = 0;
+
+        for (int index = 0; index < pageSize;)
+        {
+            std::uint32_t header = 0;
+
+            if (! readVarint (payload, header))
+                return -1;
+
+            const auto length = (int) (header >> 1);
+
+            if (length <= 0 || length > pageSize - index)
+                return -1;
+
+            for (int i = index; i < index + length; ++i)
+            {
+                if ((header & 1u) == 0)
+                {
+                    channel[i] = noDataCode;
+                    continue;
+                }
+
+                std::uint32_t delta = 0;
+
+                if (! readVarint (payload, delta))
+                    return -1;
+
+                previous += unZigZag (delta);
+                channel[i] = (std::uint16_t) juce::jlimit (0, 65535, previous);
+            }
+
+            index += length;
+        }
+    }
+
+    return (int) pageNumber;
+}
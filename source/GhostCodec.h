@@ -0,0 +1,71 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "FastMath.h"
+#include <cstdint>
+
+// ==========================================================
+// THE GHOST CODEC
+// ==========================================================
+// Levels are quantised to 16-bit codes in the log domain: code 0 is "no data",
+// code 1 is silence, and codes 2..65535 cover 2^-24 .. 2^8 (-144 dB .. +48 dB)
+// in steps of ~0.003 dB. The GhostMap stores these codes directly, so replay
+// interpolates in log2 and needs a single exp2 per sample.
+//
+// For the plugin state, each channel of a page is then written as alternating
+// runs: a run of "no data" is just its length, a run of data is its length
+// followed by the zig-zag delta from the previous code for every index, so a
+// steady or slowly moving ride costs about a byte per index. All integers are
+// LEB128 varints. A page with no data at all encodes to nothing.
+//
+//   page record:  varint pageNumber, varint payloadSize, payload
+//   payload:      per channel, runs until pageSize values are covered
+//   run:          varint ((length << 1) | hasData), then length zig-zag deltas if hasData
+namespace GhostCodec
+{
+    inline constexpr std::uint16_t noDataCode = 0;
+    inline constexpr std::uint16_t silenceCode = 1;
+    inline constexpr float minLevelLog2 = -24.0f;
+    inline constexpr float maxLevelLog2 = 8.0f;
+    inline constexpr float codesPerOctave = 65533.0f / (maxLevelLog2 - minLevelLog2);
+
+    inline std::uint16_t toCode (float level) noexcept
+    {
+        if (level < 0.0f)
+            return noDataCode;
+
+        const auto octaves = FastMath::log2 (juce::jmax (level, 1.0e-30f)) - minLevelLog2;
+
+        if (octaves < 0.0f)
+            return silenceCode;
+
+        return (std::uint16_t) (2 + juce::jmin (65533, (int) (octaves * codesPerOctave + 0.5f)));
+    }
+
+    // The level of a code in log2. Silence sits one step below the bottom of the range, so
+    // interpolating towards it still fades out smoothly. Not meaningful for noDataCode.
+    inline float toLog2 (std::uint16_t code) noexcept
+    {
+        return (float) (code - 2) / codesPerOctave + minLevelLog2;
+    }
+
+    inline float fromCode (std::uint16_t code) noexcept
+    {
+        if (code == noDataCode)
+            return -1.0f;
+
+        if (code == silenceCode)
+            return 0.0f;
+
+        return FastMath::exp2 (toLog2 (code));
+    }
+
+    // Appends one page record for codes[channel][index]. Writes nothing and returns false when
+    // the page holds no data.
+    bool encodePage (int pageNumber, const std::uint16_t* const* codes, int numChannels, int pageSize,
+                     juce::MemoryOutputStream& out);
+
+    // Reads the next page record into codes[channel][index]. Returns the page number, or -1 at
+    // the end of the input or on malformed data.
+    int decodePage (juce::MemoryInputStream& in, std::uint16_t* const* codes, int numChannels, int pageSize);
+}
@@ -0,0 +1,242 @@
+#include "GhostImport.h"
+#include "EngineStages.h"
+#include <cmath>
+
+namespace
+{
+    constexpr double warmUpTimeConstants = 20.0; // e^-20: the follower's starting point no longer shows
+    constexpr int chunkSize = 8192;
+
+    // Follows one segment of the file and captures it onto the Ghost grid. The follower starts
+    // from silence at warmUpStart; only what it sees from start onwards gets written.
+    bool analyseSegment (const juce::File& file, GhostMap& map,
+                         const EngineStages::GhostClock& clock, float envCoeff,
+                         juce::int64 warmUpStart, juce::int64 start, juce::int64 end,
+                         std::atomic<juce::int64>& samplesDone, const std::atomic<bool>& cancelled)
+    {
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (file));
+
+        if (reader == nullptr)
+            return false;
+
+        const auto numFileChannels = (int) reader->numChannels;
+        juce::AudioBuffer<float> buffer (numFileChannels, chunkSize);
+        juce::HeapBlock<float> level (chunkSize);
+
+        float env[GhostMap::numChannels] {};
+        int lastWrittenIdx[GhostMap::numChannels];
+
+        // Carry on from where the previous segment's capture left off, as one pass would
+        for (auto& idx : lastWrittenIdx)
+            idx = start > 0 ? EngineStages::GhostClock::indexFor (clock.ppqAt ((int) start - 1) * clock.ppqResolution) : -1;
+
+        for (auto pos = warmUpStart; pos < end && ! cancelled.load (std::memory_order_relaxed); pos += chunkSize)
+        {
+            const auto n = (int) std::min<juce::int64> (chunkSize, end - pos);
+
+            if (! reader->read (&buffer, 0, n, pos, true, true))
+                return false;
+
+            for (int ch = 0; ch < GhostMap::numChannels; ++ch)
+            {
+                // A mono reference guides both channels, as the sidechain does
+                const auto* in = buffer.getReadPointer (juce::jmin (ch, numFileChannels - 1));
+                auto* out = level.get();
+
+                juce::FloatVectorOperations::multiply (out, in, in, n);
+
+                auto e = env[ch];
+
+                for (int i = 0; i < n; ++i)
+                {
+                    e = envCoeff * e + (1.0f - envCoeff) * out[i];
+                    out[i] = e;
+                }
+
+                env[ch] = e;
+
+                for (int i = 0; i < n; ++i)
+                    out[i] = std::sqrt (out[i]);
+
+                // Only the segment's own samples get captured
+                const auto skip = (int) juce::jlimit<juce::int64> (0, n, start - pos);
+
+                if (skip < n)
+                    EngineStages::recordGhost (map, ch, out + skip, (int) (pos + skip), n - skip, clock, lastWrittenIdx[ch]);
+            }
+
+            samplesDone.fetch_add (n, std::memory_order_relaxed);
+        }
+
+        return true;
+    }
+}
+
+//==============================================================================
+juce::Result GhostImport::analyseFile (const juce::File& file, const Settings& settings, GhostMap& map,
+                                       std::atomic<float>* progress, const std::function<bool()>& shouldExit)
+{
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> probe (formats.createReaderFor (file));
+
+    if (probe == nullptr)
+        return juce::Result::fail ("Can't read " + file.getFileName() + " as audio");
+
+    const auto sampleRate = probe->sampleRate;
+    const auto length = probe->lengthInSamples;
+    probe.reset();
+
+    if (sampleRate <= 0.0 || length <= 0)
+        return juce::Result::fail (file.getFileName() + " has no usable audio");
+
+    if (length >= std::numeric_limits<int>::max())
+        return juce::Result::fail (file.getFileName() + " is too long to import");
+
+    if (! (settings.bpm > 0.0))
+        return juce::Result::fail ("The tempo must be above 0 BPM");
+
+    EngineStages::GhostClock clock;
+    clock.startPPQ = settings.startPPQ;
+    clock.ppqResolution = map.claimResolution (GhostMap::resolutionFor (settings.bpm));
+    clock.ppqPerSample = (settings.bpm / 60.0) / sampleRate;
+
+    const auto firstIndex = EngineStages::GhostClock::indexFor (clock.ppqAt (0) * clock.ppqResolution);
+    const auto lastIndex = EngineStages::GhostClock::indexFor (clock.ppqAt ((int) length - 1) * clock.ppqResolution);
+
+    if (! GhostMap::isValidIndex (firstIndex) || ! GhostMap::isValidIndex (lastIndex))
+        return juce::Result::fail (file.getFileName() + " doesn't fit on the Ghost timeline at that tempo");
+
+    map.allocateRange (firstIndex, lastIndex);
+
+    const auto envCoeff = static_cast<float> (std::exp (-1.0 / (EngineStages::rmsFollowerSeconds * sampleRate)));
+    const auto warmUp = (juce::int64) std::ceil (warmUpTimeConstants * EngineStages::rmsFollowerSeconds * sampleRate);
+
+    // Segments much shorter than their warm-up would mostly be redoing each other's work
+    const auto numThreads = settings.numThreads > 0 ? settings.numThreads : juce::SystemStats::getNumCpus();
+    const auto numSegments = (int) juce::jlimit<juce::int64> (1, numThreads, length / (8 * warmUp));
+
+    std::atomic<juce::int64> samplesDone { 0 };
+    std::atomic<bool> cancelled { false };
+    std::atomic<int> numFailed { 0 };
+    std::atomic<int> numRunning { numSegments };
+    juce::WaitableEvent allDone;
+
+    const auto totalSamples = length + (numSegments - 1) * warmUp;
+
+    {
+        juce::ThreadPool pool (juce::ThreadPoolOptions {}.withThreadName ("Ghost Import").withNumberOfThreads (numSegments));
+
+        for (int segment = 0; segment < numSegments; ++segment)
+        {
+            const auto start = length * segment / numSegments;
+            const auto end = length * (segment + 1) / numSegments;
+
+            pool.addJob ([&, start, end] {
+                if (! analyseSegment (file, map, clock, envCoeff, std::max<juce::int64> (0, start - warmUp), start, end,
+                                      samplesDone, cancelled))
+                    numFailed.fetch_add (1);
+
+                if (numRunning.fetch_sub (1) == 1)
+                    allDone.signal();
+            });
+        }
+
+        while (! allDone.wait (20.0))
+        {
+            if (progress != nullptr)
+                progress->store ((float) samplesDone.load() / (float) totalSamples);
+
+            if (shouldExit && shouldExit())
+                cancelled.store (true);
+        }
+    }
+
+    if (cancelled.load())
+        return juce::Result::fail ("Import cancelled");
+
+    if (numFailed.load() > 0)
+        return juce::Result::fail ("Couldn't read all of " + file.getFileName());
+
+    if (progress != nullptr)
+        progress->store (1.0f);
+
+    return juce::Result::ok();
+}
+
+//==============================================================================
+GhostImporter::GhostImporter (GhostLibrary& libraryToFill)
+    : juce::Thread ("Ghost Importer"), library (libraryToFill)
+{
+}
+
+GhostImporter::~GhostImporter()
+{
+    stopThread (4000);
+    cancelPendingUpdate();
+}
+
+bool GhostImporter::startImport (const juce::File& fileToImport, int slotToFill, const GhostImport::Settings& settingsToUse)
+{
+    if (isThreadRunning())
+        return false;
+
+    // Install the last import before its settings are overwritten
+    handleUpdateNowIfNeeded();
+
+    file = fileToImport;
+    slot = juce::jlimit (0, GhostLibrary::numSlots - 1, slotToFill);
+    settings = settingsToUse;
+    progress.store (0.0f);
+
+    return startThread (juce::Thread::Priority::normal);
+}
+
+void GhostImporter::cancelImport()
+{
+    signalThreadShouldExit();
+}
+
+juce::Result GhostImporter::getLastResult() const
+{
+    const juce::ScopedLock sl (resultLock);
+    return lastResult;
+}
+
+void GhostImporter::run()
+{
+    // A fresh map, so whatever the slot holds keeps playing until the import is complete
+    auto map = library.createMap();
+    auto result = GhostImport::analyseFile (file, settings, *map, &progress, [this] { return threadShouldExit(); });
+
+    {
+        const juce::ScopedLock sl (resultLock);
+        pendingMap = result.wasOk() ? std::move (map) : nullptr;
+        pendingResult = result;
+        pendingCancelled = threadShouldExit();
+    }
+
+    // The library's slots belong to the message thread
+    triggerAsyncUpdate();
+}
+
+void GhostImporter::handleAsyncUpdate()
+{
+    std::unique_ptr<GhostMap> map;
+
+    {
+        const juce::ScopedLock sl (resultLock);
+        map = std::move (pendingMap);
+        lastResult = pendingResult;
+        cancelled.store (pendingCancelled);
+    }
+
+    if (map != nullptr)
+        library.installSlot (slot, std::move (map), file.getFileNameWithoutExtension());
+
+    numFinished.fetch_add (1);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_events/juce_events.h>
+#include "GhostLibrary.h"
+#include <atomic>
+#include <functional>
+
+// ==========================================================
+// THE GHOST IMPORT
+// ==========================================================
+// Builds a Ghost from a reference audio file (anything the basic JUCE formats
+// read: WAV, AIFF, FLAC, ...) at a fixed tempo, faster than realtime. The
+// guide follower is the same one-pole RMS follower processBlock runs, and the
+// levels are captured onto the Ghost grid by the same recordGhost, so an
+// imported Ghost matches one recorded by playing the file through EXT.
+//
+// The file is split into one segment per core. Each segment opens its own
+// reader, so decoding runs in parallel too, and starts its follower a warm-up
+// stretch early: after 20 time constants the follower has forgotten where it
+// started, so segments join up without a seam. Within a segment the squares
+// and square roots are vectorised passes around the serial recursion.
+namespace GhostImport
+{
+    struct Settings
+    {
+        double bpm { 120.0 };
+        double startPPQ { 0.0 }; // where the start of the file lands on the timeline
+        int numThreads { 0 };    // 0 = one per core
+    };
+
+    // Analyses the whole file into map, allocating the pages it needs. Blocking, so call it from
+    // a background thread. progress (0..1) and shouldExit are polled from the calling thread.
+    juce::Result analyseFile (const juce::File& file, const Settings& settings, GhostMap& map,
+                              std::atomic<float>* progress = nullptr,
+                              const std::function<bool()>& shouldExit = {});
+}
+
+// ==========================================================
+// THE GHOST IMPORTER
+// ==========================================================
+// Runs one import at a time on its own thread. When it's done the result is
+// handed to the message thread, which installs it into a GhostLibrary slot,
+// replacing what was there; a cancelled or failed import leaves the slot
+// alone. The editor polls it from its timer.
+class GhostImporter : private juce::Thread,
+                      private juce::AsyncUpdater
+{
+public:
+    explicit GhostImporter (GhostLibrary& libraryToFill);
+    ~GhostImporter() override;
+
+    // False if an import is already running
+    bool startImport (const juce::File& file, int slot, const GhostImport::Settings& settings);
+    void cancelImport();
+
+    // Still true while a finished import waits for the message thread to install it
+    bool isImporting() const noexcept { return isThreadRunning() || isUpdatePending(); }
+    float getProgress() const noexcept { return progress.load(); }
+
+    // Bumped on the message thread every time an import ends, however it ended
+    int getNumFinished() const noexcept { return numFinished.load(); }
+    juce::Result getLastResult() const;
+    bool wasCancelled() const noexcept { return cancelled.load(); }
+
+private:
+    void run() override;
+    void handleAsyncUpdate() override;
+
+    GhostLibrary& library;
+
+    juce::File file;
+    int slot { 0 };
+    GhostImport::Settings settings;
+
+    std::atomic<float> progress { 0.0f };
+    std::atomic<int> numFinished { 0 };
+    std::atomic<bool> cancelled { false };
+
+    juce::Result lastResult { juce::Result::ok() };
+    juce::CriticalSection resultLock;
+
+    // What run() finished with, waiting for handleAsyncUpdate()
+    std::unique_ptr<GhostMap> pendingMap;
+    juce::Result pendingResult { juce::Result::ok() };
+    bool pendingCancelled { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GhostImporter)
+};
@@ -0,0 +1,280 @@
+#include "GhostLibrary.h"
+#include <algorithm>
+
+//==============================================================================
+GhostLibrary::ReadScope::ReadScope (GhostLibrary& libraryToRead) noexcept
+    : library (libraryToRead)
+{
+    // Publish the hazard, then make sure the pointer it protects is still the active one:
+    // anything retired after that point sees the hazard and waits
+    do
+    {
+        map = library.active.load();
+        library.hazard.store (map);
+    } while (map != library.active.load());
+}
+
+//==============================================================================
+GhostLibrary::GhostLibrary()
+{
+    pager->registerLibrary (*this);
+}
+
+GhostLibrary::~GhostLibrary()
+{
+    // After this the pager no longer touches us, and no audio thread is running
+    pager->unregisterLibrary (*this);
+}
+
+GhostMap& GhostLibrary::getEmptyMap()
+{
+    static GhostMap emptyMap;
+    return emptyMap;
+}
+
+void GhostLibrary::selectSlot (int slot)
+{
+    const juce::ScopedLock sl (lock);
+    activeSlot.store (juce::jlimit (0, numSlots - 1, slot));
+    publishActiveLocked();
+}
+
+GhostMap* GhostLibrary::getSlot (int slot) const
+{
+    const juce::ScopedLock sl (lock);
+    return juce::isPositiveAndBelow (slot, numSlots) ? slots[(size_t) slot].map.get() : nullptr;
+}
+
+GhostMap& GhostLibrary::editSlot (int slot)
+{
+    const juce::ScopedLock sl (lock);
+    return createSlotLocked (juce::jlimit (0, numSlots - 1, slot));
+}
+
+void GhostLibrary::clearSlot (int slot)
+{
+    if (! juce::isPositiveAndBelow (slot, numSlots))
+        return;
+
+    const juce::ScopedLock sl (lock);
+    auto& target = slots[(size_t) slot];
+
+    if (target.map == nullptr)
+        return;
+
+    retired.push_back (std::move (target.map));
+    target.name = {};
+    publishActiveLocked();
+}
+
+void GhostLibrary::installSlot (int slot, std::unique_ptr<GhostMap> map, const juce::String& name)
+{
+    if (! juce::isPositiveAndBelow (slot, numSlots) || map == nullptr)
+        return;
+
+    const juce::ScopedLock sl (lock);
+    auto& target = slots[(size_t) slot];
+
+    if (target.map != nullptr)
+        retired.push_back (std::move (target.map));
+
+    target.map = std::move (map);
+    target.name = name;
+    publishActiveLocked();
+}
+
+juce::String GhostLibrary::getSlotName (int slot) const
+{
+    const juce::ScopedLock sl (lock);
+    return juce::isPositiveAndBelow (slot, numSlots) ? slots[(size_t) slot].name : juce::String();
+}
+
+void GhostLibrary::setSlotName (int slot, const juce::String& name)
+{
+    const juce::ScopedLock sl (lock);
+
+    if (juce::isPositiveAndBelow (slot, numSlots))
+        slots[(size_t) slot].name = name;
+}
+
+void GhostLibrary::setBackingDirectory (const juce::File& directory)
+{
+    const juce::ScopedLock sl (lock);
+    backingDirectory = directory;
+}
+
+juce::File GhostLibrary::getBackingDirectory() const
+{
+    const juce::ScopedLock sl (lock);
+    return backingDirectory;
+}
+
+std::unique_ptr<GhostMap> GhostLibrary::createMap() const
+{
+    const juce::ScopedLock sl (lock);
+    return createMapLocked();
+}
+
+std::unique_ptr<GhostMap> GhostLibrary::createMapLocked() const
+{
+    auto map = std::make_unique<GhostMap>();
+
+    if (backingDirectory != juce::File())
+        if (const auto file = scratchFolders->createFileIn (backingDirectory, "Ghost"); file != juce::File())
+            map->setBackingFile (file);
+
+    return map;
+}
+
+GhostMap& GhostLibrary::createSlotLocked (int slot)
+{
+    auto& target = slots[(size_t) slot];
+
+    if (target.map == nullptr)
+    {
+        target.map = createMapLocked();
+        publishActiveLocked();
+    }
+
+    return *target.map;
+}
+
+void GhostLibrary::publishActiveLocked()
+{
+    auto* map = slots[(size_t) activeSlot.load()].map.get();
+    auto* previous = active.exchange (map != nullptr ? map : &getEmptyMap());
+
+    if (active.load() != previous && onActiveMapChanged != nullptr)
+        onActiveMapChanged();
+}
+
+//==============================================================================
+void GhostLibrary::service (bool refreshState)
+{
+    std::array<GhostMap*, numSlots> maps {};
+
+    {
+        const juce::ScopedLock sl (lock);
+
+        if (storageRequested.exchange (false, std::memory_order_acquire))
+            createSlotLocked (activeSlot.load());
+
+        for (size_t i = 0; i < slots.size(); ++i)
+            maps[i] = slots[i].map.get();
+    }
+
+    // Encoding a long ride takes a while, so it happens without the lock. Only this function
+    // frees retired maps, so the ones taken above stay alive even if their slots change meanwhile.
+    for (auto* map : maps)
+    {
+        if (map != nullptr)
+        {
+            map->servicePages();
+            map->refreshOverview();
+
+            if (refreshState)
+                map->refreshEncodedPages();
+        }
+    }
+
+    const juce::ScopedLock sl (lock);
+
+    // A retired map can go once the audio thread isn't holding it. It can't pick it up again:
+    // the active pointer moved on before the map was retired.
+    const auto* held = hazard.load();
+
+    retired.erase (std::remove_if (retired.begin(), retired.end(), [held] (const auto& map) { return map.get() != held; }),
+                   retired.end());
+}
+
+int GhostLibrary::getNumRetiredMaps() const
+{
+    const juce::ScopedLock sl (lock);
+    return (int) retired.size();
+}
+
+//==============================================================================
+// State chunk layout: int version, int active slot, int numSlots, then per slot an int payload
+// size, and when that's non-zero the slot name and the GhostMap state
+static constexpr int libraryStateVersion = 1;
+
+void GhostLibrary::writeState (juce::MemoryOutputStream& out)
+{
+    const juce::ScopedLock sl (lock);
+
+    out.writeInt (libraryStateVersion);
+    out.writeInt (activeSlot.load());
+    out.writeInt (numSlots);
+
+    for (auto& slot : slots)
+    {
+        if (slot.map == nullptr)
+        {
+            out.writeInt (0);
+            continue;
+        }
+
+        juce::MemoryOutputStream ghost;
+        slot.map->writeState (ghost);
+
+        out.writeInt ((int) ghost.getDataSize());
+        out.writeString (slot.name);
+        out.write (ghost.getData(), ghost.getDataSize());
+    }
+}
+
+bool GhostLibrary::readState (const void* data, size_t sizeInBytes)
+{
+    juce::MemoryInputStream in (data, sizeInBytes, false);
+
+    const auto version = in.readInt();
+    const auto storedActive = in.readInt();
+    const auto storedSlots = in.readInt();
+
+    if (version != libraryStateVersion || storedSlots < 0 || storedSlots > 64)
+        return false;
+
+    // Every slot is read into a fresh map first, so a bad state leaves the library as it was
+    std::array<Slot, numSlots> loaded;
+
+    for (int slot = 0; slot < numSlots; ++slot)
+    {
+        const auto size = (slot < storedSlots) ? in.readInt() : 0;
+
+        if (size < 0 || size > in.getNumBytesRemaining())
+            return false;
+
+        if (size == 0)
+            continue;
+
+        const auto name = in.readString();
+
+        if (in.getNumBytesRemaining() < size)
+            return false;
+
+        juce::MemoryBlock ghost;
+        in.readIntoMemoryBlock (ghost, size);
+
+        auto map = createMap();
+
+        if (! map->readState (ghost.getData(), ghost.getSize()))
+            return false;
+
+        loaded[(size_t) slot] = { std::move (map), name };
+    }
+
+    // The old maps are retired, as with installSlot, and the audio thread moves over in one go
+    const juce::ScopedLock sl (lock);
+
+    for (size_t i = 0; i < slots.size(); ++i)
+    {
+        if (slots[i].map != nullptr)
+            retired.push_back (std::move (slots[i].map));
+
+        slots[i] = std::move (loaded[i]);
+    }
+
+    activeSlot.store (juce::jlimit (0, numSlots - 1, storedActive));
+    publishActiveLocked();
+    return true;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "GhostMap.h"
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// ==========================================================
+// THE GHOST LIBRARY
+// ==========================================================
+// A few Ghost slots per instance, one of which is active. An empty slot is
+// just a null pointer, so it costs no memory; a slot's GhostMap is created
+// when the editor arms recording into it, or, if the audio thread starts
+// recording into an empty slot, by the GhostPager shortly after.
+//
+// The audio thread reads the active map through a single atomic pointer,
+// protected by a hazard pointer for the length of a block (see ReadScope).
+// Selecting another slot only swaps that pointer, so the switch lands on the
+// next block boundary with no copying and no locks in processBlock. A map
+// that gets thrown away (slot cleared or replaced, or by loading a state) is
+// retired rather than deleted, and the GhostPager frees it once the audio
+// thread is no longer holding it.
+class GhostLibrary
+{
+public:
+    static constexpr int numSlots = 3;
+
+    GhostLibrary();
+    ~GhostLibrary();
+
+    // ==========================================================
+    // AUDIO THREAD
+    // ==========================================================
+    // Holds the active map for one block. The map stays alive until the scope ends, even
+    // if another slot gets selected or this one cleared in the meantime.
+    class ReadScope
+    {
+    public:
+        explicit ReadScope (GhostLibrary& libraryToRead) noexcept;
+        ~ReadScope() noexcept { library.hazard.store (nullptr); }
+
+        GhostMap& getMap() const noexcept { return *map; }
+
+        // False while the active slot is empty: reads find nothing and writes are dropped
+        bool hasStorage() const noexcept { return map != &getEmptyMap(); }
+
+        // Asks the GhostPager to create the active slot's map
+        void requestStorage() const noexcept { library.storageRequested.store (true, std::memory_order_release); }
+
+    private:
+        GhostLibrary& library;
+        GhostMap* map;
+
+        JUCE_DECLARE_NON_COPYABLE (ReadScope)
+    };
+
+    // ==========================================================
+    // MESSAGE THREAD
+    // ==========================================================
+    int getActiveSlot() const noexcept { return activeSlot.load(); }
+    void selectSlot (int slot);
+
+    // nullptr for an empty slot
+    GhostMap* getSlot (int slot) const;
+
+    // Creates the slot's map if it's empty
+    GhostMap& editSlot (int slot);
+    GhostMap& editActiveSlot() { return editSlot (getActiveSlot()); }
+
+    // Empties the slot; its map is freed in the background
+    void clearSlot (int slot);
+
+    // Replaces the slot's map with one built elsewhere (an import, say); the old one is retired
+    void installSlot (int slot, std::unique_ptr<GhostMap> map, const juce::String& name);
+
+    // Slot maps created from here on keep their pages in memory-mapped scratch files in this
+    // directory, inside this process's folder (see GhostScratchFolders). An empty File, the
+    // default, keeps them on the heap.
+    void setBackingDirectory (const juce::File& directory);
+    juce::File getBackingDirectory() const;
+
+    // A new, empty map, stored the way the slots are; for building a map to install
+    std::unique_ptr<GhostMap> createMap() const;
+
+    // Called whenever the audio thread is handed another map: a slot switch, the active slot
+    // cleared, replaced or created, or a state loaded. It runs with the library locked, on
+    // whichever thread made the change (the pager, when it creates a slot the audio thread
+    // asked for). Set it before the library is used.
+    std::function<void()> onActiveMapChanged;
+
+    juce::String getSlotName (int slot) const;
+    void setSlotName (int slot, const juce::String& name);
+
+    // All slots, their names and the active slot
+    void writeState (juce::MemoryOutputStream& out);
+    bool readState (const void* data, size_t sizeInBytes);
+
+    // ==========================================================
+    // BACKGROUND
+    // ==========================================================
+    // Creates a slot the audio thread asked for, frees retired maps it has let go of, keeps each
+    // slot's overview current, and its encoded state too when refreshState is set. Called by the
+    // GhostPager.
+    void service (bool refreshState);
+
+    int getNumRetiredMaps() const;
+
+    // The shared stand-in the audio thread reads while the active slot is empty
+    static GhostMap& getEmptyMap();
+
+private:
+    GhostMap& createSlotLocked (int slot);
+    std::unique_ptr<GhostMap> createMapLocked() const;
+    void publishActiveLocked();
+
+    struct Slot
+    {
+        std::unique_ptr<GhostMap> map;
+        juce::String name;
+    };
+
+    juce::SharedResourcePointer<GhostScratchFolders> scratchFolders; // outlives the slots' files
+    std::array<Slot, numSlots> slots;
+    std::vector<std::unique_ptr<GhostMap>> retired;
+    juce::File backingDirectory;
+    juce::CriticalSection lock; // guards slots, retired and backingDirectory; never taken by the audio thread
+
+    std::atomic<int> activeSlot { 0 };
+    std::atomic<GhostMap*> active { &getEmptyMap() };
+    std::atomic<GhostMap*> hazard { nullptr };
+    std::atomic<bool> storageRequested { false };
+
+    juce::SharedResourcePointer<GhostPager> pager;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GhostLibrary)
+};
@@ -0,0 +1,374 @@
+#include "GhostMap.h"
+#include "GhostLibrary.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+//==============================================================================
+GhostMap::Page::Page()
+{
+    for (auto& channel : data)
+        std::fill (std::begin (channel), std::end (channel), GhostCodec::noDataCode);
+}
+
+GhostMap::~GhostMap()
+{
+    for (auto& dirSlot : directories)
+    {
+        if (auto* dir = dirSlot.load())
+        {
+            for (auto& pageSlot : dir->pages)
+            {
+                auto* page = pageSlot.load();
+
+                // Pages in the backing file go with the file
+                if (page != nullptr && backingStore != nullptr && backingStore->contains (page))
+                    page->~Page();
+                else
+                    delete page;
+            }
+
+            delete dir;
+        }
+    }
+}
+
+void GhostMap::servicePages()
+{
+    const auto armed = writeArmed.load (std::memory_order_acquire);
+    const auto backed = isFileBacked();
+
+    if (! armed && ! backed)
+        return;
+
+    const auto playheadPage = playheadIndex.load (std::memory_order_relaxed) >> pageBits;
+    const auto lastPage = (numDirectories * directorySize) - 1;
+
+    for (int pageNumber = std::max (0, playheadPage - pagesBehindPlayhead);
+         pageNumber <= std::min (lastPage, playheadPage + pagesAheadOfPlayhead);
+         ++pageNumber)
+    {
+        if (armed)
+            allocatePage (pageNumber);
+
+        // The OS may have dropped a file-backed page since the last pass: bring it back
+        // before the playhead gets there, whether it's being read or written
+        if (backed)
+            if (auto* page = findPage (pageNumber << pageBits))
+                faultIn (*page);
+    }
+}
+
+void GhostMap::faultIn (Page& page) noexcept
+{
+    // A compare-exchange always writes, even when it swaps a value for itself, where a fetch_or (0)
+    // may be compiled into a plain load
+    const auto touch = [] (auto& value) {
+        auto current = value.load (std::memory_order_relaxed);
+        value.compare_exchange_strong (current, current, std::memory_order_relaxed);
+    };
+
+    for (auto& channel : page.data)
+        for (int i = 0; i < pageSize; i += codesPerMemoryPage)
+            touch (channel[i]);
+
+    touch (page.version);
+}
+
+void GhostMap::allocateRange (int firstIndex, int lastIndex)
+{
+    if (lastIndex < 0)
+        return;
+
+    for (int page = std::max (0, firstIndex) >> pageBits; page <= (lastIndex >> pageBits); ++page)
+        allocatePage (page);
+}
+
+void GhostMap::allocatePage (int pageNumber)
+{
+    auto& dirSlot = directories[(size_t) (pageNumber >> directoryBits)];
+    auto* dir = dirSlot.load (std::memory_order_acquire);
+
+    if (dir != nullptr && dir->pages[(size_t) (pageNumber & (directorySize - 1))].load (std::memory_order_acquire) != nullptr)
+        return;
+
+    const juce::ScopedLock sl (allocationLock);
+
+    if (dir == nullptr)
+    {
+        dir = dirSlot.load (std::memory_order_acquire);
+
+        if (dir == nullptr)
+        {
+            dir = new Directory();
+            dirSlot.store (dir, std::memory_order_release);
+        }
+    }
+
+    auto& pageSlot = dir->pages[(size_t) (pageNumber & (directorySize - 1))];
+
+    if (pageSlot.load (std::memory_order_acquire) == nullptr)
+    {
+        Page* page = nullptr;
+
+        // Constructing in place also faults the new page in
+        if (backingStore != nullptr)
+            if (auto* slot = backingStore->allocateSlot())
+                page = new (slot) Page();
+
+        pageSlot.store (page != nullptr ? page : new Page(), std::memory_order_release);
+        ++numAllocatedPages;
+    }
+}
+
+void GhostMap::setBackingFile (const juce::File& file)
+{
+    const juce::ScopedLock sl (allocationLock);
+
+    // Pages already in an earlier file stay there, so keep it open
+    if (backingStore != nullptr)
+        return;
+
+    backingStore = std::make_unique<GhostBackingStore> (file, sizeof (Page));
+    fileBacked.store (true, std::memory_order_release);
+}
+
+size_t GhostMap::getBackingFileSize() const
+{
+    const juce::ScopedLock sl (allocationLock);
+    return backingStore != nullptr ? backingStore->getFileSize() : 0;
+}
+
+double GhostMap::resolutionFor (double bpm) noexcept
+{
+    if (! (bpm > 0.0) || ! std::isfinite (bpm))
+        return legacyResolution;
+
+    return juce::jlimit (minResolution, maxResolution, std::round (indicesPerSecond * 60.0 / bpm));
+}
+
+void GhostMap::clear()
+{
+    resolution.store (0.0, std::memory_order_release);
+
+    forEachPage ([] (int, const Page& page) {
+        auto& mutablePage = const_cast<Page&> (page);
+
+        for (auto& channel : mutablePage.data)
+            for (auto& value : channel)
+                value.store (GhostCodec::noDataCode, std::memory_order_relaxed);
+
+        mutablePage.version.fetch_add (1, std::memory_order_release);
+    });
+}
+
+//==============================================================================
+// State chunk layout: int codec version, int numChannels, int pageBits, double resolution (from
+// version 2; 0 when unset), then GhostCodec page records
+static constexpr int ghostStateVersion = 2;
+
+GhostMap::EncodedPage GhostMap::encodePage (int pageNumber, const Page& page)
+{
+    EncodedPage encoded;
+
+    // Read the version first: if the audio thread writes while we encode, the next pass picks it up again
+    encoded.version = page.version.load (std::memory_order_acquire);
+
+    std::vector<std::uint16_t> codes ((size_t) (numChannels * pageSize));
+    const std::uint16_t* channels[numChannels];
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* channelCodes = codes.data() + ch * pageSize;
+        channels[ch] = channelCodes;
+
+        for (int i = 0; i < pageSize; ++i)
+            channelCodes[i] = page.data[ch][i].load (std::memory_order_relaxed);
+    }
+
+    juce::MemoryOutputStream out (encoded.data, false);
+    GhostCodec::encodePage (pageNumber, channels, numChannels, pageSize, out);
+    out.flush();
+
+    return encoded;
+}
+
+void GhostMap::refreshEncodedPages()
+{
+    forEachPage ([this] (int pageNumber, const Page& page) {
+        {
+            const juce::ScopedLock sl (encodedPagesLock);
+            auto existing = encodedPages.find (pageNumber);
+
+            if (existing != encodedPages.end() && existing->second.version == page.version.load (std::memory_order_acquire))
+                return;
+        }
+
+        auto encoded = encodePage (pageNumber, page);
+
+        const juce::ScopedLock sl (encodedPagesLock);
+        encodedPages[pageNumber] = std::move (encoded);
+    });
+}
+
+void GhostMap::refreshOverview()
+{
+    std::vector<std::uint16_t> codes;
+
+    forEachPage ([this, &codes] (int pageNumber, const Page& page) {
+        // As with encoding: a write that lands while we copy gets picked up on the next pass
+        const auto pageVersion = page.version.load (std::memory_order_acquire);
+
+        if (! overview.needsUpdate (pageNumber, pageVersion))
+            return;
+
+        codes.resize ((size_t) (numChannels * pageSize));
+        const std::uint16_t* channels[numChannels];
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* channelCodes = codes.data() + ch * pageSize;
+            channels[ch] = channelCodes;
+
+            for (int i = 0; i < pageSize; ++i)
+                channelCodes[i] = page.data[ch][i].load (std::memory_order_relaxed);
+        }
+
+        overview.updatePage (pageNumber, pageVersion, channels);
+    });
+}
+
+void GhostMap::writeState (juce::MemoryOutputStream& out)
+{
+    out.writeInt (ghostStateVersion);
+    out.writeInt (numChannels);
+    out.writeInt (pageBits);
+    out.writeDouble (getResolution());
+
+    const juce::ScopedLock sl (encodedPagesLock);
+
+    forEachPage ([this, &out] (int pageNumber, const Page& page) {
+        auto& cached = encodedPages[pageNumber];
+
+        if (cached.version != page.version.load (std::memory_order_acquire))
+            cached = encodePage (pageNumber, page);
+
+        out.write (cached.data.getData(), cached.data.getSize());
+    });
+}
+
+bool GhostMap::readState (const void* data, size_t sizeInBytes)
+{
+    juce::MemoryInputStream in (data, sizeInBytes, false);
+
+    const auto version = in.readInt();
+    const auto storedChannels = in.readInt();
+    const auto storedPageBits = in.readInt();
+
+    if (version < 1 || version > ghostStateVersion || storedChannels <= 0 || storedChannels > 16 || storedPageBits < 4 || storedPageBits > 16)
+        return false;
+
+    // Version 1 states were all recorded on the old fixed grid
+    const auto storedResolution = version >= 2 ? in.readDouble() : legacyResolution;
+
+    if (! (storedResolution >= 0.0 && storedResolution <= maxResolution))
+        return false;
+
+    clear();
+    resolution.store (storedResolution, std::memory_order_release);
+
+    {
+        const juce::ScopedLock sl (encodedPagesLock);
+        encodedPages.clear();
+    }
+
+    const auto storedPageSize = 1 << storedPageBits;
+    std::vector<std::uint16_t> codes ((size_t) (storedChannels * storedPageSize));
+    std::vector<std::uint16_t*> channels;
+
+    for (int ch = 0; ch < storedChannels; ++ch)
+        channels.push_back (codes.data() + ch * storedPageSize);
+
+    while (! in.isExhausted())
+    {
+        const auto storedPage = GhostCodec::decodePage (in, channels.data(), storedChannels, storedPageSize);
+
+        if (storedPage < 0)
+            return false;
+
+        // Indices are absolute, so a state saved with a different page size still lands in the right place
+        const auto firstIndex = (juce::int64) storedPage * storedPageSize;
+
+        if (firstIndex + storedPageSize - 1 > std::numeric_limits<int>::max())
+            return false;
+
+        allocateRange ((int) firstIndex, (int) (firstIndex + storedPageSize - 1));
+
+        for (int ch = 0; ch < juce::jmin (storedChannels, (int) numChannels); ++ch)
+            for (int i = 0; i < storedPageSize; ++i)
+                if (channels[(size_t) ch][i] != GhostCodec::noDataCode)
+                    writeCode (ch, (int) firstIndex + i, channels[(size_t) ch][i]);
+    }
+
+    return true;
+}
+
+//==============================================================================
+GhostPager::GhostPager() : juce::Thread ("Ghost Pager")
+{
+    startThread (juce::Thread::Priority::background);
+}
+
+GhostPager::~GhostPager()
+{
+    stopThread (1000);
+}
+
+void GhostPager::registerMap (GhostMap& map)
+{
+    const juce::ScopedLock sl (lock);
+    maps.addIfNotAlreadyThere (&map);
+}
+
+void GhostPager::unregisterMap (GhostMap& map)
+{
+    const juce::ScopedLock sl (lock);
+    maps.removeFirstMatchingValue (&map);
+}
+
+void GhostPager::registerLibrary (GhostLibrary& library)
+{
+    const juce::ScopedLock sl (lock);
+    libraries.addIfNotAlreadyThere (&library);
+}
+
+void GhostPager::unregisterLibrary (GhostLibrary& library)
+{
+    const juce::ScopedLock sl (lock);
+    libraries.removeFirstMatchingValue (&library);
+}
+
+void GhostPager::run()
+{
+    for (int pass = 0; ! threadShouldExit(); ++pass)
+    {
+        {
+            const juce::ScopedLock sl (lock);
+
+            // Keep the encoded state fresh a few times a second, so saving never has much to do
+            const bool refreshState = (pass % 25 == 0);
+
+            for (auto* map : maps)
+                map->servicePages();
+
+            if (refreshState)
+                for (auto* map : maps)
+                    map->refreshEncodedPages();
+
+            for (auto* library : libraries)
+                library->service (refreshState);
+        }
+
+        wait (10);
+    }
+}
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "GhostBackingStore.h"
+#include "GhostCodec.h"
+#include "GhostOverview.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+
+// ==========================================================
+// THE GHOST MAP
+// ==========================================================
+// Sparse, paged storage for a recorded Ghost ride. Every index is one tick of
+// the capture grid and holds one 16-bit log-domain GhostCodec code per
+// channel (16 KB per page).
+//
+// The grid is musical, so a Ghost follows the song, but how many ticks make a
+// quarter note is fixed per map from the tempo it was first recorded at: about
+// one index per millisecond whatever the tempo, so a 300 BPM ride doesn't
+// spend five times the memory of a 60 BPM one, nor the 60 BPM ride lose detail.
+//
+// Pages live behind a two-level table of atomic pointers so that reads and
+// writes from processBlock are O(1) and lock-free. Pages are only ever created
+// by the GhostPager background thread, around the index the audio thread last
+// published; the audio thread itself never allocates. A write that lands on a
+// page which doesn't exist yet is dropped, and a read from a missing page
+// simply reports "no data".
+//
+// For the plugin state, every page is kept run-length encoded by the pager in
+// the background, so saving a project only re-encodes the pages that
+// changed since the last pass. The pager keeps a GhostOverview up to date
+// the same way, for drawing.
+//
+// Pages live on the heap unless asked otherwise. For long programs they can
+// live in a memory-mapped scratch file instead (see setBackingFile), which
+// keeps RAM use bounded however long the program gets: the OS can drop any
+// page, and the pager keeps the ones around the playhead faulted in. A jump
+// can still land the audio thread on a dropped page before the pager gets
+// there, so file backing is opt-in.
+class GhostMap
+{
+public:
+    static constexpr int numChannels = 2;
+    static constexpr float noData = -1.0f;
+
+    static constexpr int pageBits = 12; // 4096 indices per page (~4 seconds)
+    static constexpr int pageSize = 1 << pageBits;
+    static constexpr int directoryBits = 10;
+    static constexpr int directorySize = 1 << directoryBits;
+    static constexpr int numDirectories = 1 << (31 - pageBits - directoryBits);
+
+    GhostMap() = default;
+    ~GhostMap();
+
+    // ==========================================================
+    // AUDIO THREAD
+    // ==========================================================
+    static bool isValidIndex (int index) noexcept { return index >= 0; }
+
+    std::uint16_t readCode (int channel, int index) const noexcept
+    {
+        if (auto* page = findPage (index))
+            return page->data[channel][index & (pageSize - 1)].load (std::memory_order_relaxed);
+
+        return GhostCodec::noDataCode;
+    }
+
+    // Returns false when the page holding this index hasn't been allocated yet.
+    bool writeCode (int channel, int index, std::uint16_t code) noexcept
+    {
+        if (auto* page = findPage (index))
+        {
+            page->data[channel][index & (pageSize - 1)].store (code, std::memory_order_relaxed);
+            page->version.fetch_add (1, std::memory_order_release);
+            return true;
+        }
+
+        return false;
+    }
+
+    // Linear level, or noData
+    float read (int channel, int index) const noexcept { return GhostCodec::fromCode (readCode (channel, index)); }
+    bool write (int channel, int index, float value) noexcept { return writeCode (channel, index, GhostCodec::toCode (value)); }
+
+    // Grid ticks per quarter note, or 0 while the map hasn't been given one
+    double getResolution() const noexcept { return resolution.load (std::memory_order_acquire); }
+
+    // Fixes the grid to proposed if the map doesn't have one yet. Returns the grid in effect.
+    double claimResolution (double proposed) noexcept
+    {
+        auto current = 0.0;
+        resolution.compare_exchange_strong (current, proposed, std::memory_order_acq_rel);
+        return getResolution();
+    }
+
+    // Tells the pager where the playhead is and whether pages need to exist there.
+    void publishPlayhead (int index, bool armedForWriting) noexcept
+    {
+        playheadIndex.store (index, std::memory_order_relaxed);
+        writeArmed.store (armedForWriting, std::memory_order_release);
+    }
+
+    // ==========================================================
+    // BACKGROUND / MESSAGE THREAD
+    // ==========================================================
+    // Allocates any missing pages around the published playhead. Called by the GhostPager.
+    void servicePages();
+
+    // Allocates the pages covering [firstIndex, lastIndex] right away.
+    void allocateRange (int firstIndex, int lastIndex);
+
+    // Marks every index as "no data" and forgets the grid. Pages stay allocated.
+    void clear();
+
+    // The grid a map first recorded at this tempo gets: indicesPerSecond, to the nearest tick
+    static constexpr double indicesPerSecond = 1000.0;
+    static constexpr double minResolution = 50.0;
+    static constexpr double maxResolution = 4000.0;
+    static constexpr double legacyResolution = 500.0; // the fixed grid of older states
+    static double resolutionFor (double bpm) noexcept;
+
+    // Puts pages allocated from here on in a memory-mapped scratch file, which is deleted with
+    // the map. Only the first call counts. If the file can't grow, pages go on the heap as usual.
+    void setBackingFile (const juce::File& file);
+    bool isFileBacked() const noexcept { return fileBacked.load (std::memory_order_acquire); }
+    size_t getBackingFileSize() const;
+
+    int getNumAllocatedPages() const noexcept { return numAllocatedPages.load(); }
+    size_t getMemoryUsageBytes() const noexcept { return (size_t) getNumAllocatedPages() * sizeof (Page); }
+
+    // ==========================================================
+    // STATE (MESSAGE / BACKGROUND THREAD)
+    // ==========================================================
+    // Writes the whole map in the GhostCodec format. Only pages changed since the pager's last
+    // refreshEncodedPages() pass get encoded here, so this stays quick however long the ride is.
+    void writeState (juce::MemoryOutputStream& out);
+
+    // Replaces the map's contents with a state written by writeState()
+    bool readState (const void* data, size_t sizeInBytes);
+
+    // Re-encodes pages that changed since the last pass. Called by the GhostPager.
+    void refreshEncodedPages();
+
+    // ==========================================================
+    // OVERVIEW (MESSAGE / BACKGROUND THREAD)
+    // ==========================================================
+    const GhostOverview& getOverview() const noexcept { return overview; }
+
+    // Summarises pages that changed since the last pass. Called by the GhostPager.
+    void refreshOverview();
+
+private:
+    struct Page
+    {
+        Page();
+        std::atomic<std::uint16_t> data[numChannels][pageSize];
+        std::atomic<std::uint32_t> version { 0 }; // bumped on every write
+    };
+
+    struct Directory
+    {
+        std::array<std::atomic<Page*>, directorySize> pages {};
+    };
+
+    static constexpr int pagesBehindPlayhead = 1;
+    static constexpr int pagesAheadOfPlayhead = 2;
+    static constexpr int codesPerMemoryPage = 4096 / (int) sizeof (std::uint16_t);
+
+    Page* findPage (int index) const noexcept
+    {
+        if (! isValidIndex (index))
+            return nullptr;
+
+        const auto pageNumber = index >> pageBits;
+
+        if (auto* dir = directories[(size_t) (pageNumber >> directoryBits)].load (std::memory_order_acquire))
+            return dir->pages[(size_t) (pageNumber & (directorySize - 1))].load (std::memory_order_acquire);
+
+        return nullptr;
+    }
+
+    void allocatePage (int pageNumber);
+
+    // Writes to one value in every memory page a page spans, so the OS has it mapped and writable
+    static void faultIn (Page& page) noexcept;
+
+    template <typename Callback>
+    void forEachPage (Callback&& callback) const
+    {
+        for (size_t dirIndex = 0; dirIndex < directories.size(); ++dirIndex)
+            if (auto* dir = directories[dirIndex].load (std::memory_order_acquire))
+                for (size_t pageIndex = 0; pageIndex < dir->pages.size(); ++pageIndex)
+                    if (auto* page = dir->pages[pageIndex].load (std::memory_order_acquire))
+                        callback ((int) ((dirIndex << directoryBits) | pageIndex), *page);
+    }
+
+    struct EncodedPage
+    {
+        std::uint32_t version { 0 };
+        juce::MemoryBlock data; // empty when the page holds no data
+    };
+
+    static EncodedPage encodePage (int pageNumber, const Page& page);
+
+    std::array<std::atomic<Directory*>, numDirectories> directories {};
+    std::atomic<int> numAllocatedPages { 0 };
+    juce::CriticalSection allocationLock; // never taken by the audio thread
+
+    std::unique_ptr<GhostBackingStore> backingStore; // guarded by allocationLock
+    std::atomic<bool> fileBacked { false };
+
+    std::map<int, EncodedPage> encodedPages;
+    juce::CriticalSection encodedPagesLock; // never taken by the audio thread
+
+    std::atomic<double> resolution { 0.0 };
+
+    std::atomic<int> playheadIndex { 0 };
+    std::atomic<bool> writeArmed { false };
+
+    GhostOverview overview { *this };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GhostMap)
+};
+
+// ==========================================================
+// THE GHOST PAGER
+// ==========================================================
+// One background thread shared by every plugin instance in the process
+// (hold it through a juce::SharedResourcePointer). It periodically walks the
+// registered maps and allocates pages ahead of each instance's playhead, and
+// services each GhostLibrary's slots the same way.
+class GhostLibrary;
+
+class GhostPager : private juce::Thread
+{
+public:
+    GhostPager();
+    ~GhostPager() override;
+
+    void registerMap (GhostMap& map);
+    void unregisterMap (GhostMap& map);
+
+    void registerLibrary (GhostLibrary& library);
+    void unregisterLibrary (GhostLibrary& library);
+
+private:
+    void run() override;
+
+    juce::CriticalSection lock;
+    juce::Array<GhostMap*> maps;
+    juce::Array<GhostLibrary*> libraries;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GhostPager)
+};
@@ -0,0 +1,220 @@
+#include "GhostOverview.h"
+#include "GhostMap.h"
+#include <cmath>
+
+static_assert (GhostMap::numChannels == 2 && GhostMap::pageBits == 12, "GhostOverview mirrors the GhostMap layout");
+
+//==============================================================================
+void GhostOverview::Node::add (std::uint16_t code) noexcept
+{
+    if (code == GhostCodec::noDataCode)
+        return;
+
+    minCode = std::min (minCode, code);
+    maxCode = std::max (maxCode, code);
+    ++count;
+    sum += code;
+}
+
+void GhostOverview::Node::add (const Node& other) noexcept
+{
+    if (other.count == 0)
+        return;
+
+    minCode = std::min (minCode, other.minCode);
+    maxCode = std::max (maxCode, other.maxCode);
+    count += other.count;
+    sum += other.sum;
+}
+
+GhostOverview::Summary GhostOverview::Node::toSummary() const noexcept
+{
+    if (count == 0)
+        return {};
+
+    const auto meanCode = (std::uint16_t) ((sum + count / 2) / count);
+    return { GhostCodec::fromCode (minCode), GhostCodec::fromCode (maxCode), GhostCodec::fromCode (meanCode) };
+}
+
+//==============================================================================
+GhostOverview::GhostOverview (const GhostMap& mapToSummarise) : map (mapToSummarise) {}
+GhostOverview::~GhostOverview() = default;
+
+GhostOverview::Node GhostOverview::getNode (int channel, int level, int bucket) const
+{
+    if (level < pageLevels)
+    {
+        const auto bucketBits = pageLevels - 1 - level;
+        const auto page = pages.find (bucket >> bucketBits);
+
+        if (page == pages.end())
+            return {};
+
+        return page->second->nodes[channel][levelOffset (level) + (bucket & ((1 << bucketBits) - 1))];
+    }
+
+    const auto& buckets = upperLevels[(size_t) level];
+    const auto found = buckets.find (bucket);
+    return found != buckets.end() ? found->second.channels[channel] : Node();
+}
+
+void GhostOverview::render (int channel, double firstIndex, double indicesPerPixel, Summary* pixels, int numPixels) const
+{
+    if (! juce::isPositiveAndBelow (channel, numChannels) || indicesPerPixel <= 0.0)
+        return;
+
+    // Closer in than a level 0 bucket there's nothing to summarise: read the codes themselves
+    if (indicesPerPixel < (double) leafSize)
+    {
+        for (int p = 0; p < numPixels; ++p)
+        {
+            const auto start = std::floor (firstIndex + p * indicesPerPixel);
+            const auto end = std::max (start + 1.0, std::floor (firstIndex + (p + 1) * indicesPerPixel));
+            Node node;
+
+            for (auto index = std::max (0.0, start); index < end; index += 1.0)
+                node.add (map.readCode (channel, (int) index));
+
+            pixels[p] = node.toSummary();
+        }
+
+        return;
+    }
+
+    const auto level = juce::jlimit (0, numLevels - 1, (int) std::floor (std::log2 (indicesPerPixel)) - leafBits);
+    const auto bucketSize = std::ldexp (1.0, leafBits + level);
+    const auto lastBucket = (double) (std::numeric_limits<int>::max() >> (leafBits + level));
+
+    const juce::ScopedLock sl (lock);
+
+    for (int p = 0; p < numPixels; ++p)
+    {
+        const auto first = std::max (0.0, std::floor ((firstIndex + p * indicesPerPixel) / bucketSize));
+        const auto end = std::min (lastBucket + 1.0, std::floor ((firstIndex + (p + 1) * indicesPerPixel) / bucketSize));
+        Node node;
+
+        for (auto bucket = first; bucket < end; bucket += 1.0)
+            node.add (getNode (channel, level, (int) bucket));
+
+        pixels[p] = node.toSummary();
+    }
+}
+
+juce::Range<int> GhostOverview::getIndexRange() const
+{
+    auto hasData = [] (const PageTree& tree, int node) {
+        for (auto& channel : tree.nodes)
+            if (channel[node].count > 0)
+                return true;
+
+        return false;
+    };
+
+    // Down to the level 0 bucket through the page trees, then the last few indices from the map
+    auto findEdge = [&] (const PageTree& tree, int pageNumber, bool fromStart) {
+        const auto leavesPerPage = 1 << (pageLevels - 1);
+
+        for (int n = 0; n < leavesPerPage; ++n)
+        {
+            const auto leaf = fromStart ? n : leavesPerPage - 1 - n;
+
+            if (! hasData (tree, leaf))
+                continue;
+
+            const auto leafStart = (pageNumber << pageBits) + (leaf << leafBits);
+
+            for (int i = 0; i < leafSize; ++i)
+            {
+                const auto index = leafStart + (fromStart ? i : leafSize - 1 - i);
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                    if (map.readCode (ch, index) != GhostCodec::noDataCode)
+                        return index;
+            }
+        }
+
+        return -1;
+    };
+
+    const juce::ScopedLock sl (lock);
+    const auto root = levelOffset (pageLevels - 1);
+    int first = -1, last = -1;
+
+    for (auto it = pages.begin(); it != pages.end() && first < 0; ++it)
+        if (hasData (*it->second, root))
+            first = findEdge (*it->second, it->first, true);
+
+    for (auto it = pages.rbegin(); it != pages.rend() && last < 0; ++it)
+        if (hasData (*it->second, root))
+            last = findEdge (*it->second, it->first, false);
+
+    return (first >= 0 && last >= first) ? juce::Range<int> (first, last + 1) : juce::Range<int>();
+}
+
+//==============================================================================
+bool GhostOverview::needsUpdate (int pageNumber, std::uint32_t pageVersion) const
+{
+    const juce::ScopedLock sl (lock);
+    const auto existing = pages.find (pageNumber);
+
+    // A page nobody has written to yet has nothing to show
+    if (existing == pages.end())
+        return pageVersion != 0;
+
+    return existing->second->version != pageVersion;
+}
+
+void GhostOverview::updatePage (int pageNumber, std::uint32_t pageVersion, const std::uint16_t* const* codes)
+{
+    // Build the page's tree without holding the lock, so drawing never waits on it
+    auto tree = std::make_unique<PageTree>();
+    tree->version = pageVersion;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* nodes = tree->nodes[ch];
+
+        for (int leaf = 0; leaf < (1 << (pageLevels - 1)); ++leaf)
+            for (int i = 0; i < leafSize; ++i)
+                nodes[leaf].add (codes[ch][(leaf << leafBits) + i]);
+
+        for (int level = 1; level < pageLevels; ++level)
+        {
+            const auto* children = nodes + levelOffset (level - 1);
+            auto* parents = nodes + levelOffset (level);
+
+            for (int n = 0; n < (1 << (pageLevels - 1 - level)); ++n)
+            {
+                parents[n].add (children[2 * n]);
+                parents[n].add (children[2 * n + 1]);
+            }
+        }
+    }
+
+    const juce::ScopedLock sl (lock);
+    pages[pageNumber] = std::move (tree);
+    updateUpperLevels (pageNumber);
+    version.fetch_add (1, std::memory_order_release);
+}
+
+void GhostOverview::updateUpperLevels (int pageNumber)
+{
+    for (int level = pageLevels; level < numLevels; ++level)
+    {
+        const auto bucket = pageNumber >> (level - pageLevels + 1);
+        Bucket combined;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            combined.channels[ch].add (getNode (ch, level - 1, 2 * bucket));
+            combined.channels[ch].add (getNode (ch, level - 1, 2 * bucket + 1));
+        }
+
+        auto& buckets = upperLevels[(size_t) level];
+
+        if (combined.channels[0].count + combined.channels[1].count > 0)
+            buckets[bucket] = combined;
+        else
+            buckets.erase (bucket);
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+
+class GhostMap;
+
+// ==========================================================
+// THE GHOST OVERVIEW
+// ==========================================================
+// A min/max/mean pyramid over a GhostMap, so the editor can draw a Ghost at
+// any zoom level in O(pixels) however long the take is.
+//
+// Level 0 summarises buckets of 64 indices, and every level above halves the
+// number of buckets. The levels that fit inside one GhostMap page are kept as
+// a small tree per page; the levels above that are sparse, keyed by bucket.
+// Everything is kept in GhostCodec codes, so min and max are exact and the
+// mean is taken in the log domain, which is what a dB display wants anyway.
+//
+// The GhostPager keeps it up to date as recording proceeds: only pages whose
+// version changed since the last pass get summarised again, and each of
+// those costs a walk up the pyramid. The audio thread never touches it.
+class GhostOverview
+{
+public:
+    static constexpr int leafBits = 6; // 64 indices per level 0 bucket
+    static constexpr int leafSize = 1 << leafBits;
+
+    explicit GhostOverview (const GhostMap& mapToSummarise);
+    ~GhostOverview();
+
+    // Linear levels, GhostMap::noData when there's nothing in range
+    struct Summary
+    {
+        float minimum { -1.0f };
+        float maximum { -1.0f };
+        float mean { -1.0f };
+
+        bool hasData() const noexcept { return maximum >= 0.0f; }
+    };
+
+    // ==========================================================
+    // MESSAGE THREAD
+    // ==========================================================
+    // One Summary per pixel, pixel p covering [firstIndex + p * indicesPerPixel, firstIndex + (p + 1) * indicesPerPixel).
+    // Pixel edges snap to the coarsest buckets no wider than a pixel, so each pixel combines at most
+    // three of them; zoomed in further than a level 0 bucket, the map itself is read.
+    void render (int channel, double firstIndex, double indicesPerPixel, Summary* pixels, int numPixels) const;
+
+    // The indices holding any data, or an empty range
+    juce::Range<int> getIndexRange() const;
+
+    // Changes whenever the overview does, so a view knows when to repaint
+    std::uint32_t getVersion() const noexcept { return version.load (std::memory_order_acquire); }
+
+    // ==========================================================
+    // BACKGROUND
+    // ==========================================================
+    // True when the page has changed since it was last summarised
+    bool needsUpdate (int pageNumber, std::uint32_t pageVersion) const;
+
+    // Summarises one GhostMap page from its codes[channel][index], and everything above it
+    void updatePage (int pageNumber, std::uint32_t pageVersion, const std::uint16_t* const* codes);
+
+private:
+    struct Node
+    {
+        std::uint16_t minCode { 0xffff };
+        std::uint16_t maxCode { 0 };
+        std::uint32_t count { 0 };
+        std::uint64_t sum { 0 };
+
+        void add (std::uint16_t code) noexcept;
+        void add (const Node& other) noexcept;
+        Summary toSummary() const noexcept;
+    };
+
+    // numChannels and pageBits mirror GhostMap, checked in the .cpp
+    static constexpr int numChannels = 2;
+    static constexpr int pageBits = 12;
+    static constexpr int pageLevels = pageBits - leafBits + 1; // level pageLevels - 1 is the whole page
+    static constexpr int numLevels = 32 - leafBits; // the top bucket covers every index
+    static constexpr int nodesPerPage = (1 << pageLevels) - 1;
+
+    // Where a level's buckets start in a page tree: 64 leaves, then 32 parents, ... then the root
+    static constexpr int levelOffset (int level) noexcept { return (1 << pageLevels) - (1 << (pageLevels - level)); }
+
+    struct PageTree
+    {
+        std::uint32_t version { 0 };
+        Node nodes[numChannels][nodesPerPage];
+    };
+
+    struct Bucket
+    {
+        Node channels[numChannels];
+    };
+
+    Node getNode (int channel, int level, int bucket) const;
+    void updateUpperLevels (int pageNumber);
+
+    const GhostMap& map;
+
+    std::map<int, std::unique_ptr<PageTree>> pages;
+    std::array<std::map<int, Bucket>, numLevels> upperLevels; // only levels >= pageLevels are used
+    juce::CriticalSection lock; // never taken by the audio thread
+
+    std::atomic<std::uint32_t> version { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GhostOverview)
+};
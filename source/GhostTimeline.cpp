@@ -0,0 +1,151 @@
+#include "GhostTimeline.h"
+
+GhostTimeline::GhostTimeline (GhostLibrary& libraryToShow) : library (libraryToShow) {}
+
+const GhostMap* GhostTimeline::getShownMap() const
+{
+    return library.getSlot (library.getActiveSlot());
+}
+
+void GhostTimeline::refresh()
+{
+    const auto* map = getShownMap();
+    const auto version = map != nullptr ? map->getOverview().getVersion() : 0;
+
+    if (map == shownMap && version == shownVersion)
+        return;
+
+    if (map != shownMap)
+        fitting = true;
+
+    shownMap = map;
+    shownVersion = version;
+
+    if (fitting)
+        fitToTake();
+
+    repaint();
+}
+
+void GhostTimeline::fitToTake()
+{
+    const auto* map = getShownMap();
+    const auto range = map != nullptr ? map->getOverview().getIndexRange() : juce::Range<int>();
+
+    if (range.isEmpty() || getWidth() <= 0)
+        return;
+
+    firstIndex = range.getStart();
+    indicesPerPixel = juce::jmax (minIndicesPerPixel, (double) range.getLength() / getWidth());
+}
+
+float GhostTimeline::levelToY (float level, juce::Rectangle<float> area) const
+{
+    const auto db = juce::Decibels::gainToDecibels (level, floorDb);
+    return juce::jmap (juce::jlimit (floorDb, ceilingDb, db), floorDb, ceilingDb, area.getBottom(), area.getY());
+}
+
+void GhostTimeline::paint (juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+
+    g.setColour (juce::Colour (0xff0a0a0a));
+    g.fillRect (bounds);
+    g.setColour (juce::Colour (0xff333333));
+    g.drawRect (bounds, 1.0f);
+
+    const auto* map = getShownMap();
+    const auto area = bounds.reduced (2.0f);
+    const auto numPixels = (int) area.getWidth();
+
+    if (map == nullptr || numPixels <= 0)
+    {
+        g.setColour (juce::Colour (0xff555555));
+        g.setFont (juce::FontOptions (10.0f).withStyle ("Bold"));
+        g.drawText ("NO GHOST", bounds, juce::Justification::centred);
+        return;
+    }
+
+    for (int ch = 0; ch < GhostMap::numChannels; ++ch)
+    {
+        pixels[ch].resize ((size_t) numPixels);
+        map->getOverview().render (ch, firstIndex, indicesPerPixel, pixels[ch].data(), numPixels);
+    }
+
+    // 0 dB reference
+    g.setColour (juce::Colour (0xff333333));
+    g.drawHorizontalLine ((int) levelToY (1.0f, area), area.getX(), area.getRight());
+
+    juce::Path meanLine;
+    bool lineStarted = false;
+
+    for (int x = 0; x < numPixels; ++x)
+    {
+        const auto& left = pixels[0][(size_t) x];
+        const auto& right = pixels[1][(size_t) x];
+
+        if (! left.hasData() && ! right.hasData())
+        {
+            lineStarted = false;
+            continue;
+        }
+
+        // Both channels in one envelope: the widest range, and the mean of whichever have data
+        auto minimum = juce::jmax (left.minimum, right.minimum);
+        auto maximum = juce::jmax (left.maximum, right.maximum);
+        auto mean = juce::jmax (left.mean, right.mean);
+
+        if (left.hasData() && right.hasData())
+        {
+            minimum = juce::jmin (left.minimum, right.minimum);
+            mean = 0.5f * (left.mean + right.mean);
+        }
+
+        const auto px = area.getX() + (float) x + 0.5f;
+        g.setColour (juce::Colours::lime.withAlpha (0.35f));
+        g.drawVerticalLine ((int) px, levelToY (maximum, area), levelToY (minimum, area) + 1.0f);
+
+        const auto meanY = levelToY (mean, area);
+
+        if (lineStarted)
+            meanLine.lineTo (px, meanY);
+        else
+            meanLine.startNewSubPath (px, meanY);
+
+        lineStarted = true;
+    }
+
+    g.setColour (juce::Colours::lime);
+    g.strokePath (meanLine, juce::PathStrokeType (1.0f));
+}
+
+void GhostTimeline::mouseDown (const juce::MouseEvent&)
+{
+    dragStartIndex = firstIndex;
+}
+
+void GhostTimeline::mouseDrag (const juce::MouseEvent& e)
+{
+    fitting = false;
+    firstIndex = juce::jmax (0.0, dragStartIndex - e.getDistanceFromDragStartX() * indicesPerPixel);
+    repaint();
+}
+
+void GhostTimeline::mouseDoubleClick (const juce::MouseEvent&)
+{
+    fitting = true;
+    fitToTake();
+    repaint();
+}
+
+void GhostTimeline::mouseWheelMove (const juce::MouseEvent& e, const juce::MouseWheelDetails& wheel)
+{
+    // Keep the index under the pointer where it is
+    const auto anchor = firstIndex + e.position.x * indicesPerPixel;
+    const auto maxIndicesPerPixel = (double) std::numeric_limits<int>::max() / juce::jmax (1, getWidth());
+
+    fitting = false;
+    indicesPerPixel = juce::jlimit (minIndicesPerPixel, maxIndicesPerPixel, indicesPerPixel * std::pow (2.0, -4.0 * wheel.deltaY));
+    firstIndex = juce::jmax (0.0, anchor - e.position.x * indicesPerPixel);
+    repaint();
+}
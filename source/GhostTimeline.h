@@ -0,0 +1,55 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "GhostLibrary.h"
+#include <vector>
+
+// ==========================================================
+// THE GHOST TIMELINE
+// ==========================================================
+// Draws the active Ghost slot as a zoomable min/max/mean envelope, straight
+// from its GhostOverview, so a repaint costs the same whether the take is a
+// bar or 90 minutes long.
+//
+// It fits the whole take until the user zooms (mouse wheel, around the
+// pointer) or scrolls (drag); a double-click goes back to fitting. The
+// editor's timer calls refresh(), which only repaints when the slot or its
+// overview actually changed.
+class GhostTimeline : public juce::Component
+{
+public:
+    explicit GhostTimeline (GhostLibrary& libraryToShow);
+
+    void refresh();
+
+    void paint (juce::Graphics&) override;
+    void mouseDown (const juce::MouseEvent&) override;
+    void mouseDrag (const juce::MouseEvent&) override;
+    void mouseDoubleClick (const juce::MouseEvent&) override;
+    void mouseWheelMove (const juce::MouseEvent&, const juce::MouseWheelDetails&) override;
+
+private:
+    static constexpr float floorDb = -60.0f;
+    static constexpr float ceilingDb = 6.0f;
+    static constexpr double minIndicesPerPixel = 1.0;
+
+    const GhostMap* getShownMap() const;
+    void fitToTake();
+    float levelToY (float level, juce::Rectangle<float> area) const;
+
+    GhostLibrary& library;
+
+    // Only compared, never followed: what was on screen at the last refresh()
+    const GhostMap* shownMap { nullptr };
+    std::uint32_t shownVersion { 0 };
+
+    bool fitting { true };
+    double firstIndex { 0.0 };
+    double indicesPerPixel { 500.0 };
+    double dragStartIndex { 0.0 };
+
+    std::vector<GhostOverview::Summary> pixels[2];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GhostTimeline)
+};
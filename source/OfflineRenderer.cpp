@@ -0,0 +1,285 @@
+#include "OfflineRenderer.h"
+#include <algorithm>
+
+namespace
+{
+    constexpr int numBusChannels = 2; // main and sidechain are both stereo
+
+    juce::Result readBlock (juce::AudioFormatReader& reader, juce::AudioBuffer<float>& block, int firstChannel, juce::int64 position)
+    {
+        // A mono file feeds both channels of its bus
+        float* const channels[] { block.getWritePointer (firstChannel), block.getWritePointer (firstChannel + 1) };
+        const auto numFileChannels = (int) reader.numChannels;
+
+        if (! reader.read (channels, numFileChannels, position, block.getNumSamples()))
+            return juce::Result::fail ("Reading failed at sample " + juce::String (position));
+
+        if (numFileChannels == 1)
+            block.copyFrom (firstChannel + 1, 0, block, firstChannel, 0, block.getNumSamples());
+
+        return juce::Result::ok();
+    }
+
+    juce::Result checkReader (const juce::AudioFormatReader* reader, const juce::File& file)
+    {
+        if (reader == nullptr)
+            return juce::Result::fail ("Can't read " + file.getFullPathName() + " as audio");
+
+        if (reader->numChannels < 1 || reader->numChannels > 2)
+            return juce::Result::fail (file.getFileName() + " isn't mono or stereo");
+
+        if (reader->sampleRate <= 0.0)
+            return juce::Result::fail (file.getFileName() + " has no sample rate");
+
+        return juce::Result::ok();
+    }
+}
+
+//==============================================================================
+// Runs one piece of file I/O at a time alongside the render, so reading and writing overlap processing
+class OfflineRenderer::IOThread : private juce::Thread
+{
+public:
+    IOThread() : juce::Thread ("Render I/O")
+    {
+        startThread();
+    }
+
+    ~IOThread() override
+    {
+        signalThreadShouldExit();
+        workReady.signal();
+        stopThread (-1);
+    }
+
+    void begin (std::function<void()> work)
+    {
+        task = std::move (work);
+        workReady.signal();
+    }
+
+    void finish()
+    {
+        workDone.wait (-1);
+    }
+
+private:
+    void run() override
+    {
+        for (;;)
+        {
+            workReady.wait (-1);
+
+            if (threadShouldExit())
+                return;
+
+            task();
+            workDone.signal();
+        }
+    }
+
+    std::function<void()> task;
+    juce::WaitableEvent workReady, workDone;
+};
+
+//==============================================================================
+OfflineRenderer::OfflineRenderer()
+    : io (std::make_unique<IOThread>())
+{
+    formats.registerBasicFormats();
+
+    processor.setNonRealtime (true);
+    processor.setPlayHead (&playHead);
+}
+
+OfflineRenderer::~OfflineRenderer()
+{
+    processor.setPlayHead (nullptr);
+}
+
+juce::Result OfflineRenderer::checkSettings (const Settings& settings) const
+{
+    if (! (settings.bpm > 0.0))
+        return juce::Result::fail ("The tempo must be above 0 BPM");
+
+    if (settings.mode < 0 || settings.mode > 3)
+        return juce::Result::fail ("The mode must be 0 to 3 (off, VOX, SPACE, PUNCH)");
+
+    if (settings.shredMode < 0 || settings.shredMode > 3)
+        return juce::Result::fail ("The SHRED mode must be 0 (off) to 3");
+
+    const auto& chopRange = processor.parameters.chopThreshold.range;
+
+    if (settings.chopThreshold != 0.0f && ! (settings.chopThreshold >= chopRange.start && settings.chopThreshold <= chopRange.end))
+        return juce::Result::fail ("The CHOP threshold must be 0 (off) or " + juce::String (chopRange.start) + " to " + juce::String (chopRange.end));
+
+    if (std::find (std::begin (PluginParameters::ratios), std::end (PluginParameters::ratios), settings.ratio) == std::end (PluginParameters::ratios))
+        return juce::Result::fail ("The ratio must be 1, 3, 6 or 9");
+
+    if (settings.blockSize < 1)
+        return juce::Result::fail ("The block size must be at least 1 sample");
+
+    return juce::Result::ok();
+}
+
+void OfflineRenderer::applySettings (const Settings& settings, bool hasSidechain)
+{
+    auto& parameters = processor.parameters;
+    parameters.resetToDefaults();
+
+    parameters.mode = settings.mode;
+    parameters.flip = settings.flip;
+    parameters.shred = settings.shredMode > 0;
+    parameters.shredMode = juce::jmax (0, settings.shredMode - 1);
+    parameters.chop = settings.chopThreshold > 0.0f;
+
+    if (settings.chopThreshold > 0.0f)
+        parameters.chopThreshold = settings.chopThreshold;
+
+    const auto* ratio = std::find (std::begin (PluginParameters::ratios), std::end (PluginParameters::ratios), settings.ratio);
+    parameters.ratio = (int) (ratio - std::begin (PluginParameters::ratios));
+    parameters.externalSidechain = hasSidechain;
+
+    processor.setLookaheadEnabled (settings.lookahead);
+}
+
+juce::Result OfflineRenderer::render (const Job& job)
+{
+    const auto& settings = job.settings;
+
+    if (auto checked = checkSettings (settings); checked.failed())
+        return checked;
+
+    std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (job.input));
+
+    if (auto checked = checkReader (reader.get(), job.input); checked.failed())
+        return checked;
+
+    std::unique_ptr<juce::AudioFormatReader> sidechainReader;
+    const auto hasSidechain = job.sidechain != juce::File();
+
+    if (hasSidechain)
+    {
+        sidechainReader.reset (formats.createReaderFor (job.sidechain));
+
+        if (auto checked = checkReader (sidechainReader.get(), job.sidechain); checked.failed())
+            return checked;
+
+        if (sidechainReader->sampleRate != reader->sampleRate)
+            return juce::Result::fail (job.sidechain.getFileName() + " isn't at the same sample rate as " + job.input.getFileName());
+    }
+
+    const auto sampleRate = reader->sampleRate;
+    const auto length = reader->lengthInSamples;
+    const auto numOutputChannels = (int) reader->numChannels;
+
+    if (auto created = job.output.getParentDirectory().createDirectory(); created.failed())
+        return created;
+
+    // Written next to the output and moved over it at the end, so a failed render leaves nothing half-written
+    juce::TemporaryFile temporary (job.output);
+    std::unique_ptr<juce::OutputStream> stream (temporary.getFile().createOutputStream());
+
+    if (stream == nullptr)
+        return juce::Result::fail ("Can't write to " + job.output.getFullPathName());
+
+    const auto options = juce::AudioFormatWriterOptions {}
+                             .withSampleRate (sampleRate)
+                             .withNumChannels (numOutputChannels)
+                             .withBitsPerSample ((int) reader->bitsPerSample)
+                             .withSampleFormat (reader->usesFloatingPointData ? juce::AudioFormatWriterOptions::SampleFormat::floatingPoint
+                                                                              : juce::AudioFormatWriterOptions::SampleFormat::integral);
+
+    auto writer = juce::WavAudioFormat().createWriterFor (stream, options);
+
+    if (writer == nullptr)
+        return juce::Result::fail ("Can't write " + juce::String (reader->bitsPerSample) + "-bit WAV at " + juce::String (sampleRate) + " Hz");
+
+    // The plugin comes up fresh for every file: parameters from the job, followers from silence
+    applySettings (settings, hasSidechain);
+    processor.prepareToPlay (sampleRate, settings.blockSize);
+
+    playHead = SyntheticPlayHead {};
+    playHead.sampleRate = sampleRate;
+    playHead.bpm = settings.bpm;
+
+    for (auto& half : buffers)
+        half.setSize (2 * numBusChannels, juce::jmax (half.getNumSamples(), settings.blockSize), false, false, true);
+
+    // With lookahead, the output runs latency samples behind: render that much further, drop that much from the front
+    const auto latency = (juce::int64) processor.getLatencySamples();
+    const auto totalSamples = length + latency;
+    const auto numBlocks = (totalSamples + settings.blockSize - 1) / settings.blockSize;
+
+    // Block k lives in buffers[k % 2], from its read through to its write
+    const auto blockFor = [&] (juce::int64 k) {
+        auto& half = buffers[k % 2];
+        const auto n = (int) std::min<juce::int64> (settings.blockSize, totalSamples - k * settings.blockSize);
+        return juce::AudioBuffer<float> (half.getArrayOfWritePointers(), half.getNumChannels(), n);
+    };
+
+    const auto read = [&] (juce::int64 k) {
+        auto block = blockFor (k);
+        const auto position = k * settings.blockSize;
+
+        if (auto readMain = readBlock (*reader, block, 0, position); readMain.failed())
+            return readMain;
+
+        if (sidechainReader != nullptr)
+            return readBlock (*sidechainReader, block, numBusChannels, position);
+
+        for (int ch = numBusChannels; ch < block.getNumChannels(); ++ch)
+            block.clear (ch, 0, block.getNumSamples());
+
+        return juce::Result::ok();
+    };
+
+    const auto write = [&] (juce::int64 k) {
+        const auto block = blockFor (k);
+        const auto skip = (int) juce::jlimit<juce::int64> (0, block.getNumSamples(), latency - k * settings.blockSize);
+
+        if (skip < block.getNumSamples() && ! writer->writeFromAudioSampleBuffer (block, skip, block.getNumSamples() - skip))
+            return juce::Result::fail ("Writing " + job.output.getFullPathName() + " failed");
+
+        return juce::Result::ok();
+    };
+
+    auto result = numBlocks > 0 ? read (0) : juce::Result::ok();
+
+    for (juce::int64 k = 0; k < numBlocks && result.wasOk(); ++k)
+    {
+        // While block k is processed, the I/O thread writes block k - 1 and reads block k + 1 into the same half
+        auto ioResult = juce::Result::ok();
+
+        io->begin ([&, k] {
+            if (k > 0)
+                ioResult = write (k - 1);
+
+            if (ioResult.wasOk() && k + 1 < numBlocks)
+                ioResult = read (k + 1);
+        });
+
+        auto block = blockFor (k);
+        processor.processBlock (block, midi);
+        playHead.advance (block.getNumSamples());
+
+        io->finish();
+        result = ioResult;
+    }
+
+    if (result.wasOk() && numBlocks > 0)
+        result = write (numBlocks - 1);
+
+    processor.releaseResources();
+    writer.reset();
+
+    if (result.failed())
+        return result;
+
+    if (! temporary.overwriteTargetFileWithTemporary())
+        return juce::Result::fail ("Can't replace " + job.output.getFullPathName());
+
+    lastLength = length;
+    lastSampleRate = sampleRate;
+    return juce::Result::ok();
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "PluginProcessor.h"
+#include "SyntheticPlayHead.h"
+
+// ==========================================================
+// THE OFFLINE RENDERER
+// ==========================================================
+// Runs an audio file through a PluginProcessor outside a host, as fast as the
+// CPU allows. The file streams through processBlock in large blocks, with a
+// SyntheticPlayHead playing from the top at a fixed tempo, and is written out
+// at its own length, rate, channel count and bit depth. Lookahead latency is
+// compensated, so the output lines up with the input sample for sample.
+//
+// An optional sidechain file feeds the sidechain bus and turns EXT on. Where
+// it is shorter than the input, it goes silent.
+//
+// File I/O overlaps the processing: while one block goes through the plugin,
+// a thread of the renderer's own writes out the block before it and reads in
+// the block after. A renderer keeps its processor, buffers and that thread
+// from one file to the next, so a batch pays for them once. It is not
+// thread-safe: one renderer per thread.
+class OfflineRenderer
+{
+public:
+    struct Settings
+    {
+        double bpm { 120.0 };
+        int mode { 1 };               // 0 = off, 1 = VOX, 2 = SPACE, 3 = PUNCH
+        bool flip { false };
+        int shredMode { 0 };          // 0 = off, 1..3
+        float chopThreshold { 0.0f }; // 0 = CHOP off
+        int ratio { 1 };              // 1, 3, 6 or 9
+        bool lookahead { false };
+        int blockSize { 8192 };
+    };
+
+    struct Job
+    {
+        juce::File input;
+        juce::File sidechain; // none if juce::File{}: the guide is then the input
+        juce::File output;    // always WAV; replaced only once the render has succeeded
+        Settings settings;
+    };
+
+    OfflineRenderer();
+    ~OfflineRenderer();
+
+    // Renders one job. Blocking.
+    juce::Result render (const Job& job);
+
+    // The length of the last file rendered successfully, in samples and seconds
+    juce::int64 getLastLengthInSamples() const noexcept { return lastLength; }
+    double getLastLengthInSeconds() const noexcept { return lastSampleRate > 0.0 ? (double) lastLength / lastSampleRate : 0.0; }
+
+private:
+    juce::Result checkSettings (const Settings& settings) const;
+    void applySettings (const Settings& settings, bool hasSidechain);
+
+    juce::AudioFormatManager formats;
+    PluginProcessor processor;
+    SyntheticPlayHead playHead;
+
+    // Two blocks of main then sidechain channels, as processBlock takes them: one being processed
+    // while the other is written out and refilled. Grown to the largest block seen, then reused.
+    juce::AudioBuffer<float> buffers[2];
+    juce::MidiBuffer midi;
+
+    class IOThread;
+    std::unique_ptr<IOThread> io;
+
+    juce::int64 lastLength { 0 };
+    double lastSampleRate { 0.0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfflineRenderer)
+};
@@ -20,28 +20,17 @@ PluginEditor::PluginEditor (PluginProcessor& p)
     spaceButton.setLookAndFeel(&vintageLookAndFeel);
     punchButton.setLookAndFeel(&vintageLookAndFeel);
 
-    voxButton.onClick = [this] {
-        if (voxButton.getToggleState()) {
-            spaceButton.setToggleState(false, juce::dontSendNotification);
-            punchButton.setToggleState(false, juce::dontSendNotification);
-            processorRef.currentMode.store(1);
-        } else { processorRef.currentMode.store(0); }
-    };
-    spaceButton.onClick = [this] {
-        if (spaceButton.getToggleState()) {
-            voxButton.setToggleState(false, juce::dontSendNotification);
-            punchButton.setToggleState(false, juce::dontSendNotification);
-            processorRef.currentMode.store(2);
-        } else { processorRef.currentMode.store(0); }
-    };
-    punchButton.onClick = [this] {
-        if (punchButton.getToggleState()) {
-            voxButton.setToggleState(false, juce::dontSendNotification);
-            spaceButton.setToggleState(false, juce::dontSendNotification);
-            processorRef.currentMode.store(3);
-        } else { processorRef.currentMode.store(0); }
+    // Switching a mode on turns the others off; switching it off leaves the engine off
+    auto modeClick = [this](int m, juce::ToggleButton* btn) {
+        modeAttachment.setValueAsCompleteGesture(btn->getToggleState() ? (float) m : 0.0f);
+        showMode(processorRef.parameters.mode.getIndex());
     };
 
+    voxButton.onClick = [this, modeClick] { modeClick(1, &voxButton); };
+    spaceButton.onClick = [this, modeClick] { modeClick(2, &spaceButton); };
+    punchButton.onClick = [this, modeClick] { modeClick(3, &punchButton); };
+    modeAttachment.sendInitialUpdate();
+
     addAndMakeVisible(voxButton);
     addAndMakeVisible(spaceButton);
     addAndMakeVisible(punchButton);
@@ -53,16 +42,7 @@ PluginEditor::PluginEditor (PluginProcessor& p)
     shredButton.setLookAndFeel(&purpleLookAndFeel);
     chopButton.setLookAndFeel(&purpleLookAndFeel);
 
-    flipButton.onClick = [this] {
-        processorRef.isFlipActive.store(flipButton.getToggleState());
-    };
-    shredButton.onClick = [this] {
-        processorRef.isShredActive.store(shredButton.getToggleState());
-    };
-    chopButton.onClick = [this] {
-        processorRef.isChopActive.store(chopButton.getToggleState());
-    };
-
+    // Wired straight to their parameters by ButtonParameterAttachments
     addAndMakeVisible(flipButton);
     addAndMakeVisible(shredButton);
     addAndMakeVisible(chopButton);
@@ -74,22 +54,17 @@ PluginEditor::PluginEditor (PluginProcessor& p)
     shredMode2.setLookAndFeel(&miniPurpleLookAndFeel);
     shredMode3.setLookAndFeel(&miniPurpleLookAndFeel);
 
-    shredMode1.setToggleState(true, juce::dontSendNotification);
-
+    // One of the three is always on: clicking the lit one leaves it lit
     auto shredModeClick = [this](int m, juce::ToggleButton* btn) {
-        if (btn->getToggleState()) {
-            if (btn != &shredMode1) shredMode1.setToggleState(false, juce::dontSendNotification);
-            if (btn != &shredMode2) shredMode2.setToggleState(false, juce::dontSendNotification);
-            if (btn != &shredMode3) shredMode3.setToggleState(false, juce::dontSendNotification);
-            processorRef.currentShredMode.store(m);
-        } else {
-            btn->setToggleState(true, juce::dontSendNotification);
-        }
+        if (btn->getToggleState())
+            shredModeAttachment.setValueAsCompleteGesture((float) (m - 1));
+        showShredMode(processorRef.parameters.shredMode.getIndex());
     };
 
     shredMode1.onClick = [this, shredModeClick] { shredModeClick(1, &shredMode1); };
     shredMode2.onClick = [this, shredModeClick] { shredModeClick(2, &shredMode2); };
     shredMode3.onClick = [this, shredModeClick] { shredModeClick(3, &shredMode3); };
+    shredModeAttachment.sendInitialUpdate();
 
     addAndMakeVisible(shredMode1);
     addAndMakeVisible(shredMode2);
@@ -100,12 +75,7 @@ PluginEditor::PluginEditor (PluginProcessor& p)
     // ==========================================================
     chopSlider.setLookAndFeel(&chopKnobLookAndFeel);
     chopSlider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
-    chopSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
-    chopSlider.setRange(0.01, 0.80, 0.01); 
-    chopSlider.setValue(0.10); // Default to our old hardcoded 10%
-    chopSlider.onValueChange = [this] {
-        processorRef.chopThreshold.store(static_cast<float>(chopSlider.getValue()));
-    };
+    chopSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0); // range and value come from its attachment
     addAndMakeVisible(chopSlider);
 
     // ==========================================================
@@ -116,25 +86,17 @@ PluginEditor::PluginEditor (PluginProcessor& p)
     ratio6Button.setLookAndFeel(&ratioLookAndFeel);
     ratio9Button.setLookAndFeel(&ratioLookAndFeel);
 
-    ratio1Button.setToggleState(true, juce::dontSendNotification); // Default
-
-    auto ratioClick = [this](int r, juce::ToggleButton* btn) {
-        if (btn->getToggleState()) {
-            if (btn != &ratio1Button) ratio1Button.setToggleState(false, juce::dontSendNotification);
-            if (btn != &ratio3Button) ratio3Button.setToggleState(false, juce::dontSendNotification);
-            if (btn != &ratio6Button) ratio6Button.setToggleState(false, juce::dontSendNotification);
-            if (btn != &ratio9Button) ratio9Button.setToggleState(false, juce::dontSendNotification);
-            processorRef.currentRatio.store(r);
-        } else {
-            ratio1Button.setToggleState(true, juce::dontSendNotification);
-            processorRef.currentRatio.store(1);
-        }
+    // Switching a ratio off falls back to 1:1
+    auto ratioClick = [this](int index, juce::ToggleButton* btn) {
+        ratioAttachment.setValueAsCompleteGesture(btn->getToggleState() ? (float) index : 0.0f);
+        showRatio(processorRef.parameters.ratio.getIndex());
     };
 
-    ratio1Button.onClick = [this, ratioClick] { ratioClick(1, &ratio1Button); };
-    ratio3Button.onClick = [this, ratioClick] { ratioClick(3, &ratio3Button); };
-    ratio6Button.onClick = [this, ratioClick] { ratioClick(6, &ratio6Button); };
-    ratio9Button.onClick = [this, ratioClick] { ratioClick(9, &ratio9Button); };
+    ratio1Button.onClick = [this, ratioClick] { ratioClick(0, &ratio1Button); };
+    ratio3Button.onClick = [this, ratioClick] { ratioClick(1, &ratio3Button); };
+    ratio6Button.onClick = [this, ratioClick] { ratioClick(2, &ratio6Button); };
+    ratio9Button.onClick = [this, ratioClick] { ratioClick(3, &ratio9Button); };
+    ratioAttachment.sendInitialUpdate();
 
     addAndMakeVisible(ratio1Button);
     addAndMakeVisible(ratio3Button);
@@ -147,13 +109,37 @@ PluginEditor::PluginEditor (PluginProcessor& p)
     chunkyA.setLookAndFeel(&rockerLookAndFeel);
     chunkyB.setLookAndFeel(&rockerLookAndFeel);
     
-    ghostSelector.addItem("Slot 1: Unused", 1);
-    ghostSelector.addItem("Slot 2: Unused", 2);
-    ghostSelector.addItem("Slot 3: Unused", 3);
-    ghostSelector.setSelectedId(1, juce::dontSendNotification);
+    for (int slot = 0; slot < GhostLibrary::numSlots; ++slot)
+        ghostSelector.addItem("Slot " + juce::String(slot + 1) + ": Unused", slot + 1);
+    refreshGhostSlots();
+
+    // Switching slots just publishes the other Ghost to the audio thread, even mid-playback
+    ghostSelector.onChange = [this] {
+        processorRef.ghostLibrary.selectSlot(ghostSelector.getSelectedId() - 1);
+    };
     
     saveGhostButton.setColour(juce::TextButton::buttonColourId, juce::Colour(0xff333333));
     saveGhostButton.setColour(juce::TextButton::textColourOffId, juce::Colours::white);
+
+    // FREEZE: replays the fader captured on the last Ghost read passes instead of riding live
+    freezeButton.setClickingTogglesState(true);
+    freezeButton.setToggleState(processorRef.isFrozen.load(), juce::dontSendNotification);
+    freezeButton.setColour(juce::TextButton::buttonColourId, juce::Colour(0xff333333));
+    freezeButton.setColour(juce::TextButton::buttonOnColourId, juce::Colour(0xff3a6ea5));
+    freezeButton.setColour(juce::TextButton::textColourOffId, juce::Colours::white);
+    freezeButton.onClick = [this] {
+        processorRef.isFrozen.store(freezeButton.getToggleState());
+    };
+
+    // PREDICT: in Ghost read mode, ramps the fader ahead of level changes in the Ghost
+    lookaheadButton.setClickingTogglesState(true);
+    lookaheadButton.setToggleState(processorRef.isGhostLookahead.load(), juce::dontSendNotification);
+    lookaheadButton.setColour(juce::TextButton::buttonColourId, juce::Colour(0xff333333));
+    lookaheadButton.setColour(juce::TextButton::buttonOnColourId, juce::Colour(0xff3a6ea5));
+    lookaheadButton.setColour(juce::TextButton::textColourOffId, juce::Colours::white);
+    lookaheadButton.onClick = [this] {
+        processorRef.isGhostLookahead.store(lookaheadButton.getToggleState());
+    };
     
     chunkyA.onClick = [this] {
         if (chunkyA.getToggleState()) {
@@ -168,8 +154,7 @@ PluginEditor::PluginEditor (PluginProcessor& p)
     chunkyB.onClick = [this] {
         if (chunkyB.getToggleState()) {
             chunkyA.setToggleState(false, juce::dontSendNotification);
-            processorRef.isGhostReading.store(false);
-            processorRef.isGhostRecording.store(true);
+            processorRef.startGhostRecording();
             ghostSelector.changeItemText(ghostSelector.getSelectedId(), "* UNSAVED GHOST *");
         } else {
             processorRef.isGhostRecording.store(false);
@@ -177,13 +162,21 @@ PluginEditor::PluginEditor (PluginProcessor& p)
     };
     
     saveGhostButton.onClick = [this] {
-        juce::String savedName = "Ghost Track " + juce::String(ghostSelector.getSelectedId());
-        ghostSelector.changeItemText(ghostSelector.getSelectedId(), savedName);
+        auto& library = processorRef.ghostLibrary;
+        const int slot = library.getActiveSlot();
+
+        if (library.getSlot(slot) == nullptr)
+            return;
+
+        library.setSlotName(slot, "Ghost Track " + juce::String(slot + 1));
+        refreshGhostSlots();
     };
     addAndMakeVisible(chunkyA);
     addAndMakeVisible(chunkyB);
     addAndMakeVisible(ghostSelector);
     addAndMakeVisible(saveGhostButton);
+    addAndMakeVisible(freezeButton);
+    addAndMakeVisible(lookaheadButton);
 
     // ==========================================================
     // SOURCE SELECTOR WIRING (IN / EXT)
@@ -191,32 +184,94 @@ PluginEditor::PluginEditor (PluginProcessor& p)
     sourceInButton.setLookAndFeel(&sourceButtonLookAndFeel);
     sourceExtButton.setLookAndFeel(&sourceButtonLookAndFeel);
     
-    sourceInButton.setToggleState(true, juce::dontSendNotification); // Default to internal
-    
+    // One of the two is always on: clicking the lit one leaves it lit
     sourceInButton.onClick = [this] {
-        if (sourceInButton.getToggleState()) {
-            sourceExtButton.setToggleState(false, juce::dontSendNotification);
-            processorRef.forceExternalSidechain.store(false);
-        } else {
-            sourceInButton.setToggleState(true, juce::dontSendNotification); // Prevent turning both off
-        }
+        if (sourceInButton.getToggleState())
+            sourceAttachment.setValueAsCompleteGesture(0.0f);
+        showSource(processorRef.parameters.externalSidechain.get());
     };
     
     sourceExtButton.onClick = [this] {
-        if (sourceExtButton.getToggleState()) {
-            sourceInButton.setToggleState(false, juce::dontSendNotification);
-            processorRef.forceExternalSidechain.store(true);
-        } else {
-            sourceExtButton.setToggleState(true, juce::dontSendNotification); // Prevent turning both off
-        }
+        if (sourceExtButton.getToggleState())
+            sourceAttachment.setValueAsCompleteGesture(1.0f);
+        showSource(processorRef.parameters.externalSidechain.get());
     };
+    sourceAttachment.sendInitialUpdate();
     
     addAndMakeVisible(sourceInButton);
     addAndMakeVisible(sourceExtButton);
 
+    // LOOKAHEAD: 5 ms of latency (reported to the host) for an instant, overshoot-free attack
+    lookaheadModeButton.setClickingTogglesState(true);
+    lookaheadModeButton.setToggleState(processorRef.isLookaheadEnabled(), juce::dontSendNotification);
+    lookaheadModeButton.setColour(juce::TextButton::buttonColourId, juce::Colour(0xff333333));
+    lookaheadModeButton.setColour(juce::TextButton::buttonOnColourId, juce::Colour(0xff3a6ea5));
+    lookaheadModeButton.setColour(juce::TextButton::textColourOffId, juce::Colours::white);
+    lookaheadModeButton.onClick = [this] {
+        processorRef.setLookaheadEnabled(lookaheadModeButton.getToggleState());
+    };
+    addAndMakeVisible(lookaheadModeButton);
+
+    // WRITE: sends the ride to a CLAP host as Ride Gain automation while playing. Only a CLAP
+    // instance can send it, so no other format shows the button.
+    rideOutButton.setClickingTogglesState(true);
+    rideOutButton.setToggleState(processorRef.isRideWriting.load(), juce::dontSendNotification);
+    rideOutButton.setColour(juce::TextButton::buttonColourId, juce::Colour(0xff333333));
+    rideOutButton.setColour(juce::TextButton::buttonOnColourId, juce::Colour(0xffa53a3a));
+    rideOutButton.setColour(juce::TextButton::textColourOffId, juce::Colours::white);
+    rideOutButton.onClick = [this] {
+        processorRef.isRideWriting.store(rideOutButton.getToggleState());
+    };
+    addChildComponent(rideOutButton);
+    rideOutButton.setVisible(processorRef.canWriteRide());
+
+    // The active Ghost, drawn from its overview pyramid
+    addAndMakeVisible(ghostTimeline);
+
+    // IMPORT: builds the active slot's Ghost from a reference file, faster than realtime.
+    // While an import runs the button shows its progress, and clicking it cancels.
+    importGhostButton.setColour(juce::TextButton::buttonColourId, juce::Colour(0xff333333));
+    importGhostButton.setColour(juce::TextButton::textColourOffId, juce::Colours::white);
+    importGhostButton.onClick = [this] {
+        if (processorRef.ghostImporter.isImporting())
+            processorRef.ghostImporter.cancelImport();
+        else
+            chooseGhostImport();
+    };
+    lastImportsFinished = processorRef.ghostImporter.getNumFinished();
+    addAndMakeVisible(importGhostButton);
+
     startTimerHz(30);
-    // Increased height to accommodate the slider
-    setSize (600, 260);
+    // Increased height to accommodate the slider and the Ghost timeline
+    setSize (600, 330);
+}
+
+void PluginEditor::showMode(int mode)
+{
+    voxButton.setToggleState(mode == 1, juce::dontSendNotification);
+    spaceButton.setToggleState(mode == 2, juce::dontSendNotification);
+    punchButton.setToggleState(mode == 3, juce::dontSendNotification);
+}
+
+void PluginEditor::showShredMode(int index)
+{
+    shredMode1.setToggleState(index == 0, juce::dontSendNotification);
+    shredMode2.setToggleState(index == 1, juce::dontSendNotification);
+    shredMode3.setToggleState(index == 2, juce::dontSendNotification);
+}
+
+void PluginEditor::showRatio(int index)
+{
+    ratio1Button.setToggleState(index == 0, juce::dontSendNotification);
+    ratio3Button.setToggleState(index == 1, juce::dontSendNotification);
+    ratio6Button.setToggleState(index == 2, juce::dontSendNotification);
+    ratio9Button.setToggleState(index == 3, juce::dontSendNotification);
+}
+
+void PluginEditor::showSource(bool external)
+{
+    sourceInButton.setToggleState(! external, juce::dontSendNotification);
+    sourceExtButton.setToggleState(external, juce::dontSendNotification);
 }
 
 PluginEditor::~PluginEditor()
@@ -439,11 +494,16 @@ void PluginEditor::resized()
     
     chunkyA.setBounds(strip3X + 40, switchY, switchW, switchH);
     chunkyB.setBounds(strip3X + 110, switchY, switchW, switchH);
+    freezeButton.setBounds(strip3X + 73, switchY + 1, 32, 18);
+    lookaheadButton.setBounds(strip3X + 73, switchY + 21, 32, 18);
     
     int menuY = switchY + switchH + 5;
     ghostSelector.setBounds(strip3X + 10, menuY, 110, 18);
     saveGhostButton.setBounds(strip3X + 125, menuY, 45, 18);
 
+    ghostTimeline.setBounds(20, stripY + 95, 500, 40);
+    importGhostButton.setBounds(528, stripY + 106, 52, 18);
+
     inspectButton.setBounds(getWidth() - 110, getHeight() - 35, 100, 25);
     // Position the IN / EXT source buttons under the Analyzed Meter
     int sourceW = 35;
@@ -453,10 +513,90 @@ void PluginEditor::resized()
     
     sourceInButton.setBounds(sourceCenterX - sourceW - 2, sourceY, sourceW, sourceH);
     sourceExtButton.setBounds(sourceCenterX + 2, sourceY, sourceW, sourceH);
+    lookaheadModeButton.setBounds(sourceCenterX + sourceW + 8, sourceY, 40, sourceH);
+    rideOutButton.setBounds(lookaheadModeButton.getX(), sourceY + sourceH + 4, 40, sourceH);
+}
+
+void PluginEditor::refreshGhostSlots()
+{
+    const auto& library = processorRef.ghostLibrary;
+
+    for (int slot = 0; slot < GhostLibrary::numSlots; ++slot) {
+        const auto name = library.getSlotName(slot);
+
+        if (library.getSlot(slot) == nullptr)
+            ghostSelector.changeItemText(slot + 1, "Slot " + juce::String(slot + 1) + ": Unused");
+        else
+            ghostSelector.changeItemText(slot + 1, name.isNotEmpty() ? name : "* UNSAVED GHOST *");
+    }
+
+    ghostSelector.setSelectedId(library.getActiveSlot() + 1, juce::dontSendNotification);
+}
+
+void PluginEditor::chooseGhostImport()
+{
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+    importChooser = std::make_unique<juce::FileChooser>("Import a Ghost from a reference file", juce::File(),
+                                                        formats.getWildcardForAllFormats());
+
+    importChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                               [safeThis = juce::Component::SafePointer<PluginEditor>(this)] (const juce::FileChooser& chooser) {
+        if (safeThis != nullptr && chooser.getResult().existsAsFile())
+            safeThis->askImportTempo(chooser.getResult());
+    });
+}
+
+void PluginEditor::askImportTempo(const juce::File& file)
+{
+    importTempoWindow = std::make_unique<juce::AlertWindow>("Import Ghost", "Tempo of " + file.getFileName(),
+                                                            juce::MessageBoxIconType::NoIcon, this);
+    importTempoWindow->addTextEditor("bpm", juce::String(processorRef.hostBpm.load(), 2), "BPM");
+    importTempoWindow->addButton("IMPORT", 1, juce::KeyPress(juce::KeyPress::returnKey));
+    importTempoWindow->addButton("Cancel", 0, juce::KeyPress(juce::KeyPress::escapeKey));
+
+    importTempoWindow->enterModalState(true, juce::ModalCallbackFunction::create(
+        [safeThis = juce::Component::SafePointer<PluginEditor>(this), file] (int result) {
+            if (safeThis == nullptr || result != 1)
+                return;
+
+            GhostImport::Settings settings;
+            settings.bpm = safeThis->importTempoWindow->getTextEditorContents("bpm").getDoubleValue();
+
+            auto& processor = safeThis->processorRef;
+            processor.ghostImporter.startImport(file, processor.ghostLibrary.getActiveSlot(), settings);
+        }), false);
 }
 
 void PluginEditor::timerCallback()
 {
+    ghostTimeline.refresh();
+
+    // CHOP's gate needs the live guide, so FREEZE holds off (and says so) while it's on
+    freezeButton.setEnabled(! processorRef.parameters.chop.get());
+
+    // The processor switches freeze off whenever the active Ghost changes
+    freezeButton.setToggleState(processorRef.isFrozen.load(), juce::dontSendNotification);
+
+    // GHOST IMPORT PROGRESS
+    auto& importer = processorRef.ghostImporter;
+
+    if (importer.isImporting()) {
+        importGhostButton.setButtonText(juce::String(juce::roundToInt(importer.getProgress() * 100.0f)) + "%");
+    } else if (importer.getNumFinished() != lastImportsFinished) {
+        lastImportsFinished = importer.getNumFinished();
+        importGhostButton.setButtonText("IMPORT");
+
+        const auto result = importer.getLastResult();
+
+        if (result.wasOk()) {
+            refreshGhostSlots();
+        } else if (! importer.wasCancelled()) {
+            juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Import Ghost",
+                                                   result.getErrorMessage(), {}, this);
+        }
+    }
+
     float mainLevel      = processorRef.getMainBusLevel();
     float sidechainLevel = processorRef.getSidechainBusLevel();
     
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "PluginProcessor.h"
+#include "GhostTimeline.h"
 #include "BinaryData.h"
 #include "melatonin_inspector/melatonin_inspector.h"
 
@@ -253,10 +254,33 @@ private:
     juce::ToggleButton chunkyA { "A" }; 
     juce::ToggleButton chunkyB { "B" }; 
     juce::ComboBox ghostSelector;       
-    juce::TextButton saveGhostButton { "SAVE" }; 
+    juce::TextButton saveGhostButton { "SAVE" };
+    juce::TextButton freezeButton { "FRZ" };
+    juce::TextButton lookaheadButton { "PRE" }; 
+    GhostTimeline ghostTimeline { processorRef.ghostLibrary };
+    juce::TextButton importGhostButton { "IMPORT" };
+    std::unique_ptr<juce::FileChooser> importChooser;
+    std::unique_ptr<juce::AlertWindow> importTempoWindow;
+    int lastImportsFinished { 0 };
 
     juce::ToggleButton sourceInButton  { "IN" };
     juce::ToggleButton sourceExtButton { "EXT" };
+    juce::TextButton lookaheadModeButton { "LOOK" };
+    juce::TextButton rideOutButton { "WRITE" };
+
+    // ==========================================================
+    // PARAMETER ATTACHMENTS
+    // ==========================================================
+    // The exclusive banks drive choice parameters. Each attachment keeps its buttons in step
+    // with the parameter, whether it changed from here or from host automation.
+    juce::ParameterAttachment modeAttachment { processorRef.parameters.mode, [this] (float value) { showMode ((int) value); } };
+    juce::ButtonParameterAttachment flipAttachment { processorRef.parameters.flip, flipButton };
+    juce::ButtonParameterAttachment shredAttachment { processorRef.parameters.shred, shredButton };
+    juce::ButtonParameterAttachment chopAttachment { processorRef.parameters.chop, chopButton };
+    juce::ParameterAttachment shredModeAttachment { processorRef.parameters.shredMode, [this] (float value) { showShredMode ((int) value); } };
+    juce::SliderParameterAttachment chopThresholdAttachment { processorRef.parameters.chopThreshold, chopSlider };
+    juce::ParameterAttachment ratioAttachment { processorRef.parameters.ratio, [this] (float value) { showRatio ((int) value); } };
+    juce::ParameterAttachment sourceAttachment { processorRef.parameters.externalSidechain, [this] (float value) { showSource (value >= 0.5f); } };
 
     juce::Rectangle<int> analyzedMeter;
     juce::Rectangle<int> actionMeter;
@@ -279,6 +303,13 @@ private:
     void drawMeterArc(juce::Graphics& g, juce::Point<float> arcCenter, float arcRadius, juce::Rectangle<float> meterArea);
     void drawPeakLED(juce::Graphics& g, float x, float y);
     void drawGhostLED(juce::Graphics& g, juce::Rectangle<int> switchBounds);
+    void showMode(int mode);
+    void showShredMode(int index);
+    void showRatio(int index);
+    void showSource(bool external);
+    void refreshGhostSlots();
+    void chooseGhostImport();
+    void askImportTempo(const juce::File& file);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginEditor)
 };
\ No newline at end of file
@@ -0,0 +1,182 @@
+#include "PluginParameters.h"
+#include <cstring>
+
+namespace
+{
+    juce::AudioProcessorValueTreeState::ParameterLayout createLayout()
+    {
+        using Choice = juce::AudioParameterChoice;
+        using Bool = juce::AudioParameterBool;
+        using Float = juce::AudioParameterFloat;
+
+        juce::AudioProcessorValueTreeState::ParameterLayout layout;
+
+        layout.add (std::make_unique<Choice> (PluginParameters::modeID, "Mode", juce::StringArray { "Off", "VOX", "SPACE", "PUNCH" }, 0));
+        layout.add (std::make_unique<Bool> (PluginParameters::flipID, "Flip", false));
+        layout.add (std::make_unique<Bool> (PluginParameters::shredID, "Shred", false));
+        layout.add (std::make_unique<Choice> (PluginParameters::shredModeID, "Shred Mode", juce::StringArray { "I", "II", "III" }, 0));
+        layout.add (std::make_unique<Bool> (PluginParameters::chopID, "Chop", false));
+        layout.add (std::make_unique<Float> (PluginParameters::chopThresholdID, "Chop Threshold",
+                                             juce::NormalisableRange<float> (0.01f, 0.80f, 0.01f), 0.10f));
+        layout.add (std::make_unique<Choice> (PluginParameters::ratioID, "Ratio", juce::StringArray { "1:1", "3:1", "6:1", "9:1" }, 0));
+        layout.add (std::make_unique<Bool> (PluginParameters::externalSidechainID, "Guide EXT", false));
+        layout.add (std::make_unique<Float> (PluginParameters::rideGainID, "Ride Gain",
+                                             juce::NormalisableRange<float> (-60.0f, 30.0f), 0.0f,
+                                             juce::AudioParameterFloatAttributes().withLabel ("dB")));
+
+        return layout;
+    }
+
+    template <typename Parameter>
+    Parameter& getParameter (juce::AudioProcessorValueTreeState& tree, const juce::ParameterID& id)
+    {
+        auto* parameter = dynamic_cast<Parameter*> (tree.getParameter (id.getParamID()));
+        jassert (parameter != nullptr);
+        return *parameter;
+    }
+
+    // The packed word: the chop threshold's float bits in the low half, then two bits each for
+    // mode, shred mode and ratio, and one each for the switches
+    constexpr int modeShift = 32;
+    constexpr int shredModeShift = 34;
+    constexpr int ratioShift = 36;
+    constexpr int flipBit = 38;
+    constexpr int shredBit = 39;
+    constexpr int chopBit = 40;
+    constexpr int externalSidechainBit = 41;
+}
+
+//==============================================================================
+PluginParameters::PluginParameters (juce::AudioProcessor& processor)
+    : tree (processor, nullptr, "PARAMETERS", createLayout()),
+      mode (getParameter<juce::AudioParameterChoice> (tree, modeID)),
+      flip (getParameter<juce::AudioParameterBool> (tree, flipID)),
+      shred (getParameter<juce::AudioParameterBool> (tree, shredID)),
+      shredMode (getParameter<juce::AudioParameterChoice> (tree, shredModeID)),
+      chop (getParameter<juce::AudioParameterBool> (tree, chopID)),
+      chopThreshold (getParameter<juce::AudioParameterFloat> (tree, chopThresholdID)),
+      ratio (getParameter<juce::AudioParameterChoice> (tree, ratioID)),
+      externalSidechain (getParameter<juce::AudioParameterBool> (tree, externalSidechainID)),
+      rideGain (getParameter<juce::AudioParameterFloat> (tree, rideGainID))
+{
+    all = { &mode, &flip, &shred, &shredMode, &chop, &chopThreshold, &ratio, &externalSidechain };
+
+    for (auto* parameter : all)
+        parameter->addListener (this);
+
+    publish();
+}
+
+PluginParameters::~PluginParameters()
+{
+    for (auto* parameter : all)
+        parameter->removeListener (this);
+}
+
+void PluginParameters::parameterValueChanged (int, float)
+{
+    publish();
+}
+
+void PluginParameters::publish() noexcept
+{
+    auto expected = packed.load (std::memory_order_acquire);
+
+    // Packing after loading the word means a failed exchange always retries with fresher values
+    while (! packed.compare_exchange_weak (expected, pack(), std::memory_order_acq_rel))
+    {
+    }
+}
+
+std::uint64_t PluginParameters::pack() const noexcept
+{
+    const auto threshold = chopThreshold.get();
+    std::uint32_t thresholdBits;
+    std::memcpy (&thresholdBits, &threshold, sizeof (thresholdBits));
+
+    return (std::uint64_t) thresholdBits
+         | ((std::uint64_t) (mode.getIndex() & 3) << modeShift)
+         | ((std::uint64_t) (shredMode.getIndex() & 3) << shredModeShift)
+         | ((std::uint64_t) (ratio.getIndex() & 3) << ratioShift)
+         | ((std::uint64_t) flip.get() << flipBit)
+         | ((std::uint64_t) shred.get() << shredBit)
+         | ((std::uint64_t) chop.get() << chopBit)
+         | ((std::uint64_t) externalSidechain.get() << externalSidechainBit);
+}
+
+PluginParameters::Snapshot PluginParameters::unpack (std::uint64_t word) noexcept
+{
+    Snapshot snapshot;
+
+    const auto thresholdBits = (std::uint32_t) word;
+    std::memcpy (&snapshot.chopThreshold, &thresholdBits, sizeof (thresholdBits));
+
+    snapshot.mode = (std::int8_t) ((word >> modeShift) & 3);
+    snapshot.shredMode = (std::int8_t) (1 + ((word >> shredModeShift) & 3));
+    snapshot.ratio = (std::int8_t) ratios[(word >> ratioShift) & 3];
+    snapshot.flip = ((word >> flipBit) & 1) != 0;
+    snapshot.shred = ((word >> shredBit) & 1) != 0;
+    snapshot.chop = ((word >> chopBit) & 1) != 0;
+    snapshot.externalSidechain = ((word >> externalSidechainBit) & 1) != 0;
+
+    return snapshot;
+}
+
+//==============================================================================
+// State chunk layout: int version, int count, then per parameter its ID and its value in the
+// parameter's own units (a choice's index, 0/1 for a switch)
+static constexpr int parameterStateVersion = 1;
+
+void PluginParameters::writeState (juce::MemoryOutputStream& out) const
+{
+    juce::Array<const juce::RangedAudioParameter*> changed;
+
+    for (auto* parameter : all)
+        if (parameter->getValue() != parameter->getDefaultValue())
+            changed.add (parameter);
+
+    out.writeInt (parameterStateVersion);
+    out.writeInt (changed.size());
+
+    for (auto* parameter : changed)
+    {
+        out.writeString (parameter->getParameterID());
+        out.writeFloat (parameter->convertFrom0to1 (parameter->getValue()));
+    }
+}
+
+bool PluginParameters::readState (const void* data, size_t sizeInBytes)
+{
+    juce::MemoryInputStream in (data, sizeInBytes, false);
+
+    if (in.readInt() != parameterStateVersion)
+        return false;
+
+    const auto count = in.readInt();
+
+    if (count < 0 || count > 1024)
+        return false;
+
+    resetToDefaults();
+
+    for (int i = 0; i < count && ! in.isExhausted(); ++i)
+    {
+        const auto id = in.readString();
+        const auto value = in.readFloat();
+
+        // Parameters from a later version are skipped
+        if (auto* parameter = tree.getParameter (id))
+            parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+    }
+
+    return true;
+}
+
+void PluginParameters::resetToDefaults()
+{
+    // Parameters already at their default are left alone: going through the normalised value
+    // can land a stepped range an ulp away from where the layout put it
+    for (auto* parameter : all)
+        if (parameter->getValue() != parameter->getDefaultValue())
+            parameter->setValueNotifyingHost (parameter->getDefaultValue());
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <atomic>
+#include <cstdint>
+
+// ==========================================================
+// THE PARAMETERS
+// ==========================================================
+// Every control the host can automate, owned by an AudioProcessorValueTreeState
+// so the editor can attach to them. The plugin state stores them in its own
+// PARM section (see PluginState) rather than the value tree's XML.
+//
+// processBlock never reads the parameters one by one. Whenever one of them
+// changes, from the editor or from host automation, all of them are packed into
+// a single 64-bit word. The audio thread then takes a Snapshot with one atomic
+// load at the top of each block, so it never sees half of a change: a block
+// runs entirely with the old combination or entirely with the new one.
+//
+// rideGain works the other way round. The plugin writes it as CLAP output
+// events so a host can record the ride into an automation lane. Nothing reads
+// it back, and it is neither in the snapshot nor in the state. Since it's the
+// plugin's own parameter, the recorded lane goes when the plugin is removed;
+// moving it onto the track's volume is up to the host.
+class PluginParameters : private juce::AudioProcessorParameter::Listener
+{
+public:
+    explicit PluginParameters (juce::AudioProcessor& processor);
+    ~PluginParameters() override;
+
+    static inline const juce::ParameterID modeID { "mode", 1 };
+    static inline const juce::ParameterID flipID { "flip", 1 };
+    static inline const juce::ParameterID shredID { "shred", 1 };
+    static inline const juce::ParameterID shredModeID { "shredMode", 1 };
+    static inline const juce::ParameterID chopID { "chop", 1 };
+    static inline const juce::ParameterID chopThresholdID { "chopThreshold", 1 };
+    static inline const juce::ParameterID ratioID { "ratio", 1 };
+    static inline const juce::ParameterID externalSidechainID { "externalSidechain", 1 };
+    static inline const juce::ParameterID rideGainID { "rideGain", 1 };
+
+    static constexpr int ratios[] { 1, 3, 6, 9 }; // the ratio parameter's choices
+
+    juce::AudioProcessorValueTreeState tree;
+
+    juce::AudioParameterChoice& mode;       // OFF, VOX, SPACE, PUNCH
+    juce::AudioParameterBool& flip;
+    juce::AudioParameterBool& shred;
+    juce::AudioParameterChoice& shredMode;  // I, II, III
+    juce::AudioParameterBool& chop;
+    juce::AudioParameterFloat& chopThreshold;
+    juce::AudioParameterChoice& ratio;      // an index into ratios
+    juce::AudioParameterBool& externalSidechain; // the guide comes from the sidechain (EXT) rather than the input (IN)
+    juce::AudioParameterFloat& rideGain;         // dB; output only
+
+    // ==========================================================
+    // AUDIO THREAD
+    // ==========================================================
+    struct Snapshot
+    {
+        float chopThreshold;
+        std::int8_t mode;      // 0 = off, 1 = VOX, 2 = SPACE, 3 = PUNCH
+        std::int8_t shredMode; // 1..3
+        std::int8_t ratio;     // 1, 3, 6 or 9
+        bool flip;
+        bool shred;
+        bool chop;
+        bool externalSidechain;
+    };
+
+    Snapshot snapshot() const noexcept { return unpack (packed.load (std::memory_order_acquire)); }
+
+    // ==========================================================
+    // STATE (MESSAGE THREAD)
+    // ==========================================================
+    // Writes the parameters that aren't at their default, so an untouched plugin stores next to nothing
+    void writeState (juce::MemoryOutputStream& out) const;
+
+    // Sets every parameter from a state written by writeState(); the ones it doesn't mention go to their default
+    bool readState (const void* data, size_t sizeInBytes);
+    void resetToDefaults();
+
+private:
+    void parameterValueChanged (int parameterIndex, float newValue) override;
+    void parameterGestureChanged (int, bool) override {}
+
+    // Repacks every parameter. Safe to call from any thread at once: a pack that raced another
+    // change is retried, so the word always ends up holding the latest values.
+    void publish() noexcept;
+    std::uint64_t pack() const noexcept;
+    static Snapshot unpack (std::uint64_t word) noexcept;
+
+    juce::Array<juce::RangedAudioParameter*> all;
+    std::atomic<std::uint64_t> packed { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginParameters)
+};
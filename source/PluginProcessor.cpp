@@ -1,7 +1,11 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "PluginState.h"
 #include <cmath>
 #include <algorithm> 
+#include <limits>
+#include <array>
+#include <utility>
 
 //==============================================================================
 PluginProcessor::PluginProcessor()
@@ -15,9 +19,41 @@ PluginProcessor::PluginProcessor()
                      #endif
                        )
 {
+    ghostPager->registerMap (frozenGainMap);
+    ghostLibrary.onActiveMapChanged = [this] { discardFrozenGain(); };
 }
 
-PluginProcessor::~PluginProcessor() {}
+PluginProcessor::~PluginProcessor()
+{
+    ghostPager->unregisterMap (frozenGainMap);
+}
+
+void PluginProcessor::startGhostRecording()
+{
+    isGhostReading.store (false);
+    ghostLibrary.editActiveSlot(); // an empty slot gets its storage now
+    ghostLibrary.setSlotName (ghostLibrary.getActiveSlot(), {});
+
+    // The frozen fader rode the Ghost that's about to be overwritten
+    discardFrozenGain();
+    isGhostRecording.store (true);
+}
+
+void PluginProcessor::discardFrozenGain()
+{
+    isFrozen.store (false);
+    frozenWithLookahead.store (false);
+    frozenGainMap.clear();
+}
+
+void PluginProcessor::setGhostScratchDirectory (const juce::File& directory)
+{
+    ghostLibrary.setBackingDirectory (directory);
+
+    if (directory != juce::File())
+        if (const auto file = scratchFolders->createFileIn (directory, "Frozen"); file != juce::File())
+            frozenGainMap.setBackingFile (file);
+}
 
 const juce::String PluginProcessor::getName() const { return JucePlugin_Name; }
 bool PluginProcessor::acceptsMidi() const { return false; }
@@ -33,29 +69,67 @@ void PluginProcessor::changeProgramName (int index, const juce::String& newName)
 //==============================================================================
 void PluginProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    juce::ignoreUnused (samplesPerBlock); 
     currentSampleRate = sampleRate;
+
+    // Contiguous per-stage arrays; processBlock works through larger host blocks in chunks of this size
+    maxBlockSize = juce::jmax(1, samplesPerBlock);
+    scratch.setSize((int) Scratch::numScratch * 2, maxBlockSize, false, true, false);
     
     currentFaderGain[0] = 1.0f;
     currentFaderGain[1] = 1.0f;
     
-    envStateLive[0] = 0.0f; envStateLive[1] = 0.0f;
-    envStateGuide[0] = 0.0f; envStateGuide[1] = 0.0f;
-    peakStateLive[0] = 0.0f; peakStateLive[1] = 0.0f;
-    peakStateGuide[0] = 0.0f; peakStateGuide[1] = 0.0f;
+    detector.prepare(maxBlockSize);
+    detector.reset();
+    shredState[0] = {}; shredState[1] = {};
     
     lastWrittenIdx[0] = -1; lastWrittenIdx[1] = -1;
+    lastFrozenIdx[0] = -1; lastFrozenIdx[1] = -1;
+    wasFrozen = false;
+
+    transportTracker.reset();
+    faderTiming = {};
+
+    envCoeff = static_cast<float>(std::exp(-1.0 / (EngineStages::rmsFollowerSeconds * sampleRate)));
+    peakReleaseCoeff = static_cast<float>(std::exp(-1.0 / (EngineStages::peakReleaseSeconds * sampleRate)));
+    detector.setCoefficients(envCoeff, peakReleaseCoeff);
+
+    // The lookahead delay is always allocated, so switching it on never allocates
+    lookaheadSamples = juce::jmax(1, juce::roundToInt(lookaheadSeconds * sampleRate));
+    lookaheadDelay.prepare({ sampleRate, (juce::uint32) maxBlockSize, 2 });
+    lookaheadDelay.setMaximumDelayInSamples(lookaheadSamples);
+    lookaheadDelay.setDelay((float) lookaheadSamples);
+    lookaheadDelay.reset();
+
+    guideDelay.prepare({ sampleRate, (juce::uint32) maxBlockSize, 6 });
+    guideDelay.setMaximumDelayInSamples(lookaheadSamples);
+    guideDelay.setDelay((float) lookaheadSamples);
+    guideDelay.reset();
+
+    for (auto& level : lookaheadLevel) {
+        level.prepare(lookaheadSamples + 1);
+        level.setWindowSize(lookaheadSamples + 1);
+    }
+
+    lookaheadActive = false;
 
-    envCoeff = static_cast<float>(std::exp(-1.0 / (0.010 * sampleRate)));
-    peakReleaseCoeff = static_cast<float>(std::exp(-1.0 / (0.050 * sampleRate)));
+    rideThinner.reset();
+    rideWriting = false;
+    rideGestureOpen = false;
 
-    // Pre-allocate 5 million indices (1h20m at 120BPM) to prevent audio thread crashes
-    ghostMapL.assign(5000000, -1.0f);
-    ghostMapR.assign(5000000, -1.0f);
+    setLatencySamples(lookaheadEnabled.load() ? lookaheadSamples : 0);
+
+    // Ghost pages are allocated on demand by the GhostPager and are indexed by PPQ,
+    // so a recorded ride survives sample-rate and block-size changes untouched.
 }
 
 void PluginProcessor::releaseResources() {}
 
+void PluginProcessor::setLookaheadEnabled (bool shouldBeEnabled)
+{
+    lookaheadEnabled.store(shouldBeEnabled);
+    setLatencySamples(shouldBeEnabled ? juce::jmax(1, juce::roundToInt(lookaheadSeconds * currentSampleRate)) : 0);
+}
+
 bool PluginProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
 {
     if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo()) return false;
@@ -79,46 +153,85 @@ void PluginProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::Midi
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    auto mainBuffer = getBusBuffer(buffer, true, 0); 
-    int numChannels = std::min(mainBuffer.getNumChannels(), 2); 
-    int numSamples = mainBuffer.getNumSamples();
+    // Non-owning views onto the host buffer: nothing on the audio path copies or allocates
+    auto mainBlock = getBusBlock(buffer, true, 0);
+    auto scBlock = getBusBlock(buffer, true, 1);
 
-    bool forceExt = forceExternalSidechain.load();
-    bool hasSidechain = (getBusCount(true) > 1 && getBus(true, 1)->isEnabled());
-    
-    juce::AudioBuffer<float> scBuffer;
-    int scChannels = 0;
-    if (hasSidechain) {
-        scBuffer = getBusBuffer(buffer, true, 1);
-        scChannels = scBuffer.getNumChannels();
+    TransportTracker::Position position;
+
+    if (auto* activePlayHead = getPlayHead()) {
+        if (auto positionInfo = activePlayHead->getPosition()) {
+            if (positionInfo->getBpm().hasValue()) position.bpm = *positionInfo->getBpm();
+            if (auto ppq = positionInfo->getPpqPosition()) {
+                position.ppq = *ppq;
+                position.hasPPQ = true;
+            }
+            if (auto loop = positionInfo->getLoopPoints()) position.loopStartPPQ = loop->ppqStart;
+            position.isPlaying = positionInfo->getIsPlaying();
+            position.isLooping = positionInfo->getIsLooping();
+        }
     }
 
+    // Only a CLAP host can take the ride, so the breakpoints are dropped with the next block
+    rideThinner.beginBlock();
+    processBuses(mainBlock, scBlock, position);
+}
+
+void PluginProcessor::processBuses (juce::dsp::AudioBlock<float>& mainBlock, const juce::dsp::AudioBlock<float>& scBlock,
+                                    const TransportTracker::Position& position) noexcept
+{
+    int numChannels = std::min((int) mainBlock.getNumChannels(), 2);
+    int numSamples = (int) mainBlock.getNumSamples();
+
+    // Every parameter at once, so the block can't see half of a change
+    const auto params = parameters.snapshot();
+
+    bool forceExt = params.externalSidechain;
+
+    int scChannels = (int) scBlock.getNumChannels();
+    bool hasSidechain = scChannels > 0;
+
     // ==========================================================
     // TEMPO & PLAYHEAD ENGINE
     // ==========================================================
-    double currentBPM = 120.0;
-    double currentPPQ = 0.0;
-    bool isPlaying = false;
+    double currentBPM = position.bpm;
+    double currentPPQ = position.ppq;
+    bool isPlaying = position.isPlaying;
 
-    if (auto* activePlayHead = getPlayHead()) {
-        if (auto positionInfo = activePlayHead->getPosition()) {
-            if (positionInfo->getBpm().hasValue()) currentBPM = *positionInfo->getBpm();
-            if (positionInfo->getPpqPosition().hasValue()) currentPPQ = *positionInfo->getPpqPosition();
-            isPlaying = positionInfo->getIsPlaying();
-        }
+    float sampleRateSafe = (currentSampleRate > 0.0) ? (float)currentSampleRate : 44100.0f;
+
+    // Play / stop / loop / jump / tempo events for this instance only
+    const auto transport = transportTracker.update(position, numSamples, sampleRateSafe);
+    bool forceSnapFader = isPlaying && transport.discontinuity();
+
+    // Recording a Ghost needs the followers, so it always wins over freeze, and so does CHOP,
+    // whose gate listens to the guide. Coming out of freeze the followers have been idle, so
+    // they restart like after a jump.
+    const bool frozen = isFrozen.load() && ! isGhostRecording.load() && ! params.chop;
+    forceSnapFader = forceSnapFader || (wasFrozen && ! frozen && isPlaying);
+    wasFrozen = frozen;
+
+    // The ride goes out while playing; a stop or a jump ends the line drawn so far
+    const bool writingRide = isRideWriting.load() && isPlaying;
+    if (rideWriting && (! writingRide || transport.discontinuity()))
+        rideThinner.flush();
+    rideWriting = writingRide;
+    rideThinner.toleranceDb = rideToleranceDb.load();
+
+    // Lookahead switched since the last block: the delay and the level window restart from silence
+    if (lookaheadEnabled.load() != lookaheadActive) {
+        lookaheadActive = ! lookaheadActive;
+        lookaheadDelay.reset();
+        guideDelay.reset();
+        for (auto& level : lookaheadLevel) level.reset();
     }
-    
-    static double previousPPQ = 0.0;
-    static bool wasPlaying = false;
-    
-    bool justStartedPlaying = isPlaying && !wasPlaying;
-    bool jumpedBackward = currentPPQ < previousPPQ;
-    bool forceSnapFader = justStartedPlaying || (isPlaying && jumpedBackward);
-    
-    previousPPQ = currentPPQ;
-    wasPlaying = isPlaying;
 
-    float sampleRateSafe = (currentSampleRate > 0.0) ? (float)currentSampleRate : 44100.0f;
+    // Guide source per channel, resolved once: the live input, the sidechain, or silence (nullptr)
+    const float* guideChannels[2] { nullptr, nullptr };
+    for (int ch = 0; ch < numChannels; ++ch) {
+        if (forceExt && hasSidechain)       guideChannels[ch] = scBlock.getChannelPointer((size_t) ((ch < scChannels) ? ch : 0));
+        else if (! forceExt)                guideChannels[ch] = mainBlock.getChannelPointer((size_t) ch);
+    }
     
     // ENVELOPE PRE-WARMING: Resolves initial 1st-sample onset spikes
     if (forceSnapFader && numSamples > 0) {
@@ -128,10 +241,8 @@ void PluginProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::Midi
 
         for (int i = 0; i < warmUpSamples; ++i) {
             for (int ch = 0; ch < numChannels; ++ch) {
-                float l = mainBuffer.getSample(ch, i);
-                float g = l; 
-                if (forceExt && hasSidechain) g = scBuffer.getSample((ch < scChannels) ? ch : 0, i);
-                else if (forceExt && !hasSidechain) g = 0.0f;
+                float l = mainBlock.getSample(ch, i);
+                float g = (guideChannels[ch] != nullptr) ? guideChannels[ch][i] : 0.0f;
                 
                 sumLive[ch] += l * l;
                 sumGuide[ch] += g * g;
@@ -141,33 +252,103 @@ void PluginProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::Midi
             float startLive = std::sqrt(sumLive[ch] / (float)warmUpSamples);
             float startGuide = std::sqrt(sumGuide[ch] / (float)warmUpSamples);
             
-            envStateLive[ch] = startLive * startLive;
-            envStateGuide[ch] = startGuide * startGuide;
-            
-            peakStateLive[ch] = startLive; 
-            peakStateGuide[ch] = startGuide;
+            detector.setState(ch, { startLive * startLive, startGuide * startGuide, startLive, startGuide });
             lastWrittenIdx[ch] = -1; 
+            lastFrozenIdx[ch] = -1;
         }
     }
 
-    float secondsPerQuarter = 60.0f / (float)currentBPM;
-    float secondsPer128th = secondsPerQuarter / 32.0f;
-    float musicalRelease = std::clamp(secondsPer128th * (2.0f / 3.0f), 0.002f, 0.040f);
-    
-    int mode = currentMode.load();
-    bool flipOn = isFlipActive.load();
-    bool shredOn = isShredActive.load();
-    bool chopOn = isChopActive.load();
-    float chopThresh = chopThreshold.load();
-    int ratio = currentRatio.load(); 
-    int shredMode = currentShredMode.load();
+    int mode = params.mode;
+
+    if (transport.tempoChanged)
+        hostBpm.store(currentBPM);
+
+    // The fader timing follows the tempo, so it only needs redoing when the tempo or mode changes
+    if (transport.tempoChanged || mode != faderTiming.mode) {
+        float secondsPerQuarter = 60.0f / (float)currentBPM;
+        float secondsPer128th = secondsPerQuarter / 32.0f;
+        float musicalRelease = std::clamp(secondsPer128th * (2.0f / 3.0f), 0.002f, 0.040f);
+
+        float attackTime = (mode == 1) ? 0.015f : ((mode == 2) ? 0.002f : 0.001f);
+        float releaseTime = (mode == 1) ? 0.030f : ((mode == 2) ? musicalRelease * 8.0f : musicalRelease);
+
+        faderTiming.mode = mode;
+        faderTiming.attackSeconds = attackTime;
+        faderTiming.attackCoeff = 1.0f - FastMath::exp(-1.0f / (attackTime * sampleRateSafe));
+        faderTiming.releaseCoeff = 1.0f - FastMath::exp(-1.0f / (releaseTime * sampleRateSafe));
+        faderTiming.holdTarget = juce::jmax(1, (int)(musicalRelease * sampleRateSafe * 0.45f));
+    }
+
+    bool flipOn = params.flip;
+    bool shredOn = params.shred;
+    bool chopOn = params.chop;
+    float chopThresh = params.chopThreshold;
+    int ratio = params.ratio;
+    int shredMode = params.shredMode;
 
     bool writeMode = isGhostRecording.load();
     bool readMode = isGhostReading.load();
     
-    double ppqResolution = 500.0; 
-    double ppqPerSample = (currentBPM / 60.0) / sampleRateSafe;
-    
+    EngineStages::GhostClock ghostClock;
+    ghostClock.startPPQ = currentPPQ;
+    ghostClock.ppqPerSample = (currentBPM / 60.0) / sampleRateSafe;
+
+    // A tempo ramp carries on across the block, but never so steeply that the playhead would stall
+    ghostClock.ppqPerSampleRamp = std::max(transport.bpmPerSample / 60.0 / sampleRateSafe,
+                                           -0.5 * ghostClock.ppqPerSample / (double) std::max(1, numSamples));
+
+    bool freezeArmed = readMode && ! frozen;
+
+    // Offline renders can't wait for the pager to create an empty slot, and aren't real-time anyway
+    if (writeMode && isNonRealtime())
+        ghostLibrary.editActiveSlot();
+
+    // The active Ghost slot, held until the end of the block whatever the editor does meanwhile
+    const GhostLibrary::ReadScope ghostScope(ghostLibrary);
+    GhostMap& ghostMap = ghostScope.getMap();
+
+    if (&ghostMap != lastGhost) {
+        lastWrittenIdx[0] = -1;
+        lastWrittenIdx[1] = -1;
+        lastGhost = &ghostMap;
+    }
+
+    // Recording into an empty slot: the pager creates it, and writes land from then on
+    if (writeMode && ! ghostScope.hasStorage())
+        ghostScope.requestStorage();
+
+    // Each map keeps the grid it was first recorded on; one that has none yet gets the grid for this tempo
+    const double gridForTempo = GhostMap::resolutionFor(currentBPM);
+    if (writeMode && ghostScope.hasStorage())
+        ghostMap.claimResolution(gridForTempo);
+    ghostClock.ppqResolution = (ghostMap.getResolution() > 0.0) ? ghostMap.getResolution() : gridForTempo;
+
+    // Freeze captures onto the grid of the Ghost it rides
+    if (freezeArmed)
+        frozenGainMap.claimResolution(ghostClock.ppqResolution);
+    EngineStages::GhostClock frozenClock = ghostClock;
+    if (frozenGainMap.getResolution() > 0.0)
+        frozenClock.ppqResolution = frozenGainMap.getResolution();
+
+    // Lookahead window in Ghost indices, one attack time long
+    bool lookaheadOn = readMode && isGhostLookahead.load();
+    ghostLookahead.windowIndices = lookaheadOn ? (int)std::ceil(faderTiming.attackSeconds * (currentBPM / 60.0) * ghostClock.ppqResolution) : 0;
+    ghostLookahead.towardsMax = (mode == 3); // PUNCH attacks upwards
+
+    const auto playheadIndexFor = [currentPPQ](const EngineStages::GhostClock& clock) {
+        double blockStartIndex = currentPPQ * clock.ppqResolution;
+        return (blockStartIndex >= 0.0 && blockStartIndex < (double)std::numeric_limits<int>::max()) ? (int)blockStartIndex : 0;
+    };
+
+    ghostMap.publishPlayhead(playheadIndexFor(ghostClock), writeMode);
+    frozenGainMap.publishPlayhead(playheadIndexFor(frozenClock), freezeArmed);
+
+    // Offline renders run faster than the pager can keep up with, and aren't real-time anyway
+    if (writeMode && isNonRealtime() && ghostScope.hasStorage())
+        ghostMap.servicePages();
+    if (freezeArmed && isNonRealtime())
+        frozenGainMap.servicePages();
+
     if (writeMode && isPlaying) {
         ghostLedState.store(2);
     } else if (writeMode && !isPlaying) {
@@ -180,199 +361,540 @@ void PluginProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::Midi
         lastWrittenIdx[1] = -1;
     }
 
-    float attackTime = (mode == 1) ? 0.015f : ((mode == 2) ? 0.002f : 0.001f);
-    float releaseTime = (mode == 1) ? 0.030f : ((mode == 2) ? musicalRelease * 8.0f : musicalRelease);
-    float attackCoeff = 1.0f - std::exp(-1.0f / (attackTime * sampleRateSafe));
-    float releaseCoeff = 1.0f - std::exp(-1.0f / (releaseTime * sampleRateSafe));
+    // ==========================================================
+    // STAGE DISPATCH (resolved once per block)
+    // ==========================================================
+    const bool ghostWrite = writeMode && isPlaying;
+    const bool ghostRead  = readMode && isPlaying;
+    const bool ghostIdle  = readMode && ! isPlaying; // replay armed but stopped: the fader sits at unity
+    const bool freezeCapture = freezeArmed && isPlaying;
+
+    if (! freezeCapture) {
+        lastFrozenIdx[0] = -1;
+        lastFrozenIdx[1] = -1;
+    } else {
+        frozenWithLookahead.store(lookaheadActive);
+    }
+
+    const auto stages = selectStages(mode, flipOn, shredOn ? shredMode : 0, chopOn, ghostRead);
+
+    // The followers don't run while frozen, so the level meters rest. FLIP is already in the
+    // captured gain; SHRED still runs on top of it.
+    if (frozen) {
+        // A gain captured under LOOK was meant for the input lookaheadSamples earlier, so it's
+        // read that much later or earlier if LOOK has changed since
+        auto replayClock = frozenClock;
+        const int capturedDelay = frozenWithLookahead.load() ? lookaheadSamples : 0;
+        const int heardDelay = lookaheadActive ? lookaheadSamples : 0;
+        replayClock.startPPQ += (double) (capturedDelay - heardDelay) * replayClock.ppqPerSample;
+
+        const auto frozenStages = selectStages(mode, false, shredOn ? shredMode : 0, false, false);
+        updateMeters(0.0f, 0.0f, 0.0f, processFrozen(mainBlock, numChannels, isPlaying, replayClock, frozenStages));
+        return;
+    }
 
     float maxLiveRMS = 0.0f;
     float maxGuideRMS = 0.0f;
     float maxFaderVal = 0.0f;
     float displayGhostTarget = 0.0f;
 
-    // ==========================================================
-    // THE SAMPLE-ACCURATE ENGINE
-    // ==========================================================
-    for (int i = 0; i < numSamples; ++i) 
+    for (int start = 0; maxBlockSize > 0 && start < numSamples; start += maxBlockSize)
     {
-        double exactSamplePPQ = currentPPQ + (i * ppqPerSample);
-        double exactIndex = exactSamplePPQ * ppqResolution;
-        int arrayIdx = (int)exactIndex;
+        const int n = std::min(maxBlockSize, numSamples - start);
+
+        // 1. Detection, all four followers in one pass
+        const float* liveIn[2] { nullptr, nullptr };
+        const float* guideIn[2] { nullptr, nullptr };
+        EngineStages::DetectorOutput detected[2];
+
+        for (int ch = 0; ch < numChannels; ++ch) {
+            liveIn[ch] = mainBlock.getChannelPointer((size_t) ch) + start;
+            guideIn[ch] = (guideChannels[ch] != nullptr) ? guideChannels[ch] + start : nullptr;
+            detected[ch] = { scratchFor(Scratch::liveRMS, ch), scratchFor(Scratch::guideRMS, ch),
+                             scratchFor(Scratch::peakLive, ch), scratchFor(Scratch::peakGuide, ch) };
+        }
 
-        for (int ch = 0; ch < numChannels; ++ch) 
+        detector.process(liveIn, guideIn, numChannels, n, detected);
+
+        for (int ch = 0; ch < numChannels; ++ch)
         {
-            float liveSample = mainBuffer.getSample(ch, i);
-            float guideSample = liveSample; 
-            
-            if (forceExt && hasSidechain) {
-                int scCh = (ch < scChannels) ? ch : 0;
-                guideSample = scBuffer.getSample(scCh, i);
-            } else if (forceExt && !hasSidechain) {
-                guideSample = 0.0f; 
+            float* live = mainBlock.getChannelPointer((size_t) ch) + start;
+
+            float* liveRMS   = scratchFor(Scratch::liveRMS, ch);
+            float* guideRMS  = scratchFor(Scratch::guideRMS, ch);
+            float* peakLive  = scratchFor(Scratch::peakLive, ch);
+            float* peakGuide = scratchFor(Scratch::peakGuide, ch);
+            float* present   = scratchFor(Scratch::ghostPresent, ch);
+            float* gain      = scratchFor(Scratch::targetGain, ch);
+            float* fader     = scratchFor(Scratch::fader, ch);
+            float* wet       = scratchFor(Scratch::wet, ch);
+
+            // With lookahead, the delayed input is what gets ridden, and the gain computer
+            // sees the loudest live level in the window ahead of it
+            const float* dry = live;
+
+            if (lookaheadActive) {
+                float* delayed = scratchFor(Scratch::delayed, ch);
+                delayLive(ch, live, delayed, n);
+                lookaheadLevel[ch].process(liveRMS, liveRMS, n);
+                dry = delayed;
             }
 
-            envStateLive[ch] = envCoeff * envStateLive[ch] + (1.0f - envCoeff) * (liveSample * liveSample);
-            float currentLiveRMS = std::sqrt(envStateLive[ch]);
-            
-            envStateGuide[ch] = envCoeff * envStateGuide[ch] + (1.0f - envCoeff) * (guideSample * guideSample);
-            float currentGuideRMS = std::sqrt(envStateGuide[ch]);
-            
-            peakStateLive[ch] = std::max(std::abs(liveSample), peakStateLive[ch] * peakReleaseCoeff);
-            peakStateGuide[ch] = std::max(std::abs(guideSample), peakStateGuide[ch] * peakReleaseCoeff);
-
-            // Phase-Locked Capture: Writes only ONCE perfectly on the index boundary.
-            if (writeMode && isPlaying && arrayIdx >= 0 && arrayIdx < (int)ghostMapL.size()) {
-                if (arrayIdx != lastWrittenIdx[ch]) {
-                    if (lastWrittenIdx[ch] >= 0 && arrayIdx > lastWrittenIdx[ch] + 1) {
-                        int gap = arrayIdx - lastWrittenIdx[ch];
-                        if (gap < 50) { 
-                            for (int fill = lastWrittenIdx[ch] + 1; fill < arrayIdx; ++fill) {
-                                if (ch == 0) ghostMapL[fill] = currentGuideRMS;
-                                if (ch == 1) ghostMapR[fill] = currentGuideRMS;
-                            }
-                        }
-                    }
-                    if (ch == 0) ghostMapL[arrayIdx] = currentGuideRMS;
-                    if (ch == 1) ghostMapR[arrayIdx] = currentGuideRMS;
-                    lastWrittenIdx[ch] = arrayIdx;
-                    if (ch == 0) lastRecordedPPQ.store(exactSamplePPQ);
-                }
-            }
+            // 2. Ghost IO
+            float* target = guideRMS;
 
-            float targetRMS = currentGuideRMS; 
-            float targetGain = 1.0f;
+            if (ghostWrite) {
+                auto ppq = EngineStages::recordGhost(ghostMap, ch, guideRMS, start, n, ghostClock, lastWrittenIdx[ch]);
+                if (ch == 0 && ppq >= 0.0) lastRecordedPPQ.store(ppq);
+            }
 
-            bool hasGhostData = false;
-            if (readMode && isPlaying && arrayIdx >= 0 && arrayIdx + 1 < (int)ghostMapL.size()) {
-                float val1 = (ch == 0) ? ghostMapL[arrayIdx] : ghostMapR[arrayIdx];
-                float val2 = (ch == 0) ? ghostMapL[arrayIdx + 1] : ghostMapR[arrayIdx + 1];
-                
-                if (val1 >= 0.0f && val2 >= 0.0f) {
-                    hasGhostData = true;
-                    float fraction = (float)(exactIndex - (double)arrayIdx);
-                    
-                    // Exponential Interpolator with Epsilon guards
-                    if (val1 > val2 && val2 > 0.00001f && val1 > 0.00001f) {
-                        targetRMS = val1 * std::pow(val2 / val1, fraction); 
-                    } else {
-                        targetRMS = val1 + fraction * (val2 - val1); 
-                    }
-                    
-                    if (ch == 0) displayGhostTarget = targetRMS;
-                }
+            if (ghostRead) {
+                float* ghostTarget = scratchFor(Scratch::ghostTarget, ch);
+                auto lastTarget = EngineStages::replayGhost(ghostMap, ch, guideRMS, start, n, ghostClock, ghostTarget, present,
+                                                            lookaheadOn ? &ghostLookahead : nullptr);
+                if (ch == 0 && lastTarget >= 0.0f) displayGhostTarget = lastTarget;
+                target = ghostTarget;
             }
 
-            if (readMode && (!isPlaying || !hasGhostData)) {
-                targetGain = (!isPlaying) ? 1.0f : 0.0f; 
+            // Under LOOK the guide side waits along with the input it's matched against
+            if (lookaheadActive) {
+                delayGuide(ch, target, n);
+                delayGuide(2 + ch, peakGuide, n);
+                if (ghostRead) delayGuide(4 + ch, present, n);
             }
-            else if (currentLiveRMS >= 0.00001f) {
-                if (targetRMS < 0.00001f) {
-                    targetGain = 0.0f;
-                } else {
-                    float desiredLevel = targetRMS;
-
-                    if (mode == 2) {
-                        float threshX = 0.25f;  
-                        float threshY = 0.01f;  
-                        float exp = (ratio == 1) ? 0.5f : (1.0f / (float)ratio);
-
-                        if (desiredLevel < threshX && desiredLevel > threshY) {
-                            desiredLevel = threshX * std::pow(desiredLevel / threshX, exp);
-                        } else if (desiredLevel <= threshY) {
-                            float maxMult = std::pow(threshX / threshY, exp); 
-                            float fade = desiredLevel / threshY; 
-                            desiredLevel = desiredLevel * (1.0f + ((maxMult - 1.0f) * fade));
-                        }
-                    }
-
-                    targetGain = desiredLevel / currentLiveRMS; 
-
-                    if (mode == 1 && ratio > 1) {
-                        float db = 20.0f * std::log10(targetGain);
-                        targetGain = std::pow(10.0f, (db * (float)ratio) / 20.0f);
-                    }
-
-                    bool isTransient = false;
-                    if (mode == 3) {
-                        float dryCrest = peakStateGuide[ch] / (targetRMS + 0.00001f);
-                        float inCrest = peakStateLive[ch] / (currentLiveRMS + 0.00001f);
-                        float loudComp = 1.0f + (1.0f - juce::jmin(1.0f, peakStateGuide[ch]));
-                        
-                        if (dryCrest > inCrest + 0.05f) {
-                            targetGain *= ((dryCrest / inCrest) * loudComp * 0.8f);
-                            isTransient = true;
-                        } else if (std::abs(dryCrest - inCrest) <= 0.05f && dryCrest > 2.0f) {
-                            targetGain *= std::min(1.0f + (0.09f * ratio * dryCrest * loudComp), 3.0f);
-                            isTransient = true;
-                        }
-                    }
-
-                    targetGain = std::clamp(targetGain, 0.0f, 32.0f);
-                    if (mode == 2 && currentLiveRMS >= 0.25f) targetGain = 1.0f;
+
+            // 3. Gain computer
+            if (ghostIdle)
+                juce::FloatVectorOperations::fill(gain, 1.0f, n);
+            else
+                stages.gainComputer({ target, liveRMS, peakLive, peakGuide, present }, ratio, gain, n);
+
+            // 4. Ballistics
+            const float attackCoeff = lookaheadActive ? 1.0f : faderTiming.attackCoeff; // the lookahead does the attack
+            stages.ballistics(gain, fader, n, attackCoeff, faderTiming.releaseCoeff, currentFaderGain[ch], forceSnapFader && start == 0);
+
+            // Freeze captures the gain the input actually gets, so under FLIP it's the inverted fader
+            if (freezeCapture) {
+                const float* applied = fader;
+
+                if (flipOn) {
+                    EngineStages::flipGain(fader, wet, n);
+                    applied = wet;
                 }
-            }
 
-            if (forceSnapFader && i == 0) {
-                currentFaderGain[ch] = targetGain; 
-            } else {
-                bool useFast = (mode == 3) ? (targetGain > currentFaderGain[ch]) : (targetGain < currentFaderGain[ch]);
-                currentFaderGain[ch] += (useFast ? attackCoeff : releaseCoeff) * (targetGain - currentFaderGain[ch]);
+                EngineStages::recordGhost(frozenGainMap, ch, applied, start, n, frozenClock, lastFrozenIdx[ch]);
             }
 
-            float outSample = liveSample * (flipOn ? (1.0f / std::max(currentFaderGain[ch], 0.1f)) : currentFaderGain[ch]);
-
-            if (shredOn) {
-                if (shredMode == 1) {
-                    outSample = (outSample * 0.5f) + (std::sin(outSample * 25.0f) * 0.25f);
-                } else if (shredMode == 2) {
-                    int holdTarget = juce::jmax(1, (int)(musicalRelease * sampleRateSafe * 0.45f));
-                    if (holdCounter[ch] >= holdTarget) {
-                        heldSample[ch] = outSample;
-                        holdCounter[ch] = 0;
-                    } else {
-                        outSample = heldSample[ch];
-                        holdCounter[ch]++;
-                    }
-                    float fatDry = std::tanh(liveSample * 2.0f) * 0.5f;
-                    outSample = fatDry + (outSample * 0.8f); 
-                } else if (shredMode == 3) {
-                    outSample = std::tanh(outSample * 50.0f) * 0.3f;
-                }
-            } else {
-                heldSample[ch] = outSample;
-                holdCounter[ch] = 0;
+            // 5. Modifiers, 6. Clip
+            stages.modifiers({ dry, fader, target, peakGuide }, wet, n, chopThresh, faderTiming.holdTarget, shredState[ch]);
+            stages.clip(wet, live, n);
+
+            maxLiveRMS  = std::max(maxLiveRMS,  juce::FloatVectorOperations::findMaximum(liveRMS, n));
+            maxGuideRMS = std::max(maxGuideRMS, juce::FloatVectorOperations::findMaximum(target, n));
+            maxFaderVal = std::max(maxFaderVal, juce::FloatVectorOperations::findMaximum(fader, n));
+        }
+
+        writeRide(numChannels, n);
+    }
+
+    updateMeters(maxLiveRMS, maxGuideRMS, displayGhostTarget, maxFaderVal);
+}
+
+float PluginProcessor::processFrozen (juce::dsp::AudioBlock<float>& mainBlock, int numChannels, bool isPlaying,
+                                      const EngineStages::GhostClock& clock, const StageSet& stages) noexcept
+{
+    const int numSamples = (int) mainBlock.getNumSamples();
+    float maxGain = 0.0f;
+
+    for (int start = 0; maxBlockSize > 0 && start < numSamples; start += maxBlockSize)
+    {
+        const int n = std::min(maxBlockSize, numSamples - start);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            float* live  = mainBlock.getChannelPointer((size_t) ch) + start;
+            float* fader = scratchFor(Scratch::fader, ch);
+            float* wet   = scratchFor(Scratch::wet, ch);
+
+            // Stopped, the fader sits at unity, as in Ghost read mode
+            if (isPlaying)
+                EngineStages::replayFrozenGain(frozenGainMap, ch, start, n, clock, fader, scratchFor(Scratch::ghostPresent, ch));
+            else
+                juce::FloatVectorOperations::fill(fader, 1.0f, n);
+
+            const float* dry = live;
+
+            if (lookaheadActive) {
+                float* delayed = scratchFor(Scratch::delayed, ch);
+                delayLive(ch, live, delayed, n);
+                dry = delayed;
             }
 
-            if (chopOn && targetRMS < (peakStateGuide[ch] * chopThresh)) outSample = 0.0f;
+            stages.modifiers({ dry, fader, nullptr, nullptr }, wet, n, 0.0f, faderTiming.holdTarget, shredState[ch]);
+            stages.clip(wet, live, n);
+
+            currentFaderGain[ch] = fader[n - 1];
+            maxGain = std::max(maxGain, juce::FloatVectorOperations::findMaximum(fader, n));
+        }
+
+        writeRide(numChannels, n);
+    }
 
-            if (shredOn || mode != 3) {
-                outSample = std::clamp(outSample, -1.0f, 1.0f);
-            } else {
-                outSample = std::tanh(outSample * 1.05f); 
+    return maxGain;
+}
+
+void PluginProcessor::delayLive (int channel, const float* live, float* delayed, int numSamples) noexcept
+{
+    for (int i = 0; i < numSamples; ++i) {
+        lookaheadDelay.pushSample(channel, live[i]);
+        delayed[i] = lookaheadDelay.popSample(channel);
+    }
+}
+
+void PluginProcessor::delayGuide (int lane, float* values, int numSamples) noexcept
+{
+    for (int i = 0; i < numSamples; ++i) {
+        guideDelay.pushSample(lane, values[i]);
+        values[i] = guideDelay.popSample(lane);
+    }
+}
+
+// ==========================================================
+// CLAP DIRECT PROCESS
+// ==========================================================
+namespace
+{
+    // The events that change what the engine does from their sample on
+    bool splitsBlock (const clap_event_header& event) noexcept
+    {
+        return event.space_id == CLAP_CORE_EVENT_SPACE_ID
+            && (event.type == CLAP_EVENT_PARAM_VALUE || event.type == CLAP_EVENT_TRANSPORT);
+    }
+}
+
+clap_process_status PluginProcessor::clap_direct_process (const clap_process* process) noexcept
+{
+    // Going through the wrapper keeps the host from hearing its own automation back
+    return processClap(*process, [] (PluginProcessor& processor, const clap_event_param_value& event) {
+        processor.handleParameterChange(&event);
+    });
+}
+
+clap_process_status PluginProcessor::processClap (const clap_process& process, ParameterEventHandler handleEvent) noexcept
+{
+    juce::ScopedNoDenormals noDenormals;
+
+    if (process.audio_outputs_count < 1 || process.audio_inputs_count < 1
+        || process.audio_outputs[0].data32 == nullptr || process.audio_inputs[0].data32 == nullptr)
+        return CLAP_PROCESS_ERROR;
+
+    const int numSamples = (int) process.frames_count;
+    const auto& mainOut = process.audio_outputs[0];
+    const auto& mainIn = process.audio_inputs[0];
+
+    // The engine rides the main bus in place, so the input only needs moving when the host
+    // keeps separate input and output buffers. The sidechain is only ever read.
+    juce::dsp::AudioBlock<float> mainBlock(mainOut.data32, mainOut.channel_count, (size_t) numSamples);
+
+    for (uint32_t ch = 0; ch < mainOut.channel_count; ++ch) {
+        if (ch >= mainIn.channel_count)
+            juce::FloatVectorOperations::clear(mainOut.data32[ch], numSamples);
+        else if (mainIn.data32[ch] != mainOut.data32[ch])
+            juce::FloatVectorOperations::copy(mainOut.data32[ch], mainIn.data32[ch], numSamples);
+    }
+
+    if (isSuspended()) {
+        mainBlock.clear();
+        return CLAP_PROCESS_CONTINUE;
+    }
+
+    juce::dsp::AudioBlock<float> scBlock;
+    auto* sidechainBus = getBus(true, 1);
+
+    if (process.audio_inputs_count > 1 && process.audio_inputs[1].data32 != nullptr
+        && sidechainBus != nullptr && sidechainBus->isEnabled())
+        scBlock = { process.audio_inputs[1].data32,
+                    (size_t) juce::jmin((int) process.audio_inputs[1].channel_count, sidechainBus->getNumberOfChannels()),
+                    (size_t) numSamples };
+
+    ClapTransport transport;
+    transport.set(process.transport, 0);
+    rideThinner.beginBlock();
+
+    const auto* events = process.in_events;
+    const uint32_t numEvents = (events != nullptr) ? events->size(events) : 0;
+    uint32_t nextEvent = 0;
+
+    const auto applyEvent = [&] (const clap_event_header& event, int time) {
+        if (event.space_id != CLAP_CORE_EVENT_SPACE_ID)
+            return;
+
+        if (event.type == CLAP_EVENT_PARAM_VALUE)
+            handleEvent(*this, reinterpret_cast<const clap_event_param_value&>(event));
+        else if (event.type == CLAP_EVENT_TRANSPORT)
+            transport.set(reinterpret_cast<const clap_event_transport*>(&event), time);
+    };
+
+    for (int start = 0; start < numSamples;)
+    {
+        // Everything stamped up to here applies before this sample is processed
+        for (; nextEvent < numEvents; ++nextEvent) {
+            const auto* event = events->get(events, nextEvent);
+            if ((int) event->time > start) break;
+            applyEvent(*event, start);
+        }
+
+        // Run up to the next event that changes the engine; anything else waits for that boundary
+        int end = numSamples;
+        for (auto i = nextEvent; i < numEvents; ++i) {
+            const auto* event = events->get(events, i);
+            if (splitsBlock(*event)) {
+                end = std::min(numSamples, (int) event->time);
+                break;
             }
+        }
+
+        auto mainPiece = mainBlock.getSubBlock((size_t) start, (size_t) (end - start));
+        const auto scPiece = (scBlock.getNumChannels() > 0) ? scBlock.getSubBlock((size_t) start, (size_t) (end - start)) : scBlock;
+        processBuses(mainPiece, scPiece, transport.at(start, currentSampleRate));
+
+        start = end;
+    }
+
+    // Stamped at or past the end of the block: they still count from the next block on
+    for (; nextEvent < numEvents; ++nextEvent)
+        applyEvent(*events->get(events, nextEvent), numSamples);
 
-            mainBuffer.setSample(ch, i, outSample);
+    sendRide(process.out_events);
+    return CLAP_PROCESS_CONTINUE;
+}
 
-            maxLiveRMS = std::max(maxLiveRMS, currentLiveRMS);
-            maxGuideRMS = std::max(maxGuideRMS, targetRMS);
-            maxFaderVal = std::max(maxFaderVal, currentFaderGain[ch]);
+void PluginProcessor::writeRide (int numChannels, int numSamples) noexcept
+{
+    // Not writing, the thinner still counts the samples so breakpoints land at the right time
+    const float* faders[2] { scratchFor(Scratch::fader, 0), scratchFor(Scratch::fader, 1) };
+    rideThinner.process(faders, rideWriting ? numChannels : 0, numSamples);
+}
+
+void PluginProcessor::sendRide (const clap_output_events* out) noexcept
+{
+    if (out == nullptr)
+        return;
+
+    const auto sendGesture = [&] (uint16_t type, uint32_t time) {
+        clap_event_param_gesture gesture {};
+        gesture.header = { sizeof(gesture), time, CLAP_CORE_EVENT_SPACE_ID, type, 0 };
+        gesture.param_id = rideGainClapID;
+        out->try_push(out, &gesture.header);
+    };
+
+    for (int i = 0; i < rideThinner.getNumPoints(); ++i) {
+        const auto& point = rideThinner.getPoint(i);
+        const auto time = (uint32_t) point.time;
+
+        // Each stretch of playing goes out as one gesture, so hosts in touch mode record it
+        if (! rideGestureOpen) {
+            sendGesture(CLAP_EVENT_PARAM_GESTURE_BEGIN, time);
+            rideGestureOpen = true;
+        }
+
+        const auto normalised = (double) parameters.rideGain.convertTo0to1(point.gainDb);
+
+        clap_event_param_value event {};
+        event.header = { sizeof(event), time, CLAP_CORE_EVENT_SPACE_ID, CLAP_EVENT_PARAM_VALUE, 0 };
+        event.param_id = rideGainClapID;
+        event.note_id = -1;
+        event.port_index = -1;
+        event.channel = -1;
+        event.key = -1;
+        event.value = normalised; // the wrapper gives hosts every parameter as 0..1
+        out->try_push(out, &event.header);
+
+        // The host now takes the parameter to be here; setValue() tells no listeners, so it stays lock-free
+        static_cast<juce::AudioProcessorParameter&>(parameters.rideGain).setValue(normalised);
+
+        if (point.endsLine) {
+            sendGesture(CLAP_EVENT_PARAM_GESTURE_END, time);
+            rideGestureOpen = false;
         }
     }
+}
 
-    // ==========================================================
-    // UI UPDATES
-    // ==========================================================
-    mainBusLevel.store(maxLiveRMS);
-    sidechainBusLevel.store(maxGuideRMS);
-    currentGhostTargetUI.store(displayGhostTarget);
-    
-    if (maxFaderVal <= 0.00001f) currentGainDb.store(-100.0f);
-    else                         currentGainDb.store(20.0f * std::log10(maxFaderVal));
+// ==========================================================
+// UI UPDATES
+// ==========================================================
+void PluginProcessor::updateMeters (float liveLevel, float guideLevel, float ghostTarget, float faderGain) noexcept
+{
+    mainBusLevel.store(liveLevel);
+    sidechainBusLevel.store(guideLevel);
+    currentGhostTargetUI.store(ghostTarget);
+
+    if (faderGain <= 0.00001f) currentGainDb.store(-100.0f);
+    else                       currentGainDb.store(20.0f * std::log10(faderGain));
+}
+
+//==============================================================================
+juce::dsp::AudioBlock<float> PluginProcessor::getBusBlock (juce::AudioBuffer<float>& buffer, bool isInput, int busIndex) const noexcept
+{
+    auto* bus = getBus(isInput, busIndex);
+
+    if (bus == nullptr || ! bus->isEnabled())
+        return {};
+
+    // Same channel mapping as getBusBuffer(), but as a view: no AudioBuffer gets built or copied
+    const auto firstChannel = getChannelIndexInProcessBlockBuffer(isInput, busIndex, 0);
+    const auto numBusChannels = juce::jmin(bus->getNumberOfChannels(), buffer.getNumChannels() - firstChannel);
+
+    if (numBusChannels <= 0)
+        return {};
+
+    return juce::dsp::AudioBlock<float>(buffer).getSubsetChannelBlock((size_t) firstChannel, (size_t) numBusChannels);
+}
+
+//==============================================================================
+PluginProcessor::StageSet PluginProcessor::selectStages (int mode, bool flip, int shred, bool chop, bool replay) noexcept
+{
+    using namespace EngineStages;
+
+    static constexpr GainComputer gainComputers[4][2] {
+        { &computeGain<0, false>, &computeGain<0, true> },
+        { &computeGain<1, false>, &computeGain<1, true> },
+        { &computeGain<2, false>, &computeGain<2, true> },
+        { &computeGain<3, false>, &computeGain<3, true> },
+    };
+
+    // Indexed as [flip][shred][chop]
+    static constexpr auto modifiers = [] <size_t... I> (std::index_sequence<I...>) {
+        return std::array<Modifiers, sizeof...(I)> { &applyModifiers<((I / 8) != 0), (int) ((I / 2) % 4), ((I % 2) != 0)>... };
+    } (std::make_index_sequence<2 * 4 * 2>());
+
+    StageSet set;
+    set.gainComputer = gainComputers[mode][replay ? 1 : 0];
+    set.ballistics = (mode == 3) ? &applyBallistics<true> : &applyBallistics<false>;
+    set.modifiers = modifiers[(size_t) (((flip ? 1 : 0) * 4 + shred) * 2 + (chop ? 1 : 0))];
+    set.clip = (shred == 0 && mode == 3) ? &clipOutput<true> : &clipOutput<false>;
+    return set;
 }
 
 //==============================================================================
 bool PluginProcessor::hasEditor() const { return true; }
 juce::AudioProcessorEditor* PluginProcessor::createEditor() { return new PluginEditor (*this); }
-void PluginProcessor::getStateInformation (juce::MemoryBlock& destData) { juce::ignoreUnused (destData); }
-void PluginProcessor::setStateInformation (const void* data, int sizeInBytes) { juce::ignoreUnused (data, sizeInBytes); }
+
+void PluginProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    juce::MemoryOutputStream out (destData, false);
+    PluginState::writeHeader (out);
+
+    juce::MemoryOutputStream params;
+    parameters.writeState (params);
+    PluginState::writeSection (out, PluginState::parametersTag, params.getMemoryBlock());
+
+    juce::MemoryOutputStream ghosts;
+    ghostLibrary.writeState (ghosts);
+    PluginState::writeSection (out, PluginState::ghostLibraryTag, ghosts.getMemoryBlock());
+
+    std::uint32_t switches = 0;
+
+    if (isFrozen.load())
+        switches |= PluginState::frozenFlag;
+
+    if (lookaheadEnabled.load())
+        switches |= PluginState::lookaheadFlag;
+
+    if (frozenWithLookahead.load())
+        switches |= PluginState::frozenLookaheadFlag;
+
+    if (switches != 0)
+    {
+        juce::MemoryOutputStream flags;
+        flags.writeInt ((int) switches);
+        PluginState::writeSection (out, PluginState::switchesTag, flags.getMemoryBlock());
+    }
+
+    // Nothing captured, or the curve was dropped, nothing to store: a missing section loads as an
+    // empty curve. Dropping it keeps the pages but forgets the grid.
+    if (frozenGainMap.getNumAllocatedPages() > 0 && frozenGainMap.getResolution() > 0.0)
+    {
+        juce::MemoryOutputStream frozen;
+        frozenGainMap.writeState (frozen);
+        PluginState::writeSection (out, PluginState::frozenGainTag, frozen.getMemoryBlock());
+    }
+}
+
+void PluginProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    struct Section
+    {
+        const void* data = nullptr;
+        size_t size = 0;
+    };
+
+    Section parameterSection, librarySection, singleGhostSection, frozenSection, switchesSection;
+
+    // Nothing changes unless the whole state is ours and reads to the end
+    const auto readable = PluginState::readSections (data, sizeInBytes, [&] (std::uint32_t tag, const void* section, size_t size) {
+        const Section found { section, size };
+
+        if (tag == PluginState::parametersTag)
+            parameterSection = found;
+        else if (tag == PluginState::ghostLibraryTag)
+            librarySection = found;
+        else if (tag == PluginState::ghostTag)
+            singleGhostSection = found;
+        else if (tag == PluginState::frozenGainTag)
+            frozenSection = found;
+        else if (tag == PluginState::switchesTag)
+            switchesSection = found;
+    });
+
+    if (! readable)
+        return;
+
+    // Whatever the state doesn't mention goes back to its default
+    parameters.resetToDefaults();
+
+    if (parameterSection.data != nullptr)
+        parameters.readState (parameterSection.data, parameterSection.size);
+
+    if (librarySection.data != nullptr)
+    {
+        ghostLibrary.readState (librarySection.data, librarySection.size);
+    }
+    else
+    {
+        // From before the Ghost slots: at most one Ghost, which goes in the first slot
+        for (int slot = 0; slot < GhostLibrary::numSlots; ++slot)
+            ghostLibrary.clearSlot (slot);
+
+        ghostLibrary.selectSlot (0);
+
+        if (singleGhostSection.data != nullptr)
+        {
+            auto map = ghostLibrary.createMap();
+
+            if (map->readState (singleGhostSection.data, singleGhostSection.size))
+                ghostLibrary.installSlot (0, std::move (map), {});
+        }
+    }
+
+    // After the Ghosts, whose arrival drops whatever frozen curve there was
+    frozenGainMap.clear();
+
+    if (frozenSection.data != nullptr)
+        frozenGainMap.readState (frozenSection.data, frozenSection.size);
+
+    const auto switches = switchesSection.data != nullptr
+                              ? (std::uint32_t) juce::MemoryInputStream (switchesSection.data, switchesSection.size, false).readInt()
+                              : 0u;
+
+    isFrozen.store ((switches & PluginState::frozenFlag) != 0);
+    frozenWithLookahead.store ((switches & PluginState::frozenLookaheadFlag) != 0);
+
+    // Only touch the latency if it changes, so the host isn't asked to restart for nothing
+    const auto lookahead = (switches & PluginState::lookaheadFlag) != 0;
+
+    if (lookahead != lookaheadEnabled.load())
+        setLookaheadEnabled (lookahead);
+}
+
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter() { return new PluginProcessor(); }
\ No newline at end of file
@@ -1,14 +1,26 @@
 #pragma once
 
 #include <juce_audio_processors/juce_audio_processors.h>
+#include <clap-juce-extensions/clap-juce-extensions.h>
+#include "ClapTransport.h"
+#include "EngineStages.h"
+#include "GhostImport.h"
+#include "GhostLibrary.h"
+#include "GhostMap.h"
+#include "PluginParameters.h"
+#include "RideThinner.h"
+#include "SlidingMax.h"
+#include "StereoDetector.h"
+#include "TransportTracker.h"
 #include <atomic>
-#include <vector>
 
 #if (MSVC)
 #include "ipps.h"
 #endif
 
-class PluginProcessor : public juce::AudioProcessor
+class PluginProcessor : public juce::AudioProcessor,
+                        public clap_juce_extensions::clap_properties,
+                        public clap_juce_extensions::clap_juce_audio_processor_capabilities
 {
 public:
     PluginProcessor();
@@ -21,6 +33,23 @@ public:
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
 
+    // ==========================================================
+    // CLAP DIRECT PROCESS
+    // ==========================================================
+    // Under CLAP the wrapper hands us the host's process call as is. The block is split at
+    // every parameter and transport event, so a mode switch, a CHOP threshold move or a
+    // punch-in on the transport lands on its exact sample, and each piece runs straight on
+    // the host's channel pointers.
+    bool supportsDirectProcess() override { return true; }
+    clap_process_status clap_direct_process (const clap_process* process) noexcept override;
+
+    // Applies one CLAP_EVENT_PARAM_VALUE to its parameter
+    using ParameterEventHandler = void (*) (PluginProcessor&, const clap_event_param_value&);
+
+    // The direct process path, with the parameter events going to handleEvent. Outside the
+    // CLAP wrapper (tests, renders) it can be driven with a handler of its own.
+    clap_process_status processClap (const clap_process& process, ParameterEventHandler handleEvent) noexcept;
+
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
 
@@ -40,22 +69,60 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
+    // ==========================================================
+    // GHOST SCRATCH FILES
+    // ==========================================================
+    // Ghost pages live on the heap. For programs long enough that RAM matters, whatever knows
+    // where the project lives can move them into memory-mapped files in directory: Ghost slots
+    // made from then on, and frozen-curve pages allocated from then on. The pager keeps the
+    // pages around the playhead faulted in, but one the OS dropped can still cost the audio
+    // thread a page fault after a jump, which is why it's not the default.
+    void setGhostScratchDirectory (const juce::File& directory);
+
 private:
     double currentSampleRate { 44100.0 }; 
     
     // ==========================================================
     // SAMPLE-ACCURATE ENVELOPE FOLLOWERS
     // ==========================================================
-    float envStateLive[2]  { 0.0f, 0.0f }; 
-    float envStateGuide[2] { 0.0f, 0.0f }; 
-    float peakStateLive[2] { 0.0f, 0.0f }; 
-    float peakStateGuide[2]{ 0.0f, 0.0f }; 
+    StereoDetector detector;
 
     float envCoeff { 0.0f }; 
     float peakReleaseCoeff { 0.0f };
 
     float currentFaderGain[2] { 1.0f, 1.0f }; 
 
+    // ==========================================================
+    // TRANSPORT & FADER TIMING
+    // ==========================================================
+    TransportTracker transportTracker;
+
+    struct FaderTiming
+    {
+        int mode { -1 }; // -1 forces a recompute on the next block
+        float attackSeconds { 0.0f };
+        float attackCoeff { 0.0f };
+        float releaseCoeff { 0.0f };
+        int holdTarget { 1 };
+    };
+
+    FaderTiming faderTiming;
+
+    // ==========================================================
+    // LOOKAHEAD (MIXING)
+    // ==========================================================
+    // The live signal is heard through a fixed delay while detection runs on the undelayed
+    // input. The gain computer sees the loudest live level over the lookahead window, so the
+    // fader is already down when a loud onset is heard and the attack can be instant. The
+    // guide side (the target, the guide peak and, on replay, whether the Ghost has data) goes
+    // through a delay of its own, so the fader follows the guide as it was when the heard
+    // sample came in.
+    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::None> lookaheadDelay;
+    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::None> guideDelay; // target, peakGuide, present: two channels each
+    SlidingMax lookaheadLevel[2];
+    int lookaheadSamples { 0 };
+    bool lookaheadActive { false };
+
     // Audio level tracking for UI
     std::atomic<float> mainBusLevel { 0.0f };
     std::atomic<float> sidechainBusLevel { 0.0f };
@@ -70,16 +137,10 @@ public:
     // ==========================================================
     // MODE & MODIFIER ENGINES
     // ==========================================================
-    std::atomic<int> currentMode { 0 };     
-    std::atomic<bool> isFlipActive { false };
-    std::atomic<bool> isShredActive { false };
-    std::atomic<bool> isChopActive { false };
-    std::atomic<float> chopThreshold { 0.10f }; 
-    std::atomic<int> currentRatio { 1 };
-    
-    std::atomic<int> currentShredMode { 1 }; 
-    float heldSample[8] { 0.0f };  
-    int holdCounter[8] { 0 };   
+    // Mode, modifiers, ratio and guide source: automatable, read once per block as a snapshot
+    PluginParameters parameters { *this };
+
+    EngineStages::ShredState shredState[2];
     
     // ==========================================================
     // THE GHOST ENGINE MEMORY
@@ -87,9 +148,17 @@ public:
     std::atomic<bool> isGhostRecording { false }; 
     std::atomic<bool> isGhostReading { false };   
 
-    std::vector<float> ghostMapL; 
-    std::vector<float> ghostMapR;
-    std::atomic<bool> forceExternalSidechain { false }; 
+    GhostLibrary ghostLibrary; // the Ghost slots; processBlock reads and records the active one
+    GhostImporter ghostImporter { ghostLibrary }; // fills a slot from a reference file, off the audio thread
+    std::atomic<double> hostBpm { 120.0 }; // the tempo an import defaults to
+
+    // Arms recording into the active slot, creating it if it's empty. Call from the message thread.
+    void startGhostRecording();
+
+    // Lookahead adds lookaheadSeconds of latency, reported to the host. Call from the message thread.
+    static constexpr double lookaheadSeconds = 0.005;
+    void setLookaheadEnabled (bool shouldBeEnabled);
+    bool isLookaheadEnabled() const noexcept { return lookaheadEnabled.load(); }
     
     // UI Feedback States
     std::atomic<int> ghostLedState { 0 }; 
@@ -98,6 +167,106 @@ public:
     // Phase-Locked Capture Tracker
     int lastWrittenIdx[2] { -1, -1 };
 
+    // Predictive replay: the fader pre-ramps one attack time ahead of Ghost level changes
+    std::atomic<bool> isGhostLookahead { false };
+
+    // ==========================================================
+    // FREEZE
+    // ==========================================================
+    // Every played Ghost read pass also captures the gain the fader applies, one value per
+    // Ghost index (under FLIP that's the inverted fader). While frozen, that curve is replayed
+    // as a plain gain: no detection, no gain computer, no ballistics. SHRED and the output clip
+    // still run on top. CHOP's gate needs the guide, so freeze holds off while CHOP is on.
+    // The curve only fits the Ghost it rode, so it's dropped, and freeze switched off, as soon
+    // as the audio thread gets another map or recording starts. It also remembers whether LOOK
+    // was on when it was captured, and is replayed shifted by the difference if that's changed.
+    std::atomic<bool> isFrozen { false };
+    std::atomic<bool> frozenWithLookahead { false };
+
+    juce::SharedResourcePointer<GhostScratchFolders> scratchFolders;
+    GhostMap frozenGainMap;
+    int lastFrozenIdx[2] { -1, -1 };
+
+    // ==========================================================
+    // RIDE OUT
+    // ==========================================================
+    // While on and playing under CLAP, the fader goes out to the host as rideGain automation,
+    // thinned to the breakpoints that matter, so a host can record the ride into a lane. The
+    // lane belongs to the plugin's own parameter and goes when the plugin is removed; moving
+    // it onto the track's volume is up to the host. Other formats have no way to take it.
+    std::atomic<bool> isRideWriting { false };
+    std::atomic<float> rideToleranceDb { 0.25f };
+
+    // Whether this instance runs under the CLAP wrapper, the only one that takes the ride.
+    // JUCE has no wrapper type for CLAP, so it's the one that leaves wrapperType undefined.
+    bool canWriteRide() const noexcept { return is_clap && wrapperType == wrapperType_Undefined; }
+
 private:
+    // ==========================================================
+    // STAGE SCRATCH & DISPATCH
+    // ==========================================================
+    enum class Scratch { liveRMS, guideRMS, peakLive, peakGuide, ghostTarget, ghostPresent, targetGain, fader, wet, delayed, numScratch };
+
+    int maxBlockSize { 0 };
+    juce::AudioBuffer<float> scratch; // two channels per Scratch entry, sized in prepareToPlay
+
+    float* scratchFor (Scratch which, int channel) noexcept { return scratch.getWritePointer ((int) which * 2 + channel); }
+
+    using GainComputer = void (*) (const EngineStages::GainComputerInput&, int, float*, int) noexcept;
+    using Ballistics = void (*) (const float*, float*, int, float, float, float&, bool) noexcept;
+    using Modifiers = void (*) (const EngineStages::ModifierInput&, float*, int, float, int, EngineStages::ShredState&) noexcept;
+    using Clip = void (*) (const float*, float*, int) noexcept;
+
+    struct StageSet
+    {
+        GainComputer gainComputer;
+        Ballistics ballistics;
+        Modifiers modifiers;
+        Clip clip;
+    };
+
+    // Non-owning view of one bus inside the process buffer (empty if the bus is disabled)
+    juce::dsp::AudioBlock<float> getBusBlock (juce::AudioBuffer<float>& buffer, bool isInput, int busIndex) const noexcept;
+
+    static StageSet selectStages (int mode, bool flip, int shred, bool chop, bool replay) noexcept;
+
+    // Runs the engine over one stretch of audio, in place on the main bus, starting at position
+    void processBuses (juce::dsp::AudioBlock<float>& mainBlock, const juce::dsp::AudioBlock<float>& scBlock,
+                       const TransportTracker::Position& position) noexcept;
+
+    // Replays the frozen gain over the main bus, through SHRED and the clip. Returns the largest gain applied.
+    float processFrozen (juce::dsp::AudioBlock<float>& mainBlock, int numChannels, bool isPlaying,
+                         const EngineStages::GhostClock& clock, const StageSet& stages) noexcept;
+
+    void updateMeters (float liveLevel, float guideLevel, float ghostTarget, float faderGain) noexcept;
+
+    // Switches freeze off and forgets the captured curve
+    void discardFrozenGain();
+
+    bool wasFrozen { false };
+    const GhostMap* lastGhost { nullptr }; // the active slot's map on the previous block
+    std::atomic<bool> lookaheadEnabled { false };
+
+    // Feeds one channel of live input through the lookahead delay
+    void delayLive (int channel, const float* live, float* delayed, int numSamples) noexcept;
+
+    // Delays one channel of the guide side in place; lane is the guideDelay channel
+    void delayGuide (int lane, float* values, int numSamples) noexcept;
+
+    EngineStages::GhostLookahead ghostLookahead;
+
+    RideThinner rideThinner;
+    bool rideWriting { false };
+    bool rideGestureOpen { false };
+    const clap_id rideGainClapID { (clap_id) parameters.rideGain.getParameterID().hashCode() }; // the ID the CLAP wrapper gives it
+
+    // Feeds one stretch of the fader to the thinner, if the ride is going out
+    void writeRide (int numChannels, int numSamples) noexcept;
+
+    // Sends the block's breakpoints as rideGain parameter events, inside gestures
+    void sendRide (const clap_output_events* out) noexcept;
+
+    juce::SharedResourcePointer<GhostPager> ghostPager;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginProcessor)
 };
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <cstdint>
+
+// ==========================================================
+// THE PLUGIN STATE FORMAT
+// ==========================================================
+// A small chunked binary format, so sections can be added later without
+// breaking old projects:
+//
+//   uint32 magic ("RIDR"), uint32 format version,
+//   then any number of sections: uint32 tag, uint32 size, size bytes of payload
+//
+// All integers are little-endian. Readers skip sections they don't know.
+namespace PluginState
+{
+    constexpr std::uint32_t makeTag (const char (&name)[5]) noexcept
+    {
+        return (std::uint32_t) (std::uint8_t) name[0]
+             | ((std::uint32_t) (std::uint8_t) name[1] << 8)
+             | ((std::uint32_t) (std::uint8_t) name[2] << 16)
+             | ((std::uint32_t) (std::uint8_t) name[3] << 24);
+    }
+
+    inline constexpr std::uint32_t magic = makeTag ("RIDR");
+    inline constexpr int formatVersion = 1;
+
+    inline constexpr std::uint32_t ghostTag = makeTag ("GHST"); // a single Ghost; only read, into slot 1
+    inline constexpr std::uint32_t ghostLibraryTag = makeTag ("GLIB"); // every Ghost slot, see GhostLibrary
+    inline constexpr std::uint32_t frozenGainTag = makeTag ("FRZN"); // the fader captured for freeze, same format as GHST
+    inline constexpr std::uint32_t parametersTag = makeTag ("PARM"); // the automatable parameters, see PluginParameters
+    inline constexpr std::uint32_t switchesTag = makeTag ("SWCH"); // uint32 of the switch flags below
+
+    // The switches that aren't parameters. Only written when one is on.
+    inline constexpr std::uint32_t frozenFlag = 1u << 0;
+    inline constexpr std::uint32_t lookaheadFlag = 1u << 1;
+    inline constexpr std::uint32_t frozenLookaheadFlag = 1u << 2; // the frozen curve was captured with LOOK on
+
+    inline void writeHeader (juce::OutputStream& out)
+    {
+        out.writeInt ((int) magic);
+        out.writeInt (formatVersion);
+    }
+
+    inline void writeSection (juce::OutputStream& out, std::uint32_t tag, const juce::MemoryBlock& payload)
+    {
+        out.writeInt ((int) tag);
+        out.writeInt ((int) payload.getSize());
+        out.write (payload.getData(), payload.getSize());
+    }
+
+    // Calls callback (tag, data, size) for each section. Returns false if this isn't our state, it's
+    // from a newer version, or it's cut short; by then the sections before the cut have been
+    // through callback, so collect them and only apply them once this has returned true.
+    template <typename Callback>
+    bool readSections (const void* data, int sizeInBytes, Callback&& callback)
+    {
+        juce::MemoryInputStream in (data, (size_t) juce::jmax (0, sizeInBytes), false);
+
+        if (in.getTotalLength() < 8 || (std::uint32_t) in.readInt() != magic)
+            return false;
+
+        if (in.readInt() > formatVersion)
+            return false;
+
+        while (in.getNumBytesRemaining() >= 8)
+        {
+            const auto tag = (std::uint32_t) in.readInt();
+            const auto size = (juce::int64) (std::uint32_t) in.readInt();
+
+            if (size > in.getNumBytesRemaining())
+                return false;
+
+            callback (tag, static_cast<const char*> (in.getData()) + in.getPosition(), (size_t) size);
+            in.skipNextBytes (size);
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+// ==========================================================
+// THE RIDE THINNER
+// ==========================================================
+// Turns the fader into a handful of automation breakpoints. The gain is
+// sampled every stepSamples, in dB. A point is only kept if dropping it
+// would move the line between the neighbouring breakpoints by more than
+// toleranceDb. This is Ramer-Douglas-Peucker run as an opening window, so
+// it can keep up with the audio as it comes in.
+//
+// Points collect after the last breakpoint for as long as a straight line
+// to the newest one passes within the tolerance of all of them. Once it
+// doesn't, the point before the newest becomes the next breakpoint. A
+// breakpoint is therefore stamped at most one step late, or at the start of
+// the block if it fell in the one before. A steady fader costs a breakpoint
+// only every maxWindow steps. A block that runs out of room for breakpoints
+// ends its line on the last one, and a new line starts with the next block.
+//
+// Everything is fixed-size, so process() never allocates.
+class RideThinner
+{
+public:
+    static constexpr int stepSamples = 32;
+    static constexpr int maxWindow = 512;          // points; a window this long ends in a breakpoint regardless
+    static constexpr int maxPointsPerBlock = 256;  // the last one ends the line until the next block
+    static constexpr float floorDb = -60.0f;
+
+    struct Point
+    {
+        int time;        // samples from the start of the current block
+        float gainDb;
+        bool endsLine;   // the last breakpoint before a flush()
+    };
+
+    float toleranceDb { 0.25f };
+
+    // Forgets the line: the next point is a breakpoint
+    void reset() noexcept
+    {
+        windowSize = 0;
+        hasAnchor = false;
+        untilNextStep = 0;
+    }
+
+    // Starts a block: its breakpoints so far are dropped and block time restarts at 0
+    void beginBlock() noexcept
+    {
+        blockStart = clock;
+        numPoints = 0;
+        blockFull = false;
+    }
+
+    // Feeds the next numSamples of the fader, linear gain per channel, averaged across channels
+    void process (const float* const* gains, int numChannels, int numSamples) noexcept
+    {
+        if (numChannels <= 0)
+        {
+            clock += numSamples;
+            return;
+        }
+
+        for (int i = untilNextStep; i < numSamples; i += stepSamples)
+        {
+            float gain = 0.0f;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                gain += gains[ch][i];
+
+            add ({ clock + i, toDecibels (gain / (float) numChannels) });
+        }
+
+        const auto numSteps = (numSamples > untilNextStep) ? (numSamples - untilNextStep + stepSamples - 1) / stepSamples : 0;
+        untilNextStep += numSteps * stepSamples - numSamples;
+        clock += numSamples;
+    }
+
+    // The line ends here (a stop, a jump, writing switched off): its last point becomes a breakpoint
+    void flush() noexcept
+    {
+        if (windowSize > 0)
+            emit (window[(size_t) windowSize - 1], true);
+        else if (hasAnchor)
+            emit ({ clock, anchor.gainDb }, true);
+
+        reset();
+    }
+
+    int getNumPoints() const noexcept { return numPoints; }
+    const Point& getPoint (int index) const noexcept { return points[(size_t) index]; }
+
+private:
+    struct Sample
+    {
+        std::int64_t time; // samples since the thinner was created
+        float gainDb;
+    };
+
+    static float toDecibels (float gain) noexcept
+    {
+        return gain > 0.0f ? juce::jmax (floorDb, 20.0f * std::log10 (gain)) : floorDb;
+    }
+
+    void add (const Sample& sample) noexcept
+    {
+        if (blockFull)
+            return;
+
+        if (! hasAnchor)
+        {
+            anchor = sample;
+            hasAnchor = true;
+            emit (sample, false);
+            return;
+        }
+
+        if (windowSize == maxWindow || ! lineFits (sample))
+        {
+            anchor = window[(size_t) windowSize - 1];
+            windowSize = 0;
+            emit (anchor, false);
+
+            if (blockFull)
+                return;
+        }
+
+        window[(size_t) windowSize++] = sample;
+    }
+
+    // Whether a straight line from the anchor to `to` passes within the tolerance of every point in between
+    bool lineFits (const Sample& to) const noexcept
+    {
+        const auto span = (float) (to.time - anchor.time);
+        const auto slope = (to.gainDb - anchor.gainDb) / span;
+
+        for (int i = 0; i < windowSize; ++i)
+        {
+            const auto& point = window[(size_t) i];
+            const auto onLine = anchor.gainDb + slope * (float) (point.time - anchor.time);
+
+            if (std::abs (point.gainDb - onLine) > toleranceDb)
+                return false;
+        }
+
+        return true;
+    }
+
+    void emit (const Sample& sample, bool endsLine) noexcept
+    {
+        // The last slot in the block ends the line, and the rest of the block is left out
+        if (numPoints == maxPointsPerBlock - 1 && ! endsLine)
+        {
+            endsLine = true;
+            blockFull = true;
+            windowSize = 0;
+            hasAnchor = false;
+        }
+
+        points[(size_t) numPoints++] = { (int) juce::jmax ((std::int64_t) 0, sample.time - blockStart), sample.gainDb, endsLine };
+    }
+
+    std::array<Sample, maxWindow> window {};
+    int windowSize { 0 };
+    Sample anchor { 0, 0.0f };
+    bool hasAnchor { false };
+
+    std::int64_t clock { 0 };
+    std::int64_t blockStart { 0 };
+    int untilNextStep { 0 }; // samples into the next process() call before the next point
+    bool blockFull { false };
+
+    std::array<Point, maxPointsPerBlock> points {};
+    int numPoints { 0 };
+};
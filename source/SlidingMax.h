@@ -0,0 +1,76 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <cstdint>
+
+// ==========================================================
+// THE SLIDING MAX
+// ==========================================================
+// Streaming maximum over the last windowSize samples, as a monotonic deque:
+// every sample is pushed once and popped at most once, so a sample costs
+// O(1) amortised whatever the window length. Used by the lookahead path to
+// track the loudest live level over the lookahead window.
+//
+// The deque lives in a ring allocated by prepare(), so process() never
+// allocates.
+class SlidingMax
+{
+public:
+    void prepare (int maxWindowSize)
+    {
+        capacity = (int) juce::nextPowerOfTwo (juce::jmax (1, maxWindowSize));
+        values.allocate ((size_t) capacity, true);
+        positions.allocate ((size_t) capacity, true);
+        windowSize = juce::jmin (windowSize, capacity);
+        reset();
+    }
+
+    // Clamped to the size given to prepare()
+    void setWindowSize (int newWindowSize) noexcept { windowSize = juce::jlimit (1, juce::jmax (1, capacity), newWindowSize); }
+    int getWindowSize() const noexcept { return windowSize; }
+
+    void reset() noexcept
+    {
+        head = tail = 0;
+        position = 0;
+    }
+
+    // Pushes one sample and returns the max of the last windowSize samples, this one included
+    float process (float value) noexcept
+    {
+        jassert (capacity > 0);
+        const auto mask = capacity - 1;
+
+        // Drop what's left the window first, so with the new sample the deque holds at most
+        // windowSize entries, which the ring always has room for
+        while (tail != head && positions[head & mask] <= position - windowSize)
+            ++head;
+
+        // Anything not louder than the new sample can never be the max again
+        while (tail != head && values[(tail - 1) & mask] <= value)
+            --tail;
+
+        values[tail & mask] = value;
+        positions[tail & mask] = position;
+        ++tail;
+
+        ++position;
+        return values[head & mask];
+    }
+
+    void process (const float* in, float* out, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+            out[i] = process (in[i]);
+    }
+
+private:
+    juce::HeapBlock<float> values;
+    juce::HeapBlock<std::int64_t> positions;
+    int capacity { 0 };
+    int windowSize { 1 };
+
+    // Monotonic counters; the deque holds [head, tail), oldest (and loudest) first
+    std::int64_t head { 0 }, tail { 0 };
+    std::int64_t position { 0 };
+};
@@ -0,0 +1,209 @@
+#include "StereoDetector.h"
+#include <algorithm>
+#include <cmath>
+
+#if JUCE_USE_SIMD
+namespace
+{
+    using Register = juce::dsp::SIMDRegister<float>;
+
+    // SIMDRegister has no square root, so this goes to the native instruction where there is one
+    inline Register simdSqrt (Register x) noexcept
+    {
+       #if JUCE_INTEL && defined (__AVX2__)
+        return Register::fromNative (_mm256_sqrt_ps (x.value));
+       #elif JUCE_INTEL
+        return Register::fromNative (_mm_sqrt_ps (x.value));
+       #elif JUCE_ARM && JUCE_64BIT
+        return Register::fromNative (vsqrtq_f32 (x.value));
+       #else
+        for (size_t lane = 0; lane < Register::size(); ++lane)
+            x.set (lane, std::sqrt (x.get (lane)));
+
+        return x;
+       #endif
+    }
+}
+#endif
+
+//==============================================================================
+void StereoDetector::prepare (int newMaxBlockSize)
+{
+    maxBlockSize = juce::jmax (1, newMaxBlockSize);
+
+    // Three interleaved frame arrays plus room to align the first one
+    const auto framesSize = (size_t) maxBlockSize * (size_t) frameStride;
+    frameStorage.allocate (3 * framesSize + (size_t) frameStride, true);
+
+   #if JUCE_USE_SIMD
+    inputFrames = Register::getNextSIMDAlignedPtr (frameStorage.get());
+   #else
+    inputFrames = frameStorage.get();
+   #endif
+
+    rmsFrames = inputFrames + framesSize;
+    peakFrames = rmsFrames + framesSize;
+}
+
+void StereoDetector::reset() noexcept
+{
+    std::fill (std::begin (envState), std::end (envState), 0.0f);
+    std::fill (std::begin (peakState), std::end (peakState), 0.0f);
+}
+
+void StereoDetector::setCoefficients (float newEnvCoeff, float newPeakReleaseCoeff) noexcept
+{
+    envCoeff = newEnvCoeff;
+    peakReleaseCoeff = newPeakReleaseCoeff;
+}
+
+EngineStages::DetectorState StereoDetector::getState (int channel) const noexcept
+{
+    return { envState[channel], envState[numChannels + channel],
+             peakState[channel], peakState[numChannels + channel] };
+}
+
+void StereoDetector::setState (int channel, const EngineStages::DetectorState& newState) noexcept
+{
+    envState[channel] = newState.envLive;
+    envState[numChannels + channel] = newState.envGuide;
+    peakState[channel] = newState.peakLive;
+    peakState[numChannels + channel] = newState.peakGuide;
+}
+
+//==============================================================================
+void StereoDetector::process (const float* const* live, const float* const* guide, int numActiveChannels,
+                              int numSamples, const EngineStages::DetectorOutput* outputs) noexcept
+{
+    jassert (numSamples <= maxBlockSize);
+    numSamples = std::min (numSamples, maxBlockSize);
+    numActiveChannels = juce::jlimit (0, numChannels, numActiveChannels);
+
+   #if ! JUCE_USE_SIMD
+    processScalar (live, guide, numActiveChannels, numSamples, outputs);
+   #else
+    if (inputFrames == nullptr || numSamples <= 0)
+        return;
+
+    // 1. Interleave the four inputs into lane order (twice over when the register is shared)
+    for (int follower = 0; follower < numFollowers; ++follower)
+    {
+        const auto channel = follower % numChannels;
+        const auto* source = (channel >= numActiveChannels) ? nullptr
+                           : (follower < numChannels ? live[channel] : guide[channel]);
+
+        for (int copy = follower; copy < (sharedRegister ? 2 * numFollowers : numFollowers); copy += numFollowers)
+        {
+            auto* dest = inputFrames + copy;
+
+            if (source != nullptr)
+                for (int i = 0; i < numSamples; ++i)
+                    dest[i * frameStride] = source[i];
+            else
+                for (int i = 0; i < numSamples; ++i)
+                    dest[i * frameStride] = 0.0f;
+        }
+    }
+
+    // 2. One recursion step per sample for all followers
+    if constexpr (sharedRegister)
+    {
+        alignas (32) float a[numLanes] {}, b[numLanes] {}, m[numLanes] {}, v[numLanes] {};
+        alignas (32) uint32_t envMask[numLanes] {}, peakMask[numLanes] {};
+
+        for (int lane = 0; lane < numFollowers; ++lane)
+        {
+            a[lane] = envCoeff;                             a[numFollowers + lane] = 0.0f;
+            b[lane] = 1.0f - envCoeff;                      b[numFollowers + lane] = 1.0f;
+            m[lane] = 0.0f;                                 m[numFollowers + lane] = peakReleaseCoeff;
+            v[lane] = envState[lane];                       v[numFollowers + lane] = peakState[lane];
+            envMask[lane] = 0xffffffffu;                    peakMask[numFollowers + lane] = 0xffffffffu;
+        }
+
+        const auto va = Register::fromRawArray (a);
+        const auto vb = Register::fromRawArray (b);
+        const auto vm = Register::fromRawArray (m);
+        const auto envLanes = Register::vMaskType::fromRawArray (envMask);
+        const auto peakLanes = Register::vMaskType::fromRawArray (peakMask);
+        auto state = Register::fromRawArray (v);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto x = Register::fromRawArray (inputFrames + i * frameStride);
+            const auto in = ((x * x) & envLanes) + (Register::abs (x) & peakLanes);
+
+            state = Register::max ((va * state) + (vb * in), vm * state);
+
+            state.copyToRawArray (peakFrames + i * frameStride);
+            simdSqrt (state).copyToRawArray (rmsFrames + i * frameStride);
+        }
+
+        state.copyToRawArray (v);
+
+        for (int lane = 0; lane < numFollowers; ++lane)
+        {
+            envState[lane] = v[lane];
+            peakState[lane] = v[numFollowers + lane];
+        }
+    }
+    else if constexpr (numLanes >= numFollowers)
+    {
+        const auto coeff = Register::expand (envCoeff);
+        const auto oneMinusCoeff = Register::expand (1.0f - envCoeff);
+        const auto release = Register::expand (peakReleaseCoeff);
+
+        alignas (32) float env[numLanes] {}, peak[numLanes] {};
+        std::copy (std::begin (envState), std::end (envState), env);
+        std::copy (std::begin (peakState), std::end (peakState), peak);
+
+        auto envReg = Register::fromRawArray (env);
+        auto peakReg = Register::fromRawArray (peak);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto x = Register::fromRawArray (inputFrames + i * frameStride);
+
+            envReg = (coeff * envReg) + (oneMinusCoeff * (x * x));
+            peakReg = Register::max (Register::abs (x), peakReg * release);
+
+            peakReg.copyToRawArray (peakFrames + i * frameStride);
+            simdSqrt (envReg).copyToRawArray (rmsFrames + i * frameStride);
+        }
+
+        envReg.copyToRawArray (env);
+        peakReg.copyToRawArray (peak);
+        std::copy (env, env + numFollowers, envState);
+        std::copy (peak, peak + numFollowers, peakState);
+    }
+    else
+    {
+        processScalar (live, guide, numActiveChannels, numSamples, outputs);
+        return;
+    }
+
+    // 3. De-interleave into the per-channel stage arrays
+    for (int ch = 0; ch < numActiveChannels; ++ch)
+    {
+        const auto& out = outputs[ch];
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            out.liveRMS[i]   = rmsFrames[i * frameStride + ch];
+            out.guideRMS[i]  = rmsFrames[i * frameStride + numChannels + ch];
+            out.peakLive[i]  = peakFrames[i * frameStride + peakLaneOffset + ch];
+            out.peakGuide[i] = peakFrames[i * frameStride + peakLaneOffset + numChannels + ch];
+        }
+    }
+   #endif
+}
+
+void StereoDetector::processScalar (const float* const* live, const float* const* guide, int numActiveChannels,
+                                    int numSamples, const EngineStages::DetectorOutput* outputs) noexcept
+{
+    for (int ch = 0; ch < numActiveChannels; ++ch)
+    {
+        auto state = getState (ch);
+        EngineStages::detect (live[ch], guide[ch], numSamples, envCoeff, peakReleaseCoeff, state, outputs[ch]);
+        setState (ch, state);
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include "EngineStages.h"
+
+// ==========================================================
+// THE STEREO DETECTOR
+// ==========================================================
+// Runs all four RMS followers (live L/R, guide L/R) and their peak followers
+// as one recursion step per sample, with the followers packed side by side in
+// a juce::dsp::SIMDRegister. The lane order is { live L, live R, guide L, guide R }.
+//
+// With 4-lane registers (SSE, NEON) the RMS and peak followers each get a
+// register. With 8-lane registers (AVX2) both fit in one, the peak followers
+// taking the upper half, and every lane runs the same update
+//
+//     v = max (a * v + b * in, m * v)
+//
+// which is the one-pole RMS smoother for { a = coeff, b = 1 - coeff, m = 0, in = x^2 }
+// and the peak decay for { a = 0, b = 1, m = release, in = |x| }. Both reduce to the
+// exact same float operations as the scalar followers, so the output doesn't
+// depend on which path was compiled in.
+class StereoDetector
+{
+public:
+    static constexpr int numChannels = 2;
+
+    StereoDetector() = default;
+
+    // Allocates the interleaved frame storage. Not real-time safe.
+    void prepare (int maxBlockSize);
+    void reset() noexcept;
+
+    void setCoefficients (float newEnvCoeff, float newPeakReleaseCoeff) noexcept;
+
+    EngineStages::DetectorState getState (int channel) const noexcept;
+    void setState (int channel, const EngineStages::DetectorState& newState) noexcept;
+
+    // live[ch] / guide[ch] may be nullptr for silence; channels >= numActiveChannels are ignored.
+    // numSamples must not exceed the size given to prepare().
+    void process (const float* const* live, const float* const* guide, int numActiveChannels,
+                  int numSamples, const EngineStages::DetectorOutput* outputs) noexcept;
+
+private:
+   #if JUCE_USE_SIMD
+    using Register = juce::dsp::SIMDRegister<float>;
+    static constexpr int numLanes = (int) Register::size();
+   #else
+    static constexpr int numLanes = 1;
+   #endif
+
+    static constexpr int numFollowers = 2 * numChannels;
+
+    // One register holds both follower kinds when it's wide enough
+    static constexpr bool sharedRegister = numLanes >= 2 * numFollowers;
+    static constexpr int frameStride = sharedRegister ? numLanes : juce::jmax (numLanes, numFollowers);
+    static constexpr int peakLaneOffset = sharedRegister ? numFollowers : 0;
+
+    void processScalar (const float* const* live, const float* const* guide, int numActiveChannels,
+                        int numSamples, const EngineStages::DetectorOutput* outputs) noexcept;
+
+    float envCoeff { 0.0f };
+    float peakReleaseCoeff { 0.0f };
+
+    // Lane-ordered follower state
+    alignas (32) float envState[numFollowers] {};
+    alignas (32) float peakState[numFollowers] {};
+
+    int maxBlockSize { 0 };
+    juce::HeapBlock<float> frameStorage;
+    float* inputFrames { nullptr };
+    float* rmsFrames { nullptr };
+    float* peakFrames { nullptr };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StereoDetector)
+};
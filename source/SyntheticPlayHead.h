@@ -0,0 +1,51 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+// ==========================================================
+// THE SYNTHETIC PLAYHEAD
+// ==========================================================
+// A stand-in host transport for driving the processor outside a DAW: tests,
+// benchmarks and offline renders. Set it up, hand it to setPlayHead(), and
+// call advance() after every processBlock.
+class SyntheticPlayHead : public juce::AudioPlayHead
+{
+public:
+    double sampleRate { 48000.0 };
+    double bpm { 120.0 };
+    double ppqPosition { 0.0 };
+    juce::int64 timeInSamples { 0 };
+    bool playing { true };
+    double bpmPerSecond { 0.0 }; // a tempo ramp, applied by advance()
+
+    juce::Optional<PositionInfo> getPosition() const override
+    {
+        PositionInfo info;
+        info.setBpm (bpm);
+        info.setPpqPosition (ppqPosition);
+        info.setTimeInSamples (timeInSamples);
+        info.setTimeInSeconds ((double) timeInSamples / sampleRate);
+        info.setTimeSignature (TimeSignature {});
+        info.setIsPlaying (playing);
+        return info;
+    }
+
+    void advance (int numSamples) noexcept
+    {
+        if (! playing)
+            return;
+
+        // Over a ramp the tempo changes linearly, so the block advances at its average tempo
+        const auto bpmChange = bpmPerSecond * (double) numSamples / sampleRate;
+
+        ppqPosition += (double) numSamples * ((bpm + 0.5 * bpmChange) / 60.0) / sampleRate;
+        bpm += bpmChange;
+        timeInSamples += numSamples;
+    }
+
+    void jumpTo (double newPpqPosition) noexcept
+    {
+        ppqPosition = newPpqPosition;
+        timeInSamples = (juce::int64) (newPpqPosition * (60.0 / bpm) * sampleRate);
+    }
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+// ==========================================================
+// THE TRANSPORT TRACKER
+// ==========================================================
+// Per-instance transport state machine. Fed the host position once per block,
+// it works out what happened since the previous block:
+//
+//   started / stopped  - the play state flipped
+//   looped             - the position wrapped back to the host's loop start
+//   jumped             - any other discontinuity (locate, scrub, backwards or forwards)
+//   tempoChanged       - the BPM differs from the previous block (also set on the first block)
+//
+// While playing, the position is expected to advance by exactly one block's
+// worth of quarters; anything further off than a few samples is a jump. When
+// the tempo changes, the advance shows whether it stepped at the block
+// boundary or ramped across the block. A ramp is reported so the next block
+// can carry on interpolating it sample by sample. A host that doesn't report
+// a position can't be checked for either, so it never jumps or ramps.
+class TransportTracker
+{
+public:
+    struct Position
+    {
+        double bpm { 120.0 };
+        double ppq { 0.0 };
+        bool hasPPQ { false }; // whether the host reported ppq at all
+        bool isPlaying { false };
+        bool isLooping { false };
+        double loopStartPPQ { -1.0 }; // < 0 when the host doesn't report loop points
+    };
+
+    struct Events
+    {
+        bool started { false };
+        bool stopped { false };
+        bool looped { false };
+        bool jumped { false };
+        bool tempoChanged { false };
+        double bpmPerSample { 0.0 }; // how fast the tempo is ramping; 0 when it holds or steps
+
+        // The envelopes and Ghost write position no longer match the audio
+        bool discontinuity() const noexcept { return started || looped || jumped; }
+    };
+
+    void reset() noexcept
+    {
+        hasPrevious = false;
+    }
+
+    Events update (const Position& now, int numSamples, double sampleRate) noexcept
+    {
+        Events events;
+
+        if (! hasPrevious)
+        {
+            events.started = now.isPlaying;
+            events.tempoChanged = true;
+        }
+        else
+        {
+            events.started = now.isPlaying && ! previous.isPlaying;
+            events.stopped = ! now.isPlaying && previous.isPlaying;
+            events.tempoChanged = now.bpm != previous.bpm;
+
+            if (now.isPlaying && previous.isPlaying && now.hasPPQ && previous.hasPPQ)
+            {
+                // The tempo either changed on the block boundary, or ramped linearly across the block
+                const auto ppqPerSample = (previous.bpm / 60.0) / sampleRate;
+                const auto rampedPPQPerSample = ((previous.bpm + now.bpm) * 0.5 / 60.0) / sampleRate;
+                const auto steppedError = std::abs (now.ppq - (previous.ppq + (double) previousNumSamples * ppqPerSample));
+                const auto rampedError = std::abs (now.ppq - (previous.ppq + (double) previousNumSamples * rampedPPQPerSample));
+                const auto tolerance = jumpToleranceSamples * ppqPerSample;
+
+                // Any step backwards counts, however small: a ride never runs in reverse
+                if (now.ppq < previous.ppq || std::min (steppedError, rampedError) > tolerance)
+                {
+                    const bool atLoopStart = now.isLooping && now.loopStartPPQ >= 0.0
+                                          && std::abs (now.ppq - now.loopStartPPQ) <= tolerance;
+
+                    (atLoopStart ? events.looped : events.jumped) = true;
+                }
+                else if (events.tempoChanged && rampedError < steppedError && previousNumSamples > 0)
+                {
+                    events.bpmPerSample = (now.bpm - previous.bpm) / (double) previousNumSamples;
+                }
+            }
+        }
+
+        previous = now;
+        previousNumSamples = numSamples;
+        hasPrevious = true;
+
+        return events;
+    }
+
+    bool isPlaying() const noexcept { return hasPrevious && previous.isPlaying; }
+
+private:
+    static constexpr double jumpToleranceSamples = 16.0;
+
+    Position previous;
+    int previousNumSamples { 0 };
+    bool hasPrevious { false };
+};
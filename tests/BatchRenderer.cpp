@@ -0,0 +1,161 @@
+#include "helpers/render_helpers.h"
+#include <BatchRenderer.h>
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+    // A batch with one file much longer than the rest, in mono and stereo
+    struct Batch
+    {
+        std::vector<OfflineRenderer::Job> jobs;
+
+        Batch()
+        {
+            const double seconds[] { 0.6, 6.0, 0.4, 1.1, 0.8, 0.5, 1.4 };
+
+            for (size_t i = 0; i < std::size (seconds); ++i)
+            {
+                OfflineRenderer::Job job;
+                job.input = writeWav (makeSignal (i % 3 == 0 ? 1 : 2, seconds[i], 150.0 + 40.0 * (double) i), 24, false);
+                job.output = tempFile ("batch-render-out");
+                job.settings.mode = 1 + (int) i % 3;
+                job.settings.blockSize = 2048;
+                jobs.push_back (job);
+            }
+        }
+
+        ~Batch()
+        {
+            for (auto& job : jobs)
+            {
+                job.input.deleteFile();
+                job.output.deleteFile();
+            }
+        }
+    };
+}
+
+TEST_CASE ("A batch render matches rendering each file alone", "[render][batch]")
+{
+    Batch batch;
+
+    // A job that can't render doesn't hold up the rest
+    auto missing = batch.jobs[2];
+    missing.input = missing.input.getSiblingFile ("missing.wav");
+    missing.output = tempFile ("batch-render-out");
+    batch.jobs.insert (batch.jobs.begin() + 3, missing);
+
+    BatchRenderer renderer (3);
+    REQUIRE (renderer.getNumWorkers() == 3);
+
+    std::atomic<float> progress { 0.0f };
+    const auto results = renderer.render (batch.jobs, &progress);
+
+    REQUIRE (results.size() == batch.jobs.size());
+    CHECK (progress.load() == 1.0f);
+    CHECK (results[3].failed());
+    CHECK_FALSE (missing.output.exists());
+
+    OfflineRenderer alone;
+
+    for (size_t i = 0; i < batch.jobs.size(); ++i)
+    {
+        if (i == 3)
+            continue;
+
+        INFO ("job " << i);
+        REQUIRE (results[i].wasOk());
+
+        auto job = batch.jobs[i];
+        job.output = tempFile ("batch-render-alone");
+        REQUIRE (alone.render (job).wasOk());
+
+        const auto expected = readWav (job.output);
+        const auto rendered = readWav (batch.jobs[i].output);
+
+        REQUIRE (rendered.getNumChannels() == expected.getNumChannels());
+        REQUIRE (rendered.getNumSamples() == expected.getNumSamples());
+        CHECK (maxDifference (expected, 0, rendered, expected.getNumSamples()) == 0.0f);
+
+        job.output.deleteFile();
+    }
+
+    SECTION ("and again with the same workers")
+    {
+        std::vector<juce::AudioBuffer<float>> first;
+
+        for (size_t i = 0; i < batch.jobs.size(); ++i)
+            if (i != 3)
+                first.push_back (readWav (batch.jobs[i].output));
+
+        const auto again = renderer.render (batch.jobs);
+
+        for (size_t i = 0, f = 0; i < batch.jobs.size(); ++i)
+        {
+            if (i == 3)
+                continue;
+
+            REQUIRE (again[i].wasOk());
+            CHECK (maxDifference (first[f], 0, readWav (batch.jobs[i].output), first[f].getNumSamples()) == 0.0f);
+            ++f;
+        }
+    }
+}
+
+TEST_CASE ("A cancelled batch finishes what it started", "[render][batch]")
+{
+    Batch batch;
+
+    // Enough work on one worker that it's still going when the cancel lands
+    for (int repeat = 0; repeat < 2; ++repeat)
+        for (size_t i = 0; i < 7; ++i)
+        {
+            auto job = batch.jobs[i];
+            job.output = tempFile ("batch-render-out");
+            batch.jobs.push_back (job);
+        }
+
+    BatchRenderer renderer (1);
+    const auto results = renderer.render (batch.jobs, nullptr, [] { return true; });
+
+    int numCancelled = 0;
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        if (results[i].failed())
+        {
+            CHECK (results[i].getErrorMessage() == "Cancelled");
+            CHECK_FALSE (batch.jobs[i].output.exists());
+            ++numCancelled;
+        }
+    }
+
+    CHECK (numCancelled > 0);
+
+    // The cancelled jobs are gone: the next batch runs only its own
+    const std::vector<OfflineRenderer::Job> one { batch.jobs[0] };
+    const auto next = renderer.render (one);
+    REQUIRE (next.size() == 1);
+    CHECK (next[0].wasOk());
+}
+
+TEST_CASE ("Batch jobs that share an output aren't rendered", "[render][batch]")
+{
+    Batch batch;
+
+    // Two inputs ridden to one file, as take.flac and take.wav would be
+    batch.jobs[4].output = batch.jobs[1].output;
+
+    BatchRenderer renderer (2);
+    const auto results = renderer.render (batch.jobs);
+
+    REQUIRE (results.size() == batch.jobs.size());
+    CHECK (results[1].failed());
+    CHECK (results[4].failed());
+    CHECK (results[1].getErrorMessage().contains (batch.jobs[1].output.getFullPathName()));
+    CHECK_FALSE (batch.jobs[1].output.exists());
+
+    for (size_t i = 0; i < batch.jobs.size(); ++i)
+        if (i != 1 && i != 4)
+            CHECK (results[i].wasOk());
+}
@@ -0,0 +1,223 @@
+#include "helpers/clap_helpers.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    // A tempo at which a sample is exactly 2^-15 quarters, so positions survive CLAP's fixed point untouched
+    constexpr double exactBpm = 87.890625;
+
+    struct Rig
+    {
+        PluginProcessor plugin;
+        SyntheticPlayHead playHead;
+        juce::AudioBuffer<float> main { 2, blockSize };
+        juce::AudioBuffer<float> sidechain { 2, blockSize };
+
+        Rig()
+        {
+            playHead.sampleRate = sampleRate;
+            playHead.bpm = exactBpm;
+            plugin.setPlayHead (&playHead);
+            plugin.setNonRealtime (true);
+            plugin.prepareToPlay (sampleRate, blockSize);
+        }
+
+        ~Rig() { plugin.setPlayHead (nullptr); }
+
+        void fill (int block)
+        {
+            for (int i = 0; i < blockSize; ++i)
+            {
+                const auto t = (float) (block * blockSize + i);
+                const auto burst = ((block * blockSize + i) / 700) % 3 == 0 ? 0.9f : 0.1f;
+
+                main.setSample (0, i, burst * std::sin (t * 0.031f));
+                main.setSample (1, i, burst * std::sin (t * 0.017f));
+                sidechain.setSample (0, i, 0.4f * std::sin (t * 0.023f));
+                sidechain.setSample (1, i, 0.2f * std::sin (t * 0.011f));
+            }
+        }
+
+        // The reference: samples [start, end) of the block through processBlock, as a host without CLAP would
+        void processPiece (int start, int end)
+        {
+            juce::AudioBuffer<float> buffer (plugin.getTotalNumInputChannels(), end - start);
+
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                buffer.copyFrom (ch, 0, main, ch, start, end - start);
+                buffer.copyFrom (ch + 2, 0, sidechain, ch, start, end - start);
+            }
+
+            juce::MidiBuffer midi;
+            plugin.processBlock (buffer, midi);
+
+            for (int ch = 0; ch < 2; ++ch)
+                main.copyFrom (ch, start, buffer, ch, 0, end - start);
+
+            playHead.advance (end - start);
+        }
+    };
+
+    bool sameAudio (const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+    {
+        for (int ch = 0; ch < a.getNumChannels(); ++ch)
+            for (int i = 0; i < a.getNumSamples(); ++i)
+                if (a.getSample (ch, i) != b.getSample (ch, i))
+                    return false;
+
+        return true;
+    }
+
+    bool sameGhost (const GhostMap& a, const GhostMap& b, int numIndices)
+    {
+        for (int ch = 0; ch < GhostMap::numChannels; ++ch)
+            for (int index = 0; index < numIndices; ++index)
+                if (a.readCode (ch, index) != b.readCode (ch, index))
+                    return false;
+
+        return true;
+    }
+}
+
+TEST_CASE ("CLAP direct process without events matches processBlock", "[clap]")
+{
+    for (int mode = 0; mode < 4; ++mode)
+    {
+        Rig reference, direct;
+
+        for (auto* rig : { &reference, &direct })
+        {
+            rig->plugin.parameters.mode = mode;
+            rig->plugin.parameters.chop = mode == 2;
+            rig->plugin.parameters.externalSidechain = mode == 3;
+        }
+
+        ClapProcessCall call (direct.main, direct.sidechain);
+
+        for (int block = 0; block < 20; ++block)
+        {
+            reference.fill (block);
+            direct.fill (block);
+
+            reference.processPiece (0, blockSize);
+
+            REQUIRE (call.run (direct.plugin, direct.playHead) == CLAP_PROCESS_CONTINUE);
+            direct.playHead.advance (blockSize);
+
+            INFO ("mode " << mode << ", block " << block);
+            REQUIRE (sameAudio (reference.main, direct.main));
+        }
+    }
+}
+
+TEST_CASE ("CLAP parameter events land on their exact sample", "[clap][parameters]")
+{
+    Rig reference, direct;
+    ClapProcessCall call (direct.main, direct.sidechain);
+    auto& parameters = direct.plugin.parameters;
+
+    for (int block = 0; block < 12; ++block)
+    {
+        reference.fill (block);
+        direct.fill (block);
+        call.events.clear();
+
+        if (block == 4)
+        {
+            // Mode on at 37, CHOP on at 200, its threshold moved at 201 and 450
+            reference.processPiece (0, 37);
+            reference.plugin.parameters.mode = 2;
+            reference.processPiece (37, 200);
+            reference.plugin.parameters.chop = true;
+            reference.processPiece (200, 201);
+            reference.plugin.parameters.chopThreshold = 0.5f;
+            reference.processPiece (201, 450);
+            reference.plugin.parameters.chopThreshold = 0.2f;
+            reference.processPiece (450, blockSize);
+
+            // The host sends every value normalised
+            call.events.addParameter (parameters.mode, parameters.mode.convertTo0to1 (2.0f), 37);
+            call.events.addParameter (parameters.chop, 1.0f, 200);
+            call.events.addParameter (parameters.chopThreshold, parameters.chopThreshold.convertTo0to1 (0.5f), 201);
+            call.events.addParameter (parameters.chopThreshold, parameters.chopThreshold.convertTo0to1 (0.2f), 450);
+        }
+        else
+        {
+            reference.processPiece (0, blockSize);
+        }
+
+        REQUIRE (call.run (direct.plugin, direct.playHead) == CLAP_PROCESS_CONTINUE);
+        direct.playHead.advance (blockSize);
+
+        INFO ("block " << block);
+        REQUIRE (sameAudio (reference.main, direct.main));
+    }
+
+    CHECK (parameters.snapshot().mode == 2);
+    CHECK (parameters.snapshot().chop);
+    CHECK (parameters.chopThreshold.get() == reference.plugin.parameters.chopThreshold.get());
+}
+
+TEST_CASE ("A CLAP transport start punches a Ghost recording in on its sample", "[clap][ghost]")
+{
+    Rig reference, direct;
+    ClapProcessCall call (direct.main, direct.sidechain);
+
+    for (auto* rig : { &reference, &direct })
+    {
+        rig->plugin.parameters.mode = 1;
+        rig->plugin.isGhostRecording.store (true);
+        rig->playHead.playing = false;
+    }
+
+    const auto punchIn = 8.0;
+    constexpr int startSample = 300;
+
+    for (int block = 0; block < 10; ++block)
+    {
+        reference.fill (block);
+        direct.fill (block);
+        call.events.clear();
+
+        if (block == 2)
+        {
+            reference.processPiece (0, startSample);
+            reference.playHead.playing = true;
+            reference.playHead.jumpTo (punchIn);
+            reference.processPiece (startSample, blockSize);
+
+            // The host reports the start at its sample; the block itself began stopped
+            SyntheticPlayHead started;
+            started.bpm = exactBpm;
+            started.jumpTo (punchIn);
+            call.events.addTransport (started, startSample);
+
+            REQUIRE (call.run (direct.plugin, direct.playHead) == CLAP_PROCESS_CONTINUE);
+            direct.playHead.playing = true;
+            direct.playHead.jumpTo (punchIn);
+            direct.playHead.advance (blockSize - startSample);
+        }
+        else
+        {
+            reference.processPiece (0, blockSize);
+
+            REQUIRE (call.run (direct.plugin, direct.playHead) == CLAP_PROCESS_CONTINUE);
+            direct.playHead.advance (blockSize);
+        }
+
+        INFO ("block " << block);
+        REQUIRE (sameAudio (reference.main, direct.main));
+    }
+
+    const auto& recorded = *direct.plugin.ghostLibrary.getSlot (0);
+    const auto firstIndex = (int) (punchIn * recorded.getResolution());
+
+    CHECK (recorded.readCode (0, firstIndex - 1) == GhostCodec::noDataCode);
+    CHECK (recorded.readCode (0, firstIndex) != GhostCodec::noDataCode);
+    CHECK (sameGhost (recorded, *reference.plugin.ghostLibrary.getSlot (0), firstIndex + 10 * GhostMap::pageSize));
+}
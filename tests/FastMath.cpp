@@ -0,0 +1,164 @@
+#include <EngineStages.h>
+#include <FastMath.h>
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    // How far apart two positive levels are, in dB
+    double dbError (double value, double reference)
+    {
+        return std::abs (20.0 * std::log10 (value / reference));
+    }
+
+    constexpr double maxDbError = 0.01;
+}
+
+TEST_CASE ("Fast math error bounds", "[fastmath]")
+{
+    SECTION ("log2")
+    {
+        double worst = 0.0;
+
+        for (double decade = -30.0; decade <= 30.0; decade += 1.0e-3)
+        {
+            const auto x = (float) std::pow (10.0, decade);
+            const auto reference = std::log2 ((double) x);
+            worst = std::max (worst, std::abs (FastMath::log2 (x) - reference) / (2.0e-7 + 6.0e-8 * std::abs (reference)));
+        }
+
+        CHECK (worst < 1.0);
+    }
+
+    SECTION ("exp2 and exp")
+    {
+        double worstExp2 = 0.0, worstExp = 0.0;
+
+        for (double x = -126.0; x <= 126.0; x += 1.0e-3)
+            worstExp2 = std::max (worstExp2, std::abs (FastMath::exp2 ((float) x) / std::exp2 ((double) (float) x) - 1.0));
+
+        for (double x = -87.0; x <= 87.0; x += 1.0e-3)
+        {
+            const auto xf = (float) x;
+            worstExp = std::max (worstExp, std::abs (FastMath::exp (xf) / std::exp ((double) xf) - 1.0) / (3.0e-7 + 8.0e-8 * std::abs (xf)));
+        }
+
+        CHECK (worstExp2 < 3.0e-7);
+        CHECK (worstExp < 1.0);
+    }
+
+    SECTION ("pow")
+    {
+        double worst = 0.0;
+
+        for (double decade = -6.0; decade <= 1.5; decade += 1.0e-2)
+        {
+            for (double y = -4.0; y <= 9.0; y += 0.05)
+            {
+                const auto x = (float) std::pow (10.0, decade);
+                const auto yf = (float) y;
+                const auto magnitude = std::abs ((double) yf * std::log2 ((double) x));
+
+                if (magnitude > 120.0)
+                    continue;
+
+                const auto error = std::abs (FastMath::pow (x, yf) / std::pow ((double) x, (double) yf) - 1.0);
+                worst = std::max (worst, error / std::max (1.0, magnitude));
+            }
+        }
+
+        CHECK (worst < 4.0e-7);
+    }
+
+    SECTION ("tanh")
+    {
+        double worst = 0.0;
+
+        for (double x = -20.0; x <= 20.0; x += 1.0e-4)
+            worst = std::max (worst, std::abs (FastMath::tanh ((float) x) - std::tanh ((double) (float) x)));
+
+        CHECK (worst < 3.0e-7);
+    }
+}
+
+TEST_CASE ("Gain computer stays within 0.01 dB of the reference", "[fastmath]")
+{
+    // Every (target, live) pair on a log grid from -100 to +12 dB
+    std::vector<float> target, live, peaks, present, gain;
+
+    for (double targetDb = -100.0; targetDb <= 12.0; targetDb += 0.5)
+    {
+        for (double liveDb = -100.0; liveDb <= 12.0; liveDb += 0.5)
+        {
+            target.push_back ((float) std::pow (10.0, targetDb / 20.0));
+            live.push_back ((float) std::pow (10.0, liveDb / 20.0));
+        }
+    }
+
+    const auto n = (int) target.size();
+    peaks.assign ((size_t) n, 1.0f);
+    present.assign ((size_t) n, 1.0f);
+    gain.assign ((size_t) n, 0.0f);
+
+    const EngineStages::GainComputerInput input { target.data(), live.data(), peaks.data(), peaks.data(), present.data() };
+
+    for (const int ratio : { 1, 3, 6, 9 })
+    {
+        DYNAMIC_SECTION ("mode 1, ratio " << ratio)
+        {
+            EngineStages::computeGain<1, false> (input, ratio, gain.data(), n);
+
+            double worst = 0.0;
+
+            for (int i = 0; i < n; ++i)
+            {
+                if (live[(size_t) i] < 0.00001f || target[(size_t) i] < 0.00001f)
+                    continue;
+
+                auto reference = (double) target[(size_t) i] / (double) live[(size_t) i];
+
+                if (ratio > 1)
+                    reference = std::pow (10.0, 20.0 * std::log10 (reference) * ratio / 20.0);
+
+                reference = std::clamp (reference, 0.0, 32.0);
+
+                // Below -120 dB the gain is musically zero, and relative error stops meaning anything
+                if (reference > 1.0e-6)
+                    worst = std::max (worst, dbError (gain[(size_t) i], reference));
+            }
+
+            CHECK (worst < maxDbError);
+        }
+
+        DYNAMIC_SECTION ("mode 2, ratio " << ratio)
+        {
+            EngineStages::computeGain<2, false> (input, ratio, gain.data(), n);
+
+            double worst = 0.0;
+
+            for (int i = 0; i < n; ++i)
+            {
+                const double liveRMS = live[(size_t) i];
+                double desired = target[(size_t) i];
+
+                if (liveRMS < 0.00001 || desired < 0.00001 || liveRMS >= 0.25)
+                    continue;
+
+                const double threshX = 0.25, threshY = 0.01;
+                const double exponent = (ratio == 1) ? 0.5 : 1.0 / ratio;
+
+                if (desired < threshX && desired > threshY)
+                    desired = threshX * std::pow (desired / threshX, exponent);
+                else if (desired <= threshY)
+                    desired *= 1.0 + (std::pow (threshX / threshY, exponent) - 1.0) * (desired / threshY);
+
+                const auto reference = std::clamp (desired / liveRMS, 0.0, 32.0);
+                worst = std::max (worst, dbError (gain[(size_t) i], reference));
+            }
+
+            CHECK (worst < maxDbError);
+        }
+    }
+}
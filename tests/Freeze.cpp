@@ -0,0 +1,305 @@
+#include <PluginProcessor.h>
+#include <SyntheticPlayHead.h>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    constexpr int blockSize = 512;
+    constexpr int numBlocks = 40;
+
+    // Main bus: a steady tone. Sidechain: a tone whose level steps every few blocks, so the
+    // fader has something to ride.
+    void fillBlock (juce::AudioBuffer<float>& buffer, int blockIndex, bool withSidechain)
+    {
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        {
+            const bool isSidechain = ch >= 2;
+            const auto frequency = isSidechain ? 330.0f : 220.0f;
+            const auto level = isSidechain ? (withSidechain ? 0.05f * (float) (1 + (blockIndex / 3) % 5) : 0.0f) : 0.3f;
+
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                const auto n = (float) (blockIndex * buffer.getNumSamples() + i);
+                buffer.setSample (ch, i, level * std::sin (juce::MathConstants<float>::twoPi * frequency * n / 48000.0f));
+            }
+        }
+    }
+
+    std::vector<float> runPass (PluginProcessor& plugin, SyntheticPlayHead& playHead, bool withSidechain)
+    {
+        juce::AudioBuffer<float> buffer (plugin.getTotalNumInputChannels(), blockSize);
+        juce::MidiBuffer midi;
+        std::vector<float> output;
+
+        playHead.jumpTo (4.0);
+        playHead.playing = true;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            fillBlock (buffer, block, withSidechain);
+            plugin.processBlock (buffer, midi);
+            output.insert (output.end(), buffer.getReadPointer (0), buffer.getReadPointer (0) + blockSize);
+            playHead.advance (blockSize);
+        }
+
+        return output;
+    }
+
+    // Records a Ghost from the sidechain, then rides it once to capture the fader. Returns that ride.
+    std::vector<float> recordAndRide (PluginProcessor& plugin, SyntheticPlayHead& playHead)
+    {
+        plugin.isGhostRecording.store (true);
+        runPass (plugin, playHead, true);
+        plugin.isGhostRecording.store (false);
+        plugin.isGhostReading.store (true);
+
+        return runPass (plugin, playHead, true);
+    }
+
+    // Past the last captured index there's nothing to replay, so the final block is left out
+    double worstDifference (const std::vector<float>& a, const std::vector<float>& b)
+    {
+        double worst = 0.0;
+
+        for (size_t i = 0; i < a.size() - blockSize; ++i)
+            worst = std::max (worst, (double) std::abs (a[i] - b[i]));
+
+        return worst;
+    }
+}
+
+TEST_CASE ("Freeze replays the captured fader", "[freeze]")
+{
+    PluginProcessor plugin;
+    SyntheticPlayHead playHead;
+    playHead.sampleRate = 48000.0;
+    plugin.setPlayHead (&playHead);
+    plugin.setNonRealtime (true); // pages get allocated inline
+    plugin.prepareToPlay (playHead.sampleRate, blockSize);
+
+    plugin.parameters.mode = 1;
+    plugin.parameters.externalSidechain = true;
+
+    const auto ridden = recordAndRide (plugin, playHead);
+    CHECK (plugin.frozenGainMap.getNumAllocatedPages() > 0);
+
+    SECTION ("without the sidechain, close to the live ride")
+    {
+        plugin.isFrozen.store (true);
+        const auto frozen = runPass (plugin, playHead, false);
+
+        // The fader is captured once per Ghost index and interpolated in between
+        const auto worst = worstDifference (frozen, ridden);
+        INFO ("worst " << worst);
+        CHECK (worst < 0.002);
+    }
+
+    SECTION ("survives the plugin state, switched on")
+    {
+        plugin.isFrozen.store (true);
+
+        juce::MemoryBlock state;
+        plugin.getStateInformation (state);
+
+        PluginProcessor restored;
+        restored.setPlayHead (&playHead);
+        restored.prepareToPlay (playHead.sampleRate, blockSize);
+        restored.setStateInformation (state.getData(), (int) state.getSize());
+        CHECK (restored.isFrozen.load());
+
+        const auto expected = runPass (plugin, playHead, false);
+        const auto frozen = runPass (restored, playHead, false);
+
+        CHECK (frozen == expected);
+
+        // A state saved unfrozen loads unfrozen
+        plugin.isFrozen.store (false);
+        plugin.getStateInformation (state);
+        restored.setStateInformation (state.getData(), (int) state.getSize());
+        CHECK_FALSE (restored.isFrozen.load());
+
+        restored.setPlayHead (nullptr);
+    }
+
+    SECTION ("recording a Ghost overrides freeze")
+    {
+        plugin.isFrozen.store (true);
+        plugin.isGhostReading.store (false);
+        plugin.isGhostRecording.store (true);
+
+        const auto live = runPass (plugin, playHead, true);
+        const auto frozen = [&] {
+            plugin.isGhostRecording.store (false);
+            return runPass (plugin, playHead, false);
+        }();
+
+        CHECK (live != frozen);
+    }
+
+    plugin.setPlayHead (nullptr);
+}
+
+TEST_CASE ("Freeze replays the ride the modifiers made", "[freeze]")
+{
+    PluginProcessor plugin;
+    SyntheticPlayHead playHead;
+    playHead.sampleRate = 48000.0;
+    plugin.setPlayHead (&playHead);
+    plugin.setNonRealtime (true);
+    plugin.prepareToPlay (playHead.sampleRate, blockSize);
+
+    plugin.parameters.mode = 1;
+    plugin.parameters.externalSidechain = true;
+    plugin.parameters.flip = true;
+
+    SECTION ("FLIP stays the right way up")
+    {
+        const auto ridden = recordAndRide (plugin, playHead);
+
+        plugin.isFrozen.store (true);
+        const auto worst = worstDifference (runPass (plugin, playHead, false), ridden);
+
+        INFO ("worst " << worst);
+        CHECK (worst < 0.002);
+    }
+
+    SECTION ("SHRED runs on top of the frozen gain")
+    {
+        plugin.parameters.shred = true;
+        plugin.parameters.shredMode = 0; // SHRED I
+        const auto ridden = recordAndRide (plugin, playHead);
+
+        plugin.isFrozen.store (true);
+        const auto worst = worstDifference (runPass (plugin, playHead, false), ridden);
+
+        INFO ("worst " << worst);
+        CHECK (worst < 0.02); // SHRED I steepens small gain differences up to ~7x
+    }
+
+    SECTION ("CHOP holds freeze off")
+    {
+        plugin.parameters.chop = true;
+        plugin.parameters.chopThreshold = 0.5f;
+        const auto ridden = recordAndRide (plugin, playHead);
+
+        plugin.isFrozen.store (true);
+        CHECK (runPass (plugin, playHead, true) == ridden);
+    }
+
+    plugin.setPlayHead (nullptr);
+}
+
+TEST_CASE ("The frozen curve goes with the Ghost it rode", "[freeze]")
+{
+    PluginProcessor plugin;
+    SyntheticPlayHead playHead;
+    playHead.sampleRate = 48000.0;
+    plugin.setPlayHead (&playHead);
+    plugin.setNonRealtime (true);
+    plugin.prepareToPlay (playHead.sampleRate, blockSize);
+
+    plugin.parameters.mode = 1;
+    plugin.parameters.externalSidechain = true;
+
+    recordAndRide (plugin, playHead);
+    plugin.isFrozen.store (true);
+    REQUIRE (plugin.frozenGainMap.getResolution() > 0.0);
+
+    const auto dropped = [&plugin] {
+        return ! plugin.isFrozen.load() && plugin.frozenGainMap.getResolution() == 0.0;
+    };
+
+    SECTION ("another slot selected")
+    {
+        plugin.ghostLibrary.selectSlot (1);
+        CHECK (dropped());
+    }
+
+    SECTION ("a Ghost imported into the active slot")
+    {
+        plugin.ghostLibrary.installSlot (1, plugin.ghostLibrary.createMap(), "Elsewhere");
+        CHECK_FALSE (dropped()); // not the one being ridden
+
+        plugin.ghostLibrary.installSlot (0, plugin.ghostLibrary.createMap(), "Imported");
+        CHECK (dropped());
+    }
+
+    SECTION ("a state with other Ghosts loaded")
+    {
+        PluginProcessor other;
+        other.ghostLibrary.editSlot (0).allocateRange (0, 10);
+        other.ghostLibrary.editSlot (0).write (0, 3, 0.5f);
+
+        juce::MemoryBlock state;
+        other.getStateInformation (state);
+        plugin.setStateInformation (state.getData(), (int) state.getSize());
+        CHECK (dropped());
+
+        // Nor does a dropped curve go into the next state
+        plugin.getStateInformation (state);
+        PluginProcessor restored;
+        restored.setStateInformation (state.getData(), (int) state.getSize());
+        CHECK (restored.frozenGainMap.getNumAllocatedPages() == 0);
+    }
+
+    SECTION ("a new recording")
+    {
+        plugin.startGhostRecording();
+        CHECK (dropped());
+        CHECK (plugin.isGhostRecording.load());
+    }
+
+    plugin.setPlayHead (nullptr);
+}
+
+TEST_CASE ("A curve frozen under LOOK still lands on its samples", "[freeze][lookahead]")
+{
+    PluginProcessor plugin;
+    SyntheticPlayHead playHead;
+    playHead.sampleRate = 48000.0;
+    plugin.setPlayHead (&playHead);
+    plugin.setNonRealtime (true);
+    plugin.setLookaheadEnabled (true);
+    plugin.prepareToPlay (playHead.sampleRate, blockSize);
+
+    plugin.parameters.mode = 1;
+    plugin.parameters.externalSidechain = true;
+
+    const auto ridden = recordAndRide (plugin, playHead);
+    CHECK (plugin.frozenWithLookahead.load());
+
+    const auto latency = plugin.getLatencySamples();
+    REQUIRE (latency > 0);
+
+    SECTION ("the flag goes with the curve")
+    {
+        plugin.isFrozen.store (true);
+
+        juce::MemoryBlock state;
+        plugin.getStateInformation (state);
+
+        PluginProcessor restored;
+        restored.setStateInformation (state.getData(), (int) state.getSize());
+        CHECK (restored.frozenWithLookahead.load());
+    }
+
+    SECTION ("replayed with LOOK off, the gain meets the input it was made for")
+    {
+        // With LOOK off the input comes out latency samples sooner, so the ride does too
+        plugin.setLookaheadEnabled (false);
+        plugin.isFrozen.store (true);
+        const auto frozen = runPass (plugin, playHead, false);
+
+        double worst = 0.0;
+
+        for (size_t i = (size_t) blockSize; i + (size_t) (latency + blockSize) < frozen.size(); ++i)
+            worst = std::max (worst, (double) std::abs (frozen[i] - ridden[i + (size_t) latency]));
+
+        INFO ("worst " << worst);
+        CHECK (worst < 0.002);
+    }
+
+    plugin.setPlayHead (nullptr);
+}
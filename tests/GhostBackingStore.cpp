@@ -0,0 +1,260 @@
+#include <PluginProcessor.h>
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+    juce::File makeScratchDirectory()
+    {
+        auto directory = juce::File::getSpecialLocation (juce::File::tempDirectory).getNonexistentChildFile ("ghost-pages", {});
+        REQUIRE (directory.createDirectory());
+        return directory;
+    }
+
+    int numBackingFiles (const juce::File& directory)
+    {
+        return directory.findChildFiles (juce::File::findFiles, true, "*.ghostpages").size();
+    }
+}
+
+TEST_CASE ("File-backed Ghost maps", "[ghost][backing]")
+{
+    const auto directory = makeScratchDirectory();
+    const auto file = directory.getChildFile ("test.ghostpages");
+
+    SECTION ("read and write like heap maps")
+    {
+        GhostMap heap, backed;
+        backed.setBackingFile (file);
+        CHECK (backed.isFileBacked());
+        CHECK_FALSE (heap.isFileBacked());
+
+        for (auto* map : { &heap, &backed })
+        {
+            map->allocateRange (0, 3 * GhostMap::pageSize);
+
+            for (int index = 0; index < 3 * GhostMap::pageSize; index += 7)
+                map->write (index % 2, index, (float) (index % 100) / 100.0f);
+        }
+
+        CHECK (file.existsAsFile());
+        CHECK (backed.readCode (0, 4 * GhostMap::pageSize) == GhostCodec::noDataCode);
+
+        for (int ch = 0; ch < GhostMap::numChannels; ++ch)
+            for (int index = 0; index < 3 * GhostMap::pageSize + 1; ++index)
+                REQUIRE (backed.readCode (ch, index) == heap.readCode (ch, index));
+
+        juce::MemoryOutputStream heapState, backedState;
+        heap.writeState (heapState);
+        backed.writeState (backedState);
+        CHECK (heapState.getMemoryBlock() == backedState.getMemoryBlock());
+
+        backed.clear();
+        CHECK (backed.readCode (1, 7) == GhostCodec::noDataCode);
+    }
+
+    SECTION ("the file grows a segment at a time, densely")
+    {
+        GhostMap map;
+        map.setBackingFile (file);
+        CHECK (map.getBackingFileSize() == 0);
+
+        // Pages far apart on the timeline still sit side by side in the file
+        map.allocateRange (0, 0);
+        map.allocateRange (1000 * GhostMap::pageSize, 1000 * GhostMap::pageSize);
+        const auto segmentSize = map.getBackingFileSize();
+
+        CHECK (segmentSize > 0);
+        CHECK (segmentSize < 300 * GhostMap::pageSize * GhostMap::numChannels * sizeof (std::uint16_t));
+        CHECK (file.getSize() == (juce::int64) segmentSize);
+        CHECK (segmentSize % 65536 == 0);
+
+        map.write (0, 1000 * GhostMap::pageSize + 3, 0.5f);
+        CHECK (map.read (0, 1000 * GhostMap::pageSize + 3) > 0.49f);
+    }
+
+    SECTION ("the pager allocates pages in the file around the playhead")
+    {
+        GhostMap map;
+        map.setBackingFile (file);
+
+        map.publishPlayhead (10 * GhostMap::pageSize, false);
+        map.servicePages();
+        CHECK (map.getNumAllocatedPages() == 0);
+
+        map.publishPlayhead (10 * GhostMap::pageSize, true);
+        map.servicePages();
+        CHECK (map.getNumAllocatedPages() == 4);
+        CHECK (map.writeCode (0, 12 * GhostMap::pageSize, 1234));
+
+        // Reading only: the pages stay as they are, the prefetch just keeps them resident
+        map.publishPlayhead (11 * GhostMap::pageSize, false);
+        map.servicePages();
+        CHECK (map.getNumAllocatedPages() == 4);
+        CHECK (map.readCode (0, 12 * GhostMap::pageSize) == 1234);
+    }
+
+    SECTION ("pages in later segments don't overlap")
+    {
+        // More than one segment's worth, every index written, so a slot that ran into its neighbour shows up
+        const auto numPages = 600;
+        const auto numIndices = numPages * GhostMap::pageSize;
+
+        GhostMap map;
+        map.setBackingFile (file);
+        map.allocateRange (0, numIndices - 1);
+
+        CHECK (map.getNumAllocatedPages() == numPages);
+        CHECK (map.getBackingFileSize() >= (size_t) numPages * GhostMap::pageSize * GhostMap::numChannels * sizeof (std::uint16_t));
+        CHECK (map.getBackingFileSize() % 65536 == 0);
+        CHECK (file.getSize() == (juce::int64) map.getBackingFileSize());
+
+        const auto codeFor = [] (int channel, int index) { return (std::uint16_t) (2 + (index * 2 + channel) % 60000); };
+
+        for (int ch = 0; ch < GhostMap::numChannels; ++ch)
+            for (int index = 0; index < numIndices; ++index)
+                map.writeCode (ch, index, codeFor (ch, index));
+
+        for (int ch = 0; ch < GhostMap::numChannels; ++ch)
+            for (int index = 0; index < numIndices; ++index)
+                REQUIRE (map.readCode (ch, index) == codeFor (ch, index));
+    }
+
+    SECTION ("a three-hour program")
+    {
+        // 3 hours at 120 bpm on the 500 PPQ grid
+        const auto numIndices = 3 * 60 * 120 * 500;
+        const auto numPages = (numIndices + GhostMap::pageSize - 1) / GhostMap::pageSize;
+
+        GhostMap map;
+        map.setBackingFile (file);
+        map.allocateRange (0, numIndices - 1);
+
+        for (int index = 0; index < numIndices; index += 97)
+            map.writeCode (index % 2, index, (std::uint16_t) (2 + index % 30000));
+
+        CHECK (map.getNumAllocatedPages() == numPages);
+        CHECK (map.getBackingFileSize() >= (size_t) numPages * GhostMap::pageSize * GhostMap::numChannels * sizeof (std::uint16_t));
+
+        for (int index = 0; index < numIndices; index += 97)
+            REQUIRE (map.readCode (index % 2, index) == (std::uint16_t) (2 + index % 30000));
+    }
+
+    SECTION ("falls back to the heap when the file can't be made")
+    {
+        const auto notADirectory = directory.getChildFile ("plain file");
+        notADirectory.replaceWithText ("in the way");
+
+        GhostMap map;
+        map.setBackingFile (notADirectory.getChildFile ("test.ghostpages"));
+        map.allocateRange (0, 10);
+
+        CHECK (map.getNumAllocatedPages() == 1);
+        CHECK (map.getBackingFileSize() == 0);
+        CHECK (map.write (0, 5, 0.5f));
+        CHECK (map.read (0, 5) > 0.49f);
+    }
+
+    CHECK_FALSE (file.exists());
+    directory.deleteRecursively();
+}
+
+TEST_CASE ("Ghost library slots can live in backing files", "[ghost][backing][library]")
+{
+    const auto directory = makeScratchDirectory();
+
+    {
+        GhostLibrary library;
+        library.setBackingDirectory (directory);
+        CHECK (library.getBackingDirectory() == directory);
+
+        library.editSlot (0).allocateRange (0, 10);
+        library.editSlot (2).allocateRange (0, 10);
+        CHECK (library.getSlot (0)->isFileBacked());
+        CHECK (numBackingFiles (directory) == 2);
+        CHECK (directory.getNumberOfChildFiles (juce::File::findFiles, "*.ghostpages") == 0); // in the session folder
+
+        auto imported = library.createMap();
+        CHECK (imported->isFileBacked());
+
+        library.clearSlot (2);
+        library.service (false);
+        CHECK (numBackingFiles (directory) == 1);
+
+        library.setBackingDirectory ({});
+        CHECK_FALSE (library.createMap()->isFileBacked());
+    }
+
+    CHECK (numBackingFiles (directory) == 0);
+    directory.deleteRecursively();
+}
+
+TEST_CASE ("Ghost scratch folders", "[ghost][backing]")
+{
+    const auto directory = makeScratchDirectory();
+
+    SECTION ("each process keeps its files in a folder of its own, gone once it's done")
+    {
+        {
+            GhostScratchFolders folders;
+            const auto first = folders.createFileIn (directory, "Ghost");
+            const auto second = folders.createFileIn (directory, "Frozen");
+
+            CHECK (first.getParentDirectory() == second.getParentDirectory());
+            CHECK (first.getParentDirectory().getParentDirectory() == directory);
+            CHECK (first.getParentDirectory().isDirectory());
+            CHECK (first.hasFileExtension ("ghostpages"));
+            CHECK (first != second);
+        }
+
+        CHECK (directory.getNumberOfChildFiles (juce::File::findFilesAndDirectories) == 0);
+    }
+
+    SECTION ("what a crashed host left behind is swept on first use")
+    {
+        // A session folder and lock file nobody holds, and a file from before the session folders
+        const auto stale = directory.getChildFile ("Session-dead");
+        REQUIRE (stale.getChildFile ("Ghost-dead.ghostpages").create());
+        REQUIRE (directory.getChildFile ("Session-dead.lock").create());
+        REQUIRE (directory.getChildFile ("Session-lost.lock").create());
+        REQUIRE (directory.getChildFile ("Ghost-old.ghostpages").create());
+        REQUIRE (directory.getChildFile ("notes.txt").create());
+
+        GhostScratchFolders folders;
+        const auto file = folders.createFileIn (directory, "Ghost");
+
+        CHECK_FALSE (stale.exists());
+        CHECK_FALSE (directory.getChildFile ("Session-dead.lock").exists());
+        CHECK_FALSE (directory.getChildFile ("Session-lost.lock").exists());
+        CHECK_FALSE (directory.getChildFile ("Ghost-old.ghostpages").exists());
+        CHECK (directory.getChildFile ("notes.txt").exists());
+        CHECK (file.getParentDirectory().isDirectory());
+
+        // Its own folder survives a sweep
+        REQUIRE (file.create());
+        CHECK (folders.sweep (directory) == 0);
+        CHECK (file.exists());
+        file.deleteFile();
+    }
+
+    directory.deleteRecursively();
+}
+
+TEST_CASE ("The plugin keeps its Ghosts on the heap unless given a scratch directory", "[ghost][backing]")
+{
+    const auto directory = makeScratchDirectory();
+
+    {
+        PluginProcessor plugin;
+
+        CHECK_FALSE (plugin.frozenGainMap.isFileBacked());
+        CHECK_FALSE (plugin.ghostLibrary.editActiveSlot().isFileBacked());
+
+        plugin.setGhostScratchDirectory (directory);
+
+        CHECK (plugin.frozenGainMap.isFileBacked());
+        CHECK_FALSE (plugin.ghostLibrary.getSlot (0)->isFileBacked()); // made before
+        CHECK (plugin.ghostLibrary.editSlot (1).isFileBacked());
+    }
+
+    directory.deleteRecursively();
+}
@@ -0,0 +1,195 @@
+#include <PluginProcessor.h>
+#include <SyntheticPlayHead.h>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+
+    // A stereo reference with a moving level: a slow swell on the left, phrases on the right
+    juce::AudioBuffer<float> makeReference (double seconds)
+    {
+        juce::AudioBuffer<float> reference (2, (int) (seconds * sampleRate));
+
+        for (int i = 0; i < reference.getNumSamples(); ++i)
+        {
+            const auto t = (double) i / sampleRate;
+            const auto tone = std::sin (juce::MathConstants<double>::twoPi * 220.0 * t);
+            const auto swell = 0.3 + 0.25 * std::sin (juce::MathConstants<double>::twoPi * 0.4 * t);
+            const auto phrase = ((int) (t * 2.0) % 3 == 0) ? 0.02 : 0.5;
+
+            reference.setSample (0, i, (float) (swell * tone));
+            reference.setSample (1, i, (float) (phrase * tone));
+        }
+
+        return reference;
+    }
+
+    juce::File writeReference (const juce::AudioBuffer<float>& reference, juce::AudioFormat& format, const juce::String& extension)
+    {
+        auto file = juce::File::getSpecialLocation (juce::File::tempDirectory).getNonexistentChildFile ("ghost-import", extension);
+        std::unique_ptr<juce::OutputStream> stream (file.createOutputStream());
+
+        const auto options = juce::AudioFormatWriterOptions {}
+                                 .withSampleRate (sampleRate)
+                                 .withNumChannels (reference.getNumChannels())
+                                 .withBitsPerSample (24);
+
+        auto writer = format.createWriterFor (stream, options);
+        REQUIRE (writer != nullptr);
+        writer->writeFromAudioSampleBuffer (reference, 0, reference.getNumSamples());
+
+        return file;
+    }
+
+    // Worst difference in GhostCodec steps between two maps over [first, end)
+    int maxCodeDifference (const GhostMap& a, const GhostMap& b, int first, int end)
+    {
+        int worst = 0;
+
+        for (int ch = 0; ch < GhostMap::numChannels; ++ch)
+            for (int index = first; index < end; ++index)
+                worst = std::max (worst, std::abs ((int) a.readCode (ch, index) - (int) b.readCode (ch, index)));
+
+        return worst;
+    }
+}
+
+TEST_CASE ("Ghost import", "[ghost][import]")
+{
+    const auto reference = makeReference (20.0);
+    juce::WavAudioFormat wav;
+    const auto file = writeReference (reference, wav, ".wav");
+
+    GhostImport::Settings settings;
+    settings.bpm = 120.0;
+    settings.startPPQ = 4.0;
+
+    // 20 seconds at 120 bpm is 40 quarters, starting one bar in
+    const auto firstIndex = 4 * 500;
+    const auto endIndex = 44 * 500;
+
+    GhostMap single;
+    settings.numThreads = 1;
+    REQUIRE (GhostImport::analyseFile (file, settings, single).wasOk());
+
+    SECTION ("covers the file")
+    {
+        CHECK (single.readCode (0, firstIndex - 1) == GhostCodec::noDataCode);
+        CHECK (single.readCode (0, firstIndex) != GhostCodec::noDataCode);
+        CHECK (single.readCode (1, endIndex - 1) != GhostCodec::noDataCode);
+        CHECK (single.readCode (1, endIndex) == GhostCodec::noDataCode);
+    }
+
+    SECTION ("segments join up without a seam")
+    {
+        std::atomic<float> progress { 0.0f };
+        GhostMap segmented;
+        settings.numThreads = 6;
+        REQUIRE (GhostImport::analyseFile (file, settings, segmented, &progress).wasOk());
+
+        CHECK (progress.load() == 1.0f);
+        CHECK (maxCodeDifference (single, segmented, 0, endIndex + 500) <= 1);
+    }
+
+    SECTION ("matches a Ghost recorded in realtime through the sidechain")
+    {
+        PluginProcessor plugin;
+        SyntheticPlayHead playHead;
+        playHead.sampleRate = sampleRate;
+        playHead.bpm = settings.bpm;
+        playHead.playing = true;
+        playHead.jumpTo (settings.startPPQ);
+        plugin.setPlayHead (&playHead);
+        plugin.setNonRealtime (true);
+        plugin.prepareToPlay (sampleRate, 512);
+
+        plugin.parameters.externalSidechain = true;
+        plugin.isGhostRecording.store (true);
+
+        juce::AudioBuffer<float> buffer (plugin.getTotalNumInputChannels(), 512);
+        juce::MidiBuffer midi;
+
+        for (int start = 0; start + 512 <= reference.getNumSamples(); start += 512)
+        {
+            buffer.clear();
+
+            for (int ch = 0; ch < 2; ++ch)
+                buffer.copyFrom (ch + 2, 0, reference, ch, start, 512);
+
+            plugin.processBlock (buffer, midi);
+            playHead.advance (512);
+        }
+
+        plugin.setPlayHead (nullptr);
+
+        // The live recording warms its followers up differently, so skip the first 200 ms. Block
+        // by block PPQ can put an index boundary a sample away from where the import puts it,
+        // which on the steepest onsets is worth up to 100 codes (0.3 dB).
+        const auto& recorded = *plugin.ghostLibrary.getSlot (0);
+        CHECK (maxCodeDifference (single, recorded, firstIndex + 100, endIndex - 500) <= 100);
+    }
+
+    SECTION ("reads AIFF and FLAC")
+    {
+        juce::AiffAudioFormat aiff;
+        juce::FlacAudioFormat flac;
+
+        for (auto* format : std::initializer_list<juce::AudioFormat*> { &aiff, &flac })
+        {
+            const auto other = writeReference (reference, *format, format->getFileExtensions()[0]);
+
+            GhostMap imported;
+            CHECK (GhostImport::analyseFile (other, settings, imported).wasOk());
+            CHECK (maxCodeDifference (single, imported, 0, endIndex + 500) <= 1);
+
+            other.deleteFile();
+        }
+    }
+
+    SECTION ("refuses what it can't import")
+    {
+        GhostMap map;
+        const auto text = juce::File::getSpecialLocation (juce::File::tempDirectory).getNonexistentChildFile ("not-audio", ".wav");
+        text.replaceWithText ("definitely not audio");
+
+        CHECK (GhostImport::analyseFile (text, settings, map).failed());
+        CHECK (GhostImport::analyseFile (file.getSiblingFile ("missing.wav"), settings, map).failed());
+
+        settings.bpm = 0.0;
+        CHECK (GhostImport::analyseFile (file, settings, map).failed());
+        CHECK (map.getNumAllocatedPages() == 0);
+
+        text.deleteFile();
+    }
+
+    file.deleteFile();
+}
+
+TEST_CASE ("Ghost importer fills a slot in the background", "[ghost][import]")
+{
+    juce::WavAudioFormat wav;
+    const auto file = writeReference (makeReference (5.0), wav, ".wav");
+
+    GhostLibrary library;
+    GhostImporter importer (library);
+
+    GhostImport::Settings settings;
+    REQUIRE (importer.startImport (file, 2, settings));
+
+    // The slot is installed on the message thread, which is this one
+    for (int wait = 0; wait < 500 && importer.getNumFinished() == 0; ++wait)
+        juce::MessageManager::getInstance()->runDispatchLoopUntil (10);
+
+    REQUIRE (importer.getNumFinished() == 1);
+    CHECK (importer.getLastResult().wasOk());
+    CHECK_FALSE (importer.wasCancelled());
+
+    REQUIRE (library.getSlot (2) != nullptr);
+    CHECK (library.getSlot (2)->readCode (0, 100) != GhostCodec::noDataCode);
+    CHECK (library.getSlotName (2) == file.getFileNameWithoutExtension());
+    CHECK (library.getSlot (0) == nullptr);
+
+    file.deleteFile();
+}
@@ -0,0 +1,218 @@
+#include <PluginProcessor.h>
+#include <PluginState.h>
+#include <SyntheticPlayHead.h>
+#include <catch2/catch_test_macros.hpp>
+
+TEST_CASE ("Ghost library slots", "[ghost][library]")
+{
+    GhostLibrary library;
+
+    SECTION ("empty slots have no storage")
+    {
+        for (int slot = 0; slot < GhostLibrary::numSlots; ++slot)
+            CHECK (library.getSlot (slot) == nullptr);
+
+        const GhostLibrary::ReadScope scope (library);
+        CHECK_FALSE (scope.hasStorage());
+        CHECK (scope.getMap().read (0, 0) < 0.0f);
+    }
+
+    SECTION ("selecting a slot publishes its map")
+    {
+        library.editSlot (1).allocateRange (0, 10);
+        library.editSlot (1).write (0, 5, 0.5f);
+
+        {
+            const GhostLibrary::ReadScope scope (library);
+            CHECK (&scope.getMap() != library.getSlot (1));
+        }
+
+        library.selectSlot (1);
+
+        const GhostLibrary::ReadScope scope (library);
+        CHECK (&scope.getMap() == library.getSlot (1));
+        CHECK (scope.getMap().read (0, 5) > 0.0f);
+    }
+
+    SECTION ("a cleared map outlives the block holding it")
+    {
+        library.editActiveSlot().allocateRange (0, 10);
+
+        {
+            const GhostLibrary::ReadScope scope (library);
+            auto& held = scope.getMap();
+
+            library.clearSlot (0);
+            CHECK (library.getSlot (0) == nullptr);
+
+            library.service (false);
+            CHECK (library.getNumRetiredMaps() == 1);
+            CHECK (held.getNumAllocatedPages() == 1); // still alive and readable
+        }
+
+        library.service (false);
+        CHECK (library.getNumRetiredMaps() == 0);
+    }
+
+    SECTION ("recording into an empty slot asks for storage")
+    {
+        {
+            const GhostLibrary::ReadScope scope (library);
+            scope.requestStorage();
+        }
+
+        library.service (false);
+        CHECK (library.getSlot (0) != nullptr);
+
+        const GhostLibrary::ReadScope scope (library);
+        CHECK (scope.hasStorage());
+    }
+}
+
+TEST_CASE ("Ghost library state", "[ghost][library][state]")
+{
+    PluginProcessor original;
+    auto& library = original.ghostLibrary;
+
+    library.editSlot (0).allocateRange (0, 10);
+    library.editSlot (0).write (0, 3, 0.25f);
+    library.editSlot (2).allocateRange (0, 10);
+    library.editSlot (2).write (1, 7, 0.75f);
+    library.setSlotName (2, "Chorus ride");
+    library.selectSlot (2);
+
+    juce::MemoryBlock state;
+    original.getStateInformation (state);
+
+    PluginProcessor restored;
+    restored.ghostLibrary.editSlot (1).allocateRange (0, 10); // must end up empty again
+    restored.setStateInformation (state.getData(), (int) state.getSize());
+
+    const auto& loaded = restored.ghostLibrary;
+    REQUIRE (loaded.getSlot (0) != nullptr);
+    REQUIRE (loaded.getSlot (2) != nullptr);
+    CHECK (loaded.getSlot (1) == nullptr);
+
+    CHECK (loaded.getSlot (0)->read (0, 3) > 0.24f);
+    CHECK (loaded.getSlot (2)->read (1, 7) > 0.74f);
+    CHECK (loaded.getSlotName (2) == "Chorus ride");
+    CHECK (loaded.getActiveSlot() == 2);
+}
+
+TEST_CASE ("Loading a library state swaps in new maps", "[ghost][library][state]")
+{
+    GhostLibrary source;
+    source.editSlot (0).allocateRange (0, 10);
+    source.editSlot (0).write (0, 3, 0.25f);
+
+    juce::MemoryOutputStream state;
+    source.writeState (state);
+
+    GhostLibrary library;
+    auto& old = library.editSlot (0);
+    old.allocateRange (0, 5 * GhostMap::pageSize);
+    old.write (0, 3 * GhostMap::pageSize, 0.5f);
+
+    SECTION ("the old map is retired, pages and all, and outlives the block holding it")
+    {
+        const GhostLibrary::ReadScope scope (library);
+
+        REQUIRE (library.readState (state.getData(), state.getDataSize()));
+        REQUIRE (library.getSlot (0) != &old);
+        CHECK (library.getSlot (0)->getNumAllocatedPages() == 1);
+        CHECK (library.getSlot (0)->read (0, 3) > 0.24f);
+        CHECK (library.getSlot (0)->read (0, 3 * GhostMap::pageSize) < 0.0f);
+
+        library.service (false);
+        CHECK (library.getNumRetiredMaps() == 1);
+        CHECK (scope.getMap().read (0, 3 * GhostMap::pageSize) > 0.49f); // the block still reads the old ride
+    }
+
+    SECTION ("a damaged state leaves the library alone")
+    {
+        CHECK_FALSE (library.readState (state.getData(), state.getDataSize() - 9)); // into the first slot's ride
+        CHECK (library.getSlot (0) == &old);
+        CHECK (old.read (0, 3 * GhostMap::pageSize) > 0.49f);
+        CHECK (library.getNumRetiredMaps() == 0);
+    }
+}
+
+TEST_CASE ("Switching Ghost slots mid-playback", "[ghost][library]")
+{
+    PluginProcessor plugin;
+    SyntheticPlayHead playHead;
+    playHead.sampleRate = 48000.0;
+    playHead.playing = true;
+    plugin.setPlayHead (&playHead);
+    plugin.prepareToPlay (playHead.sampleRate, 256);
+
+    juce::AudioBuffer<float> buffer (plugin.getTotalNumInputChannels(), 256);
+    juce::MidiBuffer midi;
+
+    auto play = [&] (int numBlocks) {
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                for (int i = 0; i < buffer.getNumSamples(); ++i)
+                    buffer.setSample (ch, i, 0.2f * std::sin ((float) (block * 256 + i) * 0.05f));
+
+            plugin.processBlock (buffer, midi);
+            playHead.advance (256);
+            plugin.ghostLibrary.service (false); // stands in for the pager between blocks
+        }
+    };
+
+    // Record into slot 1 without the editor: the first block asks for storage
+    plugin.isGhostRecording.store (true);
+    play (1);
+    CHECK (plugin.ghostLibrary.getSlot (0) != nullptr);
+    play (20);
+    plugin.isGhostRecording.store (false);
+
+    REQUIRE (plugin.ghostLibrary.getSlot (0) != nullptr);
+    CHECK (plugin.ghostLibrary.getSlot (0)->getNumAllocatedPages() > 0);
+
+    // Slot 2 stays empty, and reading it while playing is harmless
+    plugin.isGhostReading.store (true);
+    playHead.jumpTo (0.0);
+    plugin.ghostLibrary.selectSlot (1);
+    play (4);
+    plugin.ghostLibrary.selectSlot (0);
+    play (4);
+
+    CHECK (plugin.ghostLibrary.getSlot (1) == nullptr);
+    CHECK (buffer.getMagnitude (0, 256) > 0.0f);
+
+    plugin.setPlayHead (nullptr);
+}
+
+TEST_CASE ("A single-Ghost state loads into the first slot", "[ghost][library][state]")
+{
+    GhostMap ghost;
+    ghost.allocateRange (0, 10);
+    ghost.write (0, 4, 0.5f);
+
+    juce::MemoryOutputStream ghostState;
+    ghost.writeState (ghostState);
+
+    juce::MemoryBlock state;
+    {
+        juce::MemoryOutputStream out (state, false);
+        PluginState::writeHeader (out);
+        PluginState::writeSection (out, PluginState::ghostTag, ghostState.getMemoryBlock());
+    }
+
+    PluginProcessor restored;
+    restored.ghostLibrary.editSlot (1).allocateRange (0, 10); // the state knows of no other slots
+    restored.ghostLibrary.editSlot (2).allocateRange (0, 10);
+    restored.ghostLibrary.setSlotName (2, "Stale");
+    restored.ghostLibrary.selectSlot (2);
+    restored.setStateInformation (state.getData(), (int) state.getSize());
+
+    REQUIRE (restored.ghostLibrary.getSlot (0) != nullptr);
+    CHECK (restored.ghostLibrary.getSlot (0)->read (0, 4) > 0.49f);
+    CHECK (restored.ghostLibrary.getActiveSlot() == 0);
+    CHECK (restored.ghostLibrary.getSlot (1) == nullptr);
+    CHECK (restored.ghostLibrary.getSlot (2) == nullptr);
+    CHECK (restored.ghostLibrary.getSlotName (2).isEmpty());
+}
@@ -0,0 +1,118 @@
+#include <EngineStages.h>
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Eight samples per index, from index 0
+    EngineStages::GhostClock makeClock()
+    {
+        EngineStages::GhostClock clock;
+        clock.ppqPerSample = 0.125;
+        clock.ppqResolution = 1.0;
+        return clock;
+    }
+
+    // Replays numIndices indices of channel 0 and returns the target for every sample
+    std::vector<float> replay (const GhostMap& map, int numIndices, EngineStages::GhostLookahead* lookahead)
+    {
+        const auto numSamples = numIndices * 8;
+        std::vector<float> guide ((size_t) numSamples, 0.3f), target ((size_t) numSamples), present ((size_t) numSamples);
+        EngineStages::replayGhost (map, 0, guide.data(), 0, numSamples, makeClock(), target.data(), present.data(), lookahead);
+        return target;
+    }
+
+    bool levelsMatch (float a, float b)
+    {
+        return std::abs (20.0f * std::log10 (a / b)) < 0.01f;
+    }
+}
+
+TEST_CASE ("Sliding extreme matches a brute force scan", "[ghost][lookahead]")
+{
+    std::mt19937 random (42);
+    std::uniform_int_distribution<int> codes (0, 65535);
+
+    std::vector<std::uint16_t> in (300), prefix (300), suffix (300), out (300);
+    for (auto& code : in)
+        code = (std::uint16_t) codes (random);
+
+    for (const int window : { 1, 2, 3, 7, 16, 100, 300 })
+    {
+        const auto count = (int) in.size();
+        bool allMatch = true;
+
+        EngineStages::slidingExtreme<true> (in.data(), count, window, prefix.data(), suffix.data(), out.data());
+
+        for (int j = 0; j <= count - window; ++j)
+            allMatch = allMatch && out[(size_t) j] == *std::max_element (in.begin() + j, in.begin() + j + window);
+
+        EngineStages::slidingExtreme<false> (in.data(), count, window, prefix.data(), suffix.data(), out.data());
+
+        for (int j = 0; j <= count - window; ++j)
+            allMatch = allMatch && out[(size_t) j] == *std::min_element (in.begin() + j, in.begin() + j + window);
+
+        INFO ("window " << window);
+        CHECK (allMatch);
+    }
+}
+
+TEST_CASE ("Ghost lookahead pre-ramps ahead of level changes", "[ghost][lookahead]")
+{
+    // 0.5 up to index 40, 0.05 from there on, then back up at 80
+    GhostMap map;
+    map.allocateRange (0, 200);
+
+    for (int i = 0; i < 120; ++i)
+        map.write (0, i, (i >= 40 && i < 80) ? 0.05f : 0.5f);
+
+    EngineStages::GhostLookahead lookahead;
+    lookahead.windowIndices = 5;
+
+    const auto plain = replay (map, 110, nullptr);
+
+    SECTION ("off by default")
+    {
+        EngineStages::GhostLookahead off;
+        CHECK (replay (map, 110, &off) == plain);
+    }
+
+    SECTION ("towards the minimum")
+    {
+        const auto ahead = replay (map, 110, &lookahead);
+
+        // The drop at index 40 is seen from index 35 on; before that nothing changes
+        CHECK (ahead[34 * 8 + 7] == plain[34 * 8 + 7]);
+        CHECK (levelsMatch (ahead[35 * 8], 0.05f));
+        CHECK (levelsMatch (ahead[39 * 8 + 4], 0.05f));
+
+        // Going back up isn't anticipated
+        CHECK (levelsMatch (ahead[79 * 8 + 7], plain[79 * 8 + 7]));
+        CHECK (levelsMatch (ahead[80 * 8], 0.5f));
+    }
+
+    SECTION ("towards the maximum")
+    {
+        lookahead.towardsMax = true;
+        const auto ahead = replay (map, 110, &lookahead);
+
+        CHECK (ahead[74 * 8 + 7] == plain[74 * 8 + 7]);
+        CHECK (levelsMatch (ahead[75 * 8], 0.5f));
+        CHECK (levelsMatch (ahead[40 * 8 + 4], plain[40 * 8 + 4]));
+    }
+
+    SECTION ("missing data ahead is ignored")
+    {
+        GhostMap sparse;
+        sparse.allocateRange (0, 200);
+
+        for (int i = 0; i < 20; ++i)
+            sparse.write (0, i, 0.5f);
+
+        const auto ahead = replay (sparse, 19, &lookahead);
+        CHECK (levelsMatch (ahead[18 * 8 + 4], 0.5f));
+    }
+}
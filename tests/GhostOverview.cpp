@@ -0,0 +1,195 @@
+#include <GhostLibrary.h>
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+
+namespace
+{
+    // What a pixel over [first, end) should show, straight from the codes
+    GhostOverview::Summary bruteForce (const GhostMap& map, int channel, int first, int end)
+    {
+        std::uint16_t minCode = 0xffff, maxCode = 0;
+        std::uint64_t sum = 0, count = 0;
+
+        for (int index = std::max (0, first); index < end; ++index)
+        {
+            const auto code = map.readCode (channel, index);
+
+            if (code == GhostCodec::noDataCode)
+                continue;
+
+            minCode = std::min (minCode, code);
+            maxCode = std::max (maxCode, code);
+            sum += code;
+            ++count;
+        }
+
+        if (count == 0)
+            return {};
+
+        return { GhostCodec::fromCode (minCode), GhostCodec::fromCode (maxCode),
+                 GhostCodec::fromCode ((std::uint16_t) ((sum + count / 2) / count)) };
+    }
+
+    bool sameSummary (const GhostOverview::Summary& a, const GhostOverview::Summary& b)
+    {
+        return a.minimum == b.minimum && a.maximum == b.maximum && a.mean == b.mean;
+    }
+
+    // A few pages of random ride with holes in it, and one far away page
+    void fillRandomRide (GhostMap& map)
+    {
+        std::mt19937 random (3);
+        std::uniform_int_distribution<int> codes (1, 65535);
+
+        map.allocateRange (0, 6 * GhostMap::pageSize);
+        map.allocateRange (100 * GhostMap::pageSize, 100 * GhostMap::pageSize + 10);
+
+        for (int index = 0; index < 6 * GhostMap::pageSize; ++index)
+            if ((index / 700) % 3 != 1)
+                for (int ch = 0; ch < GhostMap::numChannels; ++ch)
+                    map.writeCode (ch, index, (std::uint16_t) codes (random));
+
+        map.writeCode (1, 100 * GhostMap::pageSize + 5, 40000);
+    }
+}
+
+TEST_CASE ("Ghost overview matches a brute force scan", "[ghost][overview]")
+{
+    GhostMap map;
+    fillRandomRide (map);
+    map.refreshOverview();
+
+    const auto& overview = map.getOverview();
+
+    SECTION ("every level")
+    {
+        for (const double indicesPerPixel : { 64.0, 128.0, 512.0, 4096.0, 16384.0, 1048576.0 })
+        {
+            const auto numPixels = (int) (110.0 * GhostMap::pageSize / indicesPerPixel) + 1;
+            std::vector<GhostOverview::Summary> pixels ((size_t) numPixels);
+            bool allMatch = true;
+
+            for (int ch = 0; ch < GhostMap::numChannels; ++ch)
+            {
+                overview.render (ch, 0.0, indicesPerPixel, pixels.data(), numPixels);
+
+                for (int p = 0; p < numPixels; ++p)
+                {
+                    const auto first = (int) (p * indicesPerPixel);
+                    const auto end = (int) std::min ((double) std::numeric_limits<int>::max(), (p + 1) * indicesPerPixel);
+                    allMatch = allMatch && sameSummary (pixels[(size_t) p], bruteForce (map, ch, first, end));
+                }
+            }
+
+            INFO ("indices per pixel " << indicesPerPixel);
+            CHECK (allMatch);
+        }
+    }
+
+    SECTION ("zoomed in past a bucket")
+    {
+        std::vector<GhostOverview::Summary> pixels (300);
+        overview.render (0, 1000.5, 3.0, pixels.data(), (int) pixels.size());
+
+        bool allMatch = true;
+
+        for (int p = 0; p < (int) pixels.size(); ++p)
+            allMatch = allMatch && sameSummary (pixels[(size_t) p], bruteForce (map, 0, (int) (1000.5 + p * 3.0), (int) (1000.5 + (p + 1) * 3.0)));
+
+        CHECK (allMatch);
+    }
+
+    SECTION ("pixels between buckets snap to them")
+    {
+        // 100 indices per pixel sits on the 64 index level: each pixel covers one or two buckets
+        std::vector<GhostOverview::Summary> pixels (100);
+        overview.render (0, 0.0, 100.0, pixels.data(), (int) pixels.size());
+
+        bool allMatch = true;
+
+        for (int p = 0; p < (int) pixels.size(); ++p)
+        {
+            const auto first = (int) std::floor (p * 100.0 / 64.0) * 64;
+            const auto end = (int) std::floor ((p + 1) * 100.0 / 64.0) * 64;
+            allMatch = allMatch && sameSummary (pixels[(size_t) p], bruteForce (map, 0, first, end));
+        }
+
+        CHECK (allMatch);
+    }
+
+    SECTION ("index range")
+    {
+        CHECK (overview.getIndexRange() == juce::Range<int> (0, 100 * GhostMap::pageSize + 6));
+    }
+}
+
+TEST_CASE ("Ghost overview follows recording", "[ghost][overview]")
+{
+    GhostMap map;
+    map.allocateRange (0, 4 * GhostMap::pageSize);
+    const auto& overview = map.getOverview();
+
+    // Allocated but never written: nothing to summarise
+    map.refreshOverview();
+    CHECK (overview.getVersion() == 0);
+    CHECK (overview.getIndexRange().isEmpty());
+
+    for (int index = 0; index < 1000; ++index)
+        map.write (0, index, 0.5f);
+
+    map.refreshOverview();
+    const auto afterFirstPass = overview.getVersion();
+    CHECK (afterFirstPass > 0);
+    CHECK (overview.getIndexRange() == juce::Range<int> (0, 1000));
+
+    // Nothing changed, nothing to do
+    map.refreshOverview();
+    CHECK (overview.getVersion() == afterFirstPass);
+
+    for (int index = 3 * GhostMap::pageSize; index < 3 * GhostMap::pageSize + 10; ++index)
+        map.write (0, index, 0.25f);
+
+    map.refreshOverview();
+    CHECK (overview.getVersion() == afterFirstPass + 1);
+    CHECK (overview.getIndexRange().getEnd() == 3 * GhostMap::pageSize + 10);
+
+    GhostOverview::Summary whole;
+    overview.render (0, 0.0, 4.0 * GhostMap::pageSize, &whole, 1);
+    CHECK (whole.maximum == GhostCodec::fromCode (GhostCodec::toCode (0.5f)));
+    CHECK (whole.minimum == GhostCodec::fromCode (GhostCodec::toCode (0.25f)));
+
+    // Clearing the map empties the overview too
+    map.clear();
+    map.refreshOverview();
+    overview.render (0, 0.0, 4.0 * GhostMap::pageSize, &whole, 1);
+    CHECK_FALSE (whole.hasData());
+}
+
+TEST_CASE ("Ghost overview of a 90 minute take", "[ghost][overview]")
+{
+    // 90 minutes at 120 bpm on the 500 PPQ grid
+    constexpr int numIndices = 90 * 120 * 500;
+
+    GhostLibrary library;
+    auto& map = library.editActiveSlot();
+    map.allocateRange (0, numIndices - 1);
+
+    for (int index = 0; index < numIndices; ++index)
+        for (int ch = 0; ch < GhostMap::numChannels; ++ch)
+            map.write (ch, index, 0.1f + 0.05f * (float) ((index / 2000) % 3));
+
+    library.service (false);
+
+    const auto& overview = map.getOverview();
+    REQUIRE (overview.getIndexRange() == juce::Range<int> (0, numIndices));
+
+    std::vector<GhostOverview::Summary> pixels (1000);
+    overview.render (1, 0.0, numIndices / 1000.0, pixels.data(), (int) pixels.size());
+
+    bool allInRange = true;
+
+    for (auto& pixel : pixels)
+        allInRange = allInRange && pixel.minimum > 0.099f && pixel.maximum < 0.201f && pixel.mean > pixel.minimum && pixel.mean < pixel.maximum;
+
+    CHECK (allInRange);
+}
@@ -0,0 +1,183 @@
+#include <GhostCodec.h>
+#include <PluginProcessor.h>
+#include <PluginState.h>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+
+namespace
+{
+    // A ride over two separate stretches of the timeline, with silence and gaps in it
+    void recordTestRide (GhostMap& map)
+    {
+        map.allocateRange (0, 3 * GhostMap::pageSize);
+        map.allocateRange (400 * GhostMap::pageSize, 401 * GhostMap::pageSize);
+
+        for (int i = 100; i < 2 * GhostMap::pageSize + 50; ++i)
+        {
+            if (i % 1000 < 40)
+                continue; // a gap
+
+            map.write (0, i, 0.2f + 0.15f * std::sin ((float) i * 0.01f));
+            map.write (1, i, (i % 3000 < 200) ? 0.0f : 0.05f);
+        }
+
+        for (int i = 400 * GhostMap::pageSize; i < 400 * GhostMap::pageSize + 300; ++i)
+        {
+            map.write (0, i, 1.5f);
+            map.write (1, i, 0.00002f);
+        }
+    }
+
+    bool levelsMatch (float restored, float original)
+    {
+        if (original < 0.0f || original == 0.0f)
+            return restored == original;
+
+        // Quantisation is ~0.003 dB per step
+        return std::abs (20.0f * std::log10 (restored / original)) < 0.002f;
+    }
+}
+
+TEST_CASE ("Ghost codec", "[ghost][state]")
+{
+    SECTION ("codes reserve no data and silence")
+    {
+        CHECK (GhostCodec::toCode (-1.0f) == GhostCodec::noDataCode);
+        CHECK (GhostCodec::toCode (0.0f) == GhostCodec::silenceCode);
+        CHECK (GhostCodec::fromCode (GhostCodec::noDataCode) < 0.0f);
+        CHECK (GhostCodec::fromCode (GhostCodec::silenceCode) == 0.0f);
+    }
+
+    SECTION ("silence sits just below the bottom of the log range")
+    {
+        const auto lowest = GhostCodec::toLog2 (GhostCodec::toCode (std::exp2 (GhostCodec::minLevelLog2)));
+        CHECK (GhostCodec::toLog2 (GhostCodec::silenceCode) < lowest);
+        CHECK (GhostCodec::toLog2 (GhostCodec::silenceCode) > lowest - 0.001f);
+    }
+
+    SECTION ("levels round trip within a step")
+    {
+        for (float db = -140.0f; db <= 40.0f; db += 0.37f)
+        {
+            const auto level = std::pow (10.0f, db / 20.0f);
+            CHECK (levelsMatch (GhostCodec::fromCode (GhostCodec::toCode (level)), level));
+        }
+    }
+}
+
+TEST_CASE ("Ghost state", "[ghost][state]")
+{
+    PluginProcessor original;
+    recordTestRide (original.ghostLibrary.editActiveSlot());
+
+    juce::MemoryBlock state;
+    original.getStateInformation (state);
+
+    SECTION ("round trips through the plugin state")
+    {
+        PluginProcessor restored;
+        restored.ghostLibrary.editActiveSlot().allocateRange (0, 10);
+        restored.ghostLibrary.editActiveSlot().write (0, 5, 0.7f); // stale data from before the load must go
+        restored.setStateInformation (state.getData(), (int) state.getSize());
+
+        bool allMatch = true;
+
+        for (const int base : { 0, 400 * GhostMap::pageSize })
+            for (int i = base; i < base + 3 * GhostMap::pageSize; ++i)
+                for (int ch = 0; ch < GhostMap::numChannels; ++ch)
+                    allMatch = allMatch && levelsMatch (restored.ghostLibrary.editActiveSlot().read (ch, i), original.ghostLibrary.editActiveSlot().read (ch, i));
+
+        CHECK (allMatch);
+    }
+
+    SECTION ("size follows the recorded content, not the timeline")
+    {
+        // ~8.5k recorded indices on two channels, far apart on the timeline
+        CHECK (state.getSize() < 40 * 1024);
+
+        PluginProcessor empty;
+        juce::MemoryBlock emptyState;
+        empty.getStateInformation (emptyState);
+        CHECK (emptyState.getSize() < 64);
+    }
+
+    SECTION ("background encoding gives the same state")
+    {
+        original.ghostLibrary.editActiveSlot().refreshEncodedPages();
+
+        juce::MemoryBlock refreshed;
+        original.getStateInformation (refreshed);
+        CHECK (refreshed == state);
+
+        // A write after the refresh must still make it into the next save
+        original.ghostLibrary.editActiveSlot().write (0, 200, 0.9f);
+        original.getStateInformation (refreshed);
+
+        PluginProcessor restored;
+        restored.setStateInformation (refreshed.getData(), (int) refreshed.getSize());
+        CHECK (levelsMatch (restored.ghostLibrary.editActiveSlot().read (0, 200), 0.9f));
+    }
+
+    SECTION ("garbage is ignored")
+    {
+        PluginProcessor restored;
+        restored.ghostLibrary.editActiveSlot().allocateRange (0, 10);
+        restored.ghostLibrary.editActiveSlot().write (0, 3, 0.5f);
+        const auto before = restored.ghostLibrary.editActiveSlot().readCode (0, 3);
+
+        const char junk[] = "definitely not a rider state";
+        restored.setStateInformation (junk, (int) sizeof (junk));
+        CHECK (restored.ghostLibrary.editActiveSlot().readCode (0, 3) == before);
+        CHECK (levelsMatch (restored.ghostLibrary.editActiveSlot().read (0, 3), 0.5f));
+    }
+
+    SECTION ("a state that can't be read to the end changes nothing")
+    {
+        PluginProcessor restored;
+        restored.parameters.mode = 2;
+        restored.ghostLibrary.editSlot (1).allocateRange (0, 10);
+        restored.ghostLibrary.editSlot (1).write (0, 3, 0.5f);
+        restored.ghostLibrary.selectSlot (1);
+
+        // Cut off in the middle of its last section
+        restored.setStateInformation (state.getData(), (int) state.getSize() - 1);
+
+        // From a newer version of the plugin
+        auto newer = state;
+        static_cast<char*> (newer.getData())[4] = (char) (PluginState::formatVersion + 1);
+        restored.setStateInformation (newer.getData(), (int) newer.getSize());
+
+        CHECK (restored.parameters.mode.getIndex() == 2);
+        CHECK (restored.ghostLibrary.getActiveSlot() == 1);
+        REQUIRE (restored.ghostLibrary.getSlot (1) != nullptr);
+        CHECK (levelsMatch (restored.ghostLibrary.getSlot (1)->read (0, 3), 0.5f));
+        CHECK (restored.ghostLibrary.getSlot (0) == nullptr);
+    }
+}
+
+TEST_CASE ("Ghost replay interpolates in the log domain", "[ghost]")
+{
+    GhostMap map;
+    map.allocateRange (0, 10);
+    map.write (0, 4, 0.5f);
+    map.write (0, 5, 0.125f);
+
+    // Four samples per index, starting on index 4
+    EngineStages::GhostClock clock;
+    clock.startPPQ = 4.0;
+    clock.ppqPerSample = 0.25;
+    clock.ppqResolution = 1.0;
+
+    const float guide[8] = { 0.3f, 0.3f, 0.3f, 0.3f, 0.3f, 0.3f, 0.3f, 0.3f };
+    float target[8], present[8];
+    EngineStages::replayGhost (map, 0, guide, 0, 8, clock, target, present);
+
+    // Halfway between -6 dB and -18 dB is -12 dB
+    CHECK (levelsMatch (target[0], 0.5f));
+    CHECK (levelsMatch (target[2], 0.25f));
+    CHECK (present[3] == 1.0f);
+
+    // Index 6 has no data, so from index 5 on the guide takes over
+    CHECK (present[4] == 0.0f);
+    CHECK (target[4] == 0.3f);
+}
@@ -0,0 +1,189 @@
+#include <PluginProcessor.h>
+#include <SyntheticPlayHead.h>
+#include <TransportTracker.h>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    // Records seconds of a steady tone into the active slot, starting at ppq 0
+    void recordGhost (PluginProcessor& plugin, SyntheticPlayHead& playHead, double seconds)
+    {
+        juce::AudioBuffer<float> buffer (plugin.getTotalNumInputChannels(), blockSize);
+        juce::MidiBuffer midi;
+
+        playHead.jumpTo (0.0);
+        plugin.isGhostRecording.store (true);
+
+        for (int block = 0; block < (int) (seconds * sampleRate) / blockSize; ++block)
+        {
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                for (int i = 0; i < blockSize; ++i)
+                    buffer.setSample (ch, i, 0.3f * std::sin ((float) (block * blockSize + i) * 0.05f));
+
+            plugin.processBlock (buffer, midi);
+            playHead.advance (blockSize);
+        }
+
+        plugin.isGhostRecording.store (false);
+    }
+
+    int numIndicesWithData (const GhostMap& map)
+    {
+        int count = 0;
+
+        for (int index = 0; index < 64 * GhostMap::pageSize; ++index)
+            if (map.readCode (0, index) != GhostCodec::noDataCode)
+                ++count;
+
+        return count;
+    }
+}
+
+TEST_CASE ("Ghost grid density follows real time", "[ghost][tempo]")
+{
+    for (auto bpm : { 60.0, 120.0, 300.0 })
+    {
+        PluginProcessor plugin;
+        SyntheticPlayHead playHead;
+        playHead.sampleRate = sampleRate;
+        playHead.bpm = bpm;
+        plugin.setPlayHead (&playHead);
+        plugin.setNonRealtime (true);
+        plugin.prepareToPlay (sampleRate, blockSize);
+
+        recordGhost (plugin, playHead, 4.0);
+        plugin.setPlayHead (nullptr);
+
+        const auto& map = *plugin.ghostLibrary.getSlot (0);
+        CHECK (map.getResolution() == GhostMap::resolutionFor (bpm));
+
+        // Four seconds is about four thousand indices, whatever the tempo
+        const auto written = numIndicesWithData (map);
+        CHECK (written > 3900);
+        CHECK (written < 4100);
+    }
+}
+
+TEST_CASE ("A Ghost keeps the grid it was recorded on", "[ghost][tempo]")
+{
+    CHECK (GhostMap::resolutionFor (120.0) == GhostMap::legacyResolution);
+    CHECK (GhostMap::resolutionFor (60.0) == 1000.0);
+    CHECK (GhostMap::resolutionFor (0.0) == GhostMap::legacyResolution);
+    CHECK (GhostMap::resolutionFor (1.0) == GhostMap::maxResolution);
+
+    PluginProcessor plugin;
+    SyntheticPlayHead playHead;
+    playHead.sampleRate = sampleRate;
+    playHead.bpm = 100.0;
+    plugin.setPlayHead (&playHead);
+    plugin.setNonRealtime (true);
+    plugin.prepareToPlay (sampleRate, blockSize);
+
+    recordGhost (plugin, playHead, 1.0);
+    auto& map = *plugin.ghostLibrary.getSlot (0);
+    CHECK (map.getResolution() == 600.0);
+
+    SECTION ("overdubbing at another tempo")
+    {
+        playHead.bpm = 150.0;
+        recordGhost (plugin, playHead, 1.0);
+        CHECK (map.getResolution() == 600.0);
+    }
+
+    SECTION ("through the plugin state")
+    {
+        juce::MemoryBlock state;
+        plugin.getStateInformation (state);
+
+        PluginProcessor restored;
+        restored.setStateInformation (state.getData(), (int) state.getSize());
+        CHECK (restored.ghostLibrary.getSlot (0)->getResolution() == 600.0);
+    }
+
+    SECTION ("until it's cleared")
+    {
+        map.clear();
+        CHECK (map.getResolution() == 0.0);
+
+        playHead.bpm = 150.0;
+        recordGhost (plugin, playHead, 1.0);
+        CHECK (map.getResolution() == 400.0);
+    }
+
+    plugin.setPlayHead (nullptr);
+}
+
+TEST_CASE ("A Ghost state from before the adaptive grid loads on the old grid", "[ghost][tempo][state]")
+{
+    GhostMap map;
+    map.claimResolution (600.0);
+    map.allocateRange (0, 10);
+    map.write (0, 5, 0.5f);
+
+    juce::MemoryOutputStream state;
+    map.writeState (state);
+
+    // The same state as version 1 wrote it: no resolution after the header
+    juce::MemoryOutputStream legacy;
+    legacy.writeInt (1);
+    legacy.write (static_cast<const char*> (state.getData()) + 4, 8);
+    legacy.write (static_cast<const char*> (state.getData()) + 20, state.getDataSize() - 20);
+
+    GhostMap loaded;
+    REQUIRE (loaded.readState (legacy.getData(), legacy.getDataSize()));
+    CHECK (loaded.getResolution() == GhostMap::legacyResolution);
+    CHECK (loaded.read (0, 5) > 0.49f);
+}
+
+TEST_CASE ("The Ghost clock interpolates tempo ramps between playhead updates", "[ghost][tempo]")
+{
+    // Accelerating from 90 to 150 BPM over ten seconds
+    SyntheticPlayHead playHead;
+    playHead.sampleRate = sampleRate;
+    playHead.bpm = 90.0;
+    playHead.bpmPerSecond = 6.0;
+
+    TransportTracker tracker;
+    double worstStepped = 0.0, worstInterpolated = 0.0;
+
+    EngineStages::GhostClock previous;
+
+    for (int block = 0; block < (int) (10.0 * sampleRate) / blockSize; ++block)
+    {
+        TransportTracker::Position position;
+        position.bpm = playHead.bpm;
+        position.ppq = playHead.ppqPosition;
+        position.hasPPQ = true;
+        position.isPlaying = true;
+
+        const auto events = tracker.update (position, blockSize, sampleRate);
+        CHECK_FALSE (events.discontinuity() && block > 0);
+
+        EngineStages::GhostClock clock;
+        clock.startPPQ = position.ppq;
+        clock.ppqPerSample = (position.bpm / 60.0) / sampleRate;
+        clock.ppqPerSampleRamp = events.bpmPerSample / 60.0 / sampleRate;
+        clock.ppqResolution = GhostMap::resolutionFor (90.0);
+
+        // Where the last block's clock put this block's first sample, against where the host says it is
+        if (block > 1)
+        {
+            auto stepped = previous;
+            stepped.ppqPerSampleRamp = 0.0;
+
+            worstStepped = std::max (worstStepped, std::abs (stepped.ppqAt (blockSize) - position.ppq) * clock.ppqResolution);
+            worstInterpolated = std::max (worstInterpolated, std::abs (previous.ppqAt (blockSize) - position.ppq) * clock.ppqResolution);
+        }
+
+        previous = clock;
+        playHead.advance (blockSize);
+    }
+
+    // Without interpolation each block falls a little short of where the next one starts
+    CHECK (worstStepped > 0.001);
+    CHECK (worstInterpolated < worstStepped * 1.0e-3);
+}
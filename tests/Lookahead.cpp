@@ -0,0 +1,208 @@
+#include <PluginProcessor.h>
+#include <SlidingMax.h>
+#include <SyntheticPlayHead.h>
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+    constexpr int blockSize = 256;
+
+    // Rides a quiet live tone that jumps 34 dB louder halfway through against a steady
+    // sidechain guide, and returns the loudest output sample after the jump
+    float peakAfterOnset (bool lookahead)
+    {
+        PluginProcessor plugin;
+        SyntheticPlayHead playHead;
+        playHead.sampleRate = 48000.0;
+        playHead.playing = true;
+        plugin.setPlayHead (&playHead);
+        plugin.setLookaheadEnabled (lookahead);
+        plugin.prepareToPlay (playHead.sampleRate, blockSize);
+
+        plugin.parameters.mode = 1;
+        plugin.parameters.externalSidechain = true;
+
+        juce::AudioBuffer<float> buffer (plugin.getTotalNumInputChannels(), blockSize);
+        juce::MidiBuffer midi;
+        const int onset = 100 * blockSize;
+        float peak = 0.0f;
+
+        for (int block = 0; block < 140; ++block)
+        {
+            for (int i = 0; i < blockSize; ++i)
+            {
+                const auto n = block * blockSize + i;
+                const auto phase = juce::MathConstants<float>::twoPi * 220.0f * (float) n / 48000.0f;
+
+                for (int ch = 0; ch < 2; ++ch)
+                {
+                    buffer.setSample (ch, i, (n < onset ? 0.01f : 0.5f) * std::sin (phase));
+                    buffer.setSample (ch + 2, i, 0.1f * std::sin (phase));
+                }
+            }
+
+            plugin.processBlock (buffer, midi);
+            playHead.advance (blockSize);
+
+            if (block * blockSize >= onset)
+                peak = std::max (peak, buffer.getMagnitude (0, 0, blockSize));
+        }
+
+        plugin.setPlayHead (nullptr);
+        return peak;
+    }
+
+    // Rides a steady live level against a guide that steps up at onset, and returns the
+    // first output sample the fader moved on
+    int firstMoveAfterGuideStep (bool lookahead, int onset)
+    {
+        PluginProcessor plugin;
+        SyntheticPlayHead playHead;
+        playHead.sampleRate = 48000.0;
+        playHead.playing = true;
+        plugin.setPlayHead (&playHead);
+        plugin.setLookaheadEnabled (lookahead);
+        plugin.prepareToPlay (playHead.sampleRate, blockSize);
+
+        plugin.parameters.mode = 1;
+        plugin.parameters.externalSidechain = true;
+
+        juce::AudioBuffer<float> buffer (plugin.getTotalNumInputChannels(), blockSize);
+        juce::MidiBuffer midi;
+        std::vector<float> output;
+
+        for (int block = 0; block < 2 * onset / blockSize; ++block)
+        {
+            for (int i = 0; i < blockSize; ++i)
+            {
+                for (int ch = 0; ch < 2; ++ch)
+                {
+                    buffer.setSample (ch, i, 0.1f);
+                    buffer.setSample (ch + 2, i, block * blockSize + i < onset ? 0.05f : 0.2f);
+                }
+            }
+
+            plugin.processBlock (buffer, midi);
+            playHead.advance (blockSize);
+            output.insert (output.end(), buffer.getReadPointer (0), buffer.getReadPointer (0) + blockSize);
+        }
+
+        plugin.setPlayHead (nullptr);
+
+        for (int i = onset / 2; i < (int) output.size(); ++i)
+            if (std::abs (output[(size_t) i] - output[(size_t) onset / 2]) > 1.0e-6f)
+                return i;
+
+        return -1;
+    }
+}
+
+TEST_CASE ("Sliding max matches a brute force scan", "[lookahead]")
+{
+    std::mt19937 random (7);
+    std::uniform_real_distribution<float> levels (0.0f, 1.0f);
+
+    std::vector<float> noise (2000), falling (2000);
+    for (size_t i = 0; i < noise.size(); ++i)
+    {
+        noise[i] = levels (random);
+        falling[i] = 1.0f - (float) i / (float) falling.size(); // keeps every sample in the deque
+    }
+
+    // { size prepared for, window }: a window as big as the prepared size fills the deque
+    const std::pair<int, int> sizes[] { { 240, 1 }, { 240, 2 }, { 240, 5 }, { 240, 37 }, { 240, 64 }, { 240, 240 }, { 4, 4 }, { 256, 256 } };
+
+    for (const auto* in : { &noise, &falling })
+    {
+        for (const auto& [prepared, window] : sizes)
+        {
+            SlidingMax slidingMax;
+            slidingMax.prepare (prepared);
+            slidingMax.setWindowSize (window);
+            REQUIRE (slidingMax.getWindowSize() == window);
+
+            std::vector<float> out (in->size());
+            slidingMax.process (in->data(), out.data(), (int) in->size());
+
+            int numWrong = 0;
+
+            for (size_t i = 0; i < in->size(); ++i)
+            {
+                const auto first = i >= (size_t) window ? i + 1 - (size_t) window : 0;
+                numWrong += out[i] == *std::max_element (in->begin() + (long) first, in->begin() + (long) i + 1) ? 0 : 1;
+            }
+
+            INFO ((in == &noise ? "noise" : "falling") << ", prepared " << prepared << ", window " << window);
+            CHECK (numWrong == 0);
+        }
+    }
+}
+
+TEST_CASE ("Lookahead reports its latency", "[lookahead]")
+{
+    PluginProcessor plugin;
+    plugin.prepareToPlay (48000.0, 512);
+    CHECK (plugin.getLatencySamples() == 0);
+
+    plugin.setLookaheadEnabled (true);
+    CHECK (plugin.getLatencySamples() == 240);
+
+    plugin.prepareToPlay (96000.0, 512);
+    CHECK (plugin.getLatencySamples() == 480);
+
+    plugin.setLookaheadEnabled (false);
+    CHECK (plugin.getLatencySamples() == 0);
+}
+
+TEST_CASE ("Lookahead survives the plugin state", "[lookahead][state]")
+{
+    PluginProcessor original;
+    original.prepareToPlay (48000.0, 512);
+    original.setLookaheadEnabled (true);
+
+    juce::MemoryBlock state;
+    original.getStateInformation (state);
+
+    PluginProcessor restored;
+    restored.prepareToPlay (48000.0, 512);
+    restored.setStateInformation (state.getData(), (int) state.getSize());
+    CHECK (restored.isLookaheadEnabled());
+    CHECK (restored.getLatencySamples() == 240);
+
+    // And a state saved without it switches it off again
+    original.setLookaheadEnabled (false);
+    original.getStateInformation (state);
+    restored.setStateInformation (state.getData(), (int) state.getSize());
+    CHECK_FALSE (restored.isLookaheadEnabled());
+    CHECK (restored.getLatencySamples() == 0);
+}
+
+TEST_CASE ("Lookahead rides onsets without overshoot", "[lookahead]")
+{
+    // The guide sits at 0.1 throughout, so a perfect ride never gets much past that
+    const auto withoutLookahead = peakAfterOnset (false);
+    const auto withLookahead = peakAfterOnset (true);
+
+    INFO ("peak without lookahead " << withoutLookahead << ", with " << withLookahead);
+    CHECK (withLookahead < 0.15f);
+    CHECK (withLookahead < withoutLookahead * 0.5f);
+}
+
+TEST_CASE ("Lookahead delays the guide along with the input", "[lookahead]")
+{
+    // The step lands mid-block, and the fader has long settled before it
+    const int onset = 200 * blockSize + 77;
+    const auto latency = juce::roundToInt (0.005 * 48000.0);
+
+    const auto direct = firstMoveAfterGuideStep (false, onset);
+    const auto delayed = firstMoveAfterGuideStep (true, onset);
+
+    INFO ("direct " << direct << ", delayed " << delayed);
+    CHECK (direct >= onset);
+    CHECK (direct <= onset + 2);
+    CHECK (delayed - direct == latency);
+}
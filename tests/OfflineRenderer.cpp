@@ -0,0 +1,176 @@
+#include "helpers/render_helpers.h"
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+    // What a host would print: the stereo signal through processBlock in blocks of blockSize, from the top
+    juce::AudioBuffer<float> processDirectly (const juce::AudioBuffer<float>& signal, const OfflineRenderer::Settings& settings, int extraSamples = 0)
+    {
+        PluginProcessor plugin;
+        SyntheticPlayHead playHead;
+        playHead.sampleRate = renderSampleRate;
+        playHead.bpm = settings.bpm;
+
+        plugin.parameters.mode = settings.mode;
+        plugin.parameters.ratio = 1; // 3:1
+        plugin.setLookaheadEnabled (settings.lookahead);
+        plugin.setPlayHead (&playHead);
+        plugin.setNonRealtime (true);
+        plugin.prepareToPlay (renderSampleRate, settings.blockSize);
+
+        const auto length = signal.getNumSamples() + extraSamples;
+        juce::AudioBuffer<float> output (2, length);
+        juce::MidiBuffer midi;
+
+        for (int start = 0; start < length; start += settings.blockSize)
+        {
+            const auto n = std::min (settings.blockSize, length - start);
+            juce::AudioBuffer<float> block (plugin.getTotalNumInputChannels(), n);
+            block.clear();
+
+            for (int ch = 0; ch < 2; ++ch)
+                if (start < signal.getNumSamples())
+                    block.copyFrom (ch, 0, signal, ch, start, std::min (n, signal.getNumSamples() - start));
+
+            plugin.processBlock (block, midi);
+            playHead.advance (n);
+
+            for (int ch = 0; ch < 2; ++ch)
+                output.copyFrom (ch, start, block, ch, 0, n);
+        }
+
+        plugin.setPlayHead (nullptr);
+        return output;
+    }
+}
+
+TEST_CASE ("An offline render matches processBlock", "[render]")
+{
+    const auto signal = makeSignal (2, 4.0, 220.0);
+    const auto input = writeWav (signal, 32, true);
+    const auto output = tempFile ("offline-render-out");
+
+    OfflineRenderer renderer;
+    OfflineRenderer::Job job { input, {}, output, {} };
+    job.settings.bpm = 96.0;
+    job.settings.ratio = 3;
+    job.settings.blockSize = 3000; // not a divisor of the length: the last block is short
+
+    SECTION ("in blocks, sample for sample")
+    {
+        REQUIRE (renderer.render (job).wasOk());
+        CHECK (renderer.getLastLengthInSamples() == signal.getNumSamples());
+
+        const auto rendered = readWav (output);
+        REQUIRE (rendered.getNumChannels() == 2);
+        REQUIRE (rendered.getNumSamples() == signal.getNumSamples());
+
+        const auto expected = processDirectly (signal, job.settings);
+        CHECK (maxDifference (expected, 0, rendered, signal.getNumSamples()) == 0.0f);
+    }
+
+    SECTION ("with lookahead, lined up with the input")
+    {
+        job.settings.lookahead = true;
+        REQUIRE (renderer.render (job).wasOk());
+
+        const auto rendered = readWav (output);
+        REQUIRE (rendered.getNumSamples() == signal.getNumSamples());
+
+        const auto latency = (int) std::lround (PluginProcessor::lookaheadSeconds * renderSampleRate);
+        const auto expected = processDirectly (signal, job.settings, latency);
+        CHECK (maxDifference (expected, latency, rendered, signal.getNumSamples()) == 0.0f);
+    }
+
+    SECTION ("one renderer, many files")
+    {
+        REQUIRE (renderer.render (job).wasOk());
+        const auto first = readWav (output);
+
+        // Something different in between must leave nothing behind
+        auto other = job;
+        other.settings.mode = 3;
+        other.settings.shredMode = 2;
+        other.settings.chopThreshold = 0.3f;
+        other.settings.lookahead = true;
+        REQUIRE (renderer.render (other).wasOk());
+
+        REQUIRE (renderer.render (job).wasOk());
+        CHECK (maxDifference (first, 0, readWav (output), signal.getNumSamples()) == 0.0f);
+    }
+
+    input.deleteFile();
+    output.deleteFile();
+}
+
+TEST_CASE ("An offline render keeps the file's format and takes a sidechain", "[render]")
+{
+    const auto signal = makeSignal (1, 3.0, 330.0);
+    const auto input = writeWav (signal, 24, false);
+    const auto output = tempFile ("offline-render-out");
+
+    OfflineRenderer renderer;
+    OfflineRenderer::Job job { input, {}, output, {} };
+
+    REQUIRE (renderer.render (job).wasOk());
+
+    {
+        auto reader = openWav (output);
+        REQUIRE (reader != nullptr);
+        CHECK (reader->numChannels == 1);
+        CHECK (reader->bitsPerSample == 24);
+        CHECK_FALSE (reader->usesFloatingPointData);
+        CHECK (reader->sampleRate == renderSampleRate);
+        CHECK (reader->lengthInSamples == signal.getNumSamples());
+    }
+
+    const auto internal = readWav (output);
+
+    SECTION ("a sidechain guides the ride")
+    {
+        // A guide that's shorter than the input, so the end is ridden to silence
+        const auto sidechain = writeWav (makeSignal (2, 1.5, 110.0), 32, true);
+        job.sidechain = sidechain;
+
+        REQUIRE (renderer.render (job).wasOk());
+        const auto external = readWav (output);
+
+        REQUIRE (external.getNumSamples() == signal.getNumSamples());
+        CHECK (maxDifference (internal, 0, external, signal.getNumSamples()) > 0.01f);
+
+        sidechain.deleteFile();
+    }
+
+    SECTION ("refuses what it can't render and leaves the output alone")
+    {
+        const auto text = juce::File::getSpecialLocation (juce::File::tempDirectory).getNonexistentChildFile ("not-audio", ".wav");
+        text.replaceWithText ("definitely not audio");
+
+        auto bad = job;
+        bad.input = text;
+        CHECK (renderer.render (bad).failed());
+
+        bad = job;
+        bad.sidechain = input.getSiblingFile ("missing.wav");
+        CHECK (renderer.render (bad).failed());
+
+        bad = job;
+        bad.settings.bpm = 0.0;
+        CHECK (renderer.render (bad).failed());
+
+        bad = job;
+        bad.settings.ratio = 4;
+        CHECK (renderer.render (bad).failed());
+
+        bad = job;
+        bad.settings.chopThreshold = 0.9f;
+        CHECK (renderer.render (bad).failed());
+
+        CHECK (maxDifference (internal, 0, readWav (output), signal.getNumSamples()) == 0.0f);
+
+        text.deleteFile();
+    }
+
+    input.deleteFile();
+    output.deleteFile();
+}
@@ -0,0 +1,116 @@
+#include <PluginProcessor.h>
+#include <PluginState.h>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+
+TEST_CASE ("Parameter snapshot", "[parameters]")
+{
+    PluginProcessor plugin;
+    auto& parameters = plugin.parameters;
+
+    SECTION ("starts at the defaults")
+    {
+        const auto snapshot = parameters.snapshot();
+        CHECK (snapshot.mode == 0);
+        CHECK (snapshot.ratio == 1);
+        CHECK (snapshot.shredMode == 1);
+        CHECK (snapshot.chopThreshold == 0.10f);
+        CHECK_FALSE (snapshot.flip);
+        CHECK_FALSE (snapshot.shred);
+        CHECK_FALSE (snapshot.chop);
+        CHECK_FALSE (snapshot.externalSidechain);
+    }
+
+    SECTION ("follows every parameter")
+    {
+        parameters.mode = 3;
+        parameters.ratio = 3;
+        parameters.shredMode = 2;
+        parameters.chopThreshold = 0.42f;
+        parameters.flip = true;
+        parameters.shred = true;
+        parameters.chop = true;
+        parameters.externalSidechain = true;
+
+        const auto snapshot = parameters.snapshot();
+        CHECK (snapshot.mode == 3);
+        CHECK (snapshot.ratio == 9);
+        CHECK (snapshot.shredMode == 3);
+        CHECK (snapshot.chopThreshold == parameters.chopThreshold.get());
+        CHECK (snapshot.flip);
+        CHECK (snapshot.shred);
+        CHECK (snapshot.chop);
+        CHECK (snapshot.externalSidechain);
+    }
+
+    SECTION ("follows host automation")
+    {
+        plugin.getParameters()[0]->setValueNotifyingHost (1.0f);
+        CHECK (parameters.snapshot().mode == 3);
+
+        auto* ratio = plugin.parameters.tree.getParameter (PluginParameters::ratioID.getParamID());
+        ratio->setValueNotifyingHost (ratio->convertTo0to1 (2.0f));
+        CHECK (parameters.snapshot().ratio == 6);
+    }
+
+    SECTION ("is lock-free")
+    {
+        CHECK (std::atomic<std::uint64_t>::is_always_lock_free);
+    }
+}
+
+TEST_CASE ("Parameters are recalled with the session", "[parameters][state]")
+{
+    PluginProcessor plugin;
+    plugin.parameters.mode = 2;
+    plugin.parameters.ratio = 2;
+    plugin.parameters.chopThreshold = 0.33f;
+    plugin.parameters.externalSidechain = true;
+
+    juce::MemoryBlock state;
+    plugin.getStateInformation (state);
+
+    SECTION ("into a new instance")
+    {
+        PluginProcessor restored;
+        restored.setStateInformation (state.getData(), (int) state.getSize());
+
+        const auto snapshot = restored.parameters.snapshot();
+        CHECK (snapshot.mode == 2);
+        CHECK (snapshot.ratio == 6);
+        CHECK (snapshot.chopThreshold == plugin.parameters.chopThreshold.get());
+        CHECK (snapshot.externalSidechain);
+        CHECK_FALSE (snapshot.flip);
+    }
+
+    SECTION ("over an instance that was changed since")
+    {
+        plugin.parameters.flip = true;
+        plugin.parameters.mode = 0;
+        plugin.setStateInformation (state.getData(), (int) state.getSize());
+
+        CHECK (plugin.parameters.snapshot().mode == 2);
+        CHECK_FALSE (plugin.parameters.snapshot().flip);
+    }
+
+    SECTION ("a session from before the parameters existed loads the defaults")
+    {
+        juce::MemoryOutputStream legacy;
+        PluginState::writeHeader (legacy);
+
+        plugin.setStateInformation (legacy.getData(), (int) legacy.getDataSize());
+        CHECK (plugin.parameters.snapshot().mode == 0);
+        CHECK (plugin.parameters.snapshot().ratio == 1);
+        CHECK (std::abs (plugin.parameters.snapshot().chopThreshold - 0.10f) < 1.0e-6f);
+        CHECK_FALSE (plugin.parameters.snapshot().externalSidechain);
+    }
+
+    SECTION ("only the parameters that were moved are stored")
+    {
+        PluginProcessor untouched;
+        juce::MemoryBlock untouchedState;
+        untouched.getStateInformation (untouchedState);
+
+        CHECK (untouchedState.getSize() < state.getSize());
+    }
+}
@@ -0,0 +1,511 @@
+#include "helpers/clap_helpers.h"
+#include "helpers/test_helpers.h"
+#include <PluginProcessor.h>
+#include <SyntheticPlayHead.h>
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+    #include <dlfcn.h>
+    #include <malloc.h>
+    #include <pthread.h>
+#endif
+
+// ==========================================================
+// ALLOCATION & LOCK HOOKS
+// ==========================================================
+// Global operator new/delete are replaced for the whole Tests executable. On
+// glibc, malloc and friends plus pthread_mutex_lock are interposed as well, which
+// also catches juce::CriticalSection, std::mutex and anything a library does
+// behind our back. The hooks only count on a thread that is currently inside a
+// RealtimeScope, so the rest of the test run (and JUCE's own threads) are unaffected.
+namespace
+{
+    struct RealtimeViolations
+    {
+        int allocations { 0 };
+        int deallocations { 0 };
+        int locks { 0 };
+
+        bool any() const noexcept { return allocations + deallocations + locks > 0; }
+    };
+
+    thread_local bool realtimeArmed = false;
+    thread_local RealtimeViolations violations;
+
+    void noteAllocation() noexcept { if (realtimeArmed) ++violations.allocations; }
+    void noteDeallocation() noexcept { if (realtimeArmed) ++violations.deallocations; }
+    [[maybe_unused]] void noteLock() noexcept { if (realtimeArmed) ++violations.locks; }
+
+    // Everything that happens on this thread while one of these is alive counts as audio thread work
+    struct RealtimeScope
+    {
+        RealtimeScope() noexcept { violations = {}; realtimeArmed = true; }
+        ~RealtimeScope() noexcept { realtimeArmed = false; }
+    };
+
+    void* allocate (std::size_t size) noexcept
+    {
+        noteAllocation();
+        return std::malloc (size > 0 ? size : 1);
+    }
+
+    void* allocateAligned (std::size_t size, std::align_val_t alignment) noexcept
+    {
+        noteAllocation();
+       #if JUCE_WINDOWS
+        return _aligned_malloc (size > 0 ? size : 1, (std::size_t) alignment);
+       #else
+        void* ptr = nullptr;
+        return posix_memalign (&ptr, std::max ((std::size_t) alignment, sizeof (void*)), size > 0 ? size : 1) == 0 ? ptr : nullptr;
+       #endif
+    }
+
+    void release (void* ptr) noexcept
+    {
+        if (ptr == nullptr)
+            return;
+
+        noteDeallocation();
+        std::free (ptr);
+    }
+
+    void releaseAligned (void* ptr) noexcept
+    {
+        if (ptr == nullptr)
+            return;
+
+        noteDeallocation();
+       #if JUCE_WINDOWS
+        _aligned_free (ptr);
+       #else
+        std::free (ptr);
+       #endif
+    }
+}
+
+void* operator new (std::size_t size)
+{
+    if (auto* ptr = allocate (size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size) { return operator new (size); }
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept { return allocate (size); }
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept { return allocate (size); }
+
+void* operator new (std::size_t size, std::align_val_t alignment)
+{
+    if (auto* ptr = allocateAligned (size, alignment))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size, std::align_val_t alignment) { return operator new (size, alignment); }
+void* operator new (std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocateAligned (size, alignment); }
+void* operator new[] (std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocateAligned (size, alignment); }
+
+void operator delete (void* ptr) noexcept { release (ptr); }
+void operator delete[] (void* ptr) noexcept { release (ptr); }
+void operator delete (void* ptr, std::size_t) noexcept { release (ptr); }
+void operator delete[] (void* ptr, std::size_t) noexcept { release (ptr); }
+void operator delete (void* ptr, const std::nothrow_t&) noexcept { release (ptr); }
+void operator delete[] (void* ptr, const std::nothrow_t&) noexcept { release (ptr); }
+void operator delete (void* ptr, std::align_val_t) noexcept { releaseAligned (ptr); }
+void operator delete[] (void* ptr, std::align_val_t) noexcept { releaseAligned (ptr); }
+void operator delete (void* ptr, std::size_t, std::align_val_t) noexcept { releaseAligned (ptr); }
+void operator delete[] (void* ptr, std::size_t, std::align_val_t) noexcept { releaseAligned (ptr); }
+
+#if defined(__GLIBC__)
+extern "C"
+{
+    // glibc's own allocator entry points, so the interposers below can forward without dlsym
+    void* __libc_malloc (size_t);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+    void* __libc_memalign (size_t, size_t);
+    void __libc_free (void*);
+
+    void* malloc (size_t size) noexcept                       { noteAllocation(); return __libc_malloc (size); }
+    void* calloc (size_t count, size_t size) noexcept         { noteAllocation(); return __libc_calloc (count, size); }
+    void* realloc (void* ptr, size_t size) noexcept           { noteAllocation(); return __libc_realloc (ptr, size); }
+    void* memalign (size_t alignment, size_t size) noexcept   { noteAllocation(); return __libc_memalign (alignment, size); }
+    void* aligned_alloc (size_t alignment, size_t size) noexcept { noteAllocation(); return __libc_memalign (alignment, size); }
+
+    int posix_memalign (void** result, size_t alignment, size_t size) noexcept
+    {
+        noteAllocation();
+
+        if (auto* ptr = __libc_memalign (alignment, size))
+        {
+            *result = ptr;
+            return 0;
+        }
+
+        return ENOMEM;
+    }
+
+    void free (void* ptr) noexcept
+    {
+        if (ptr != nullptr)
+            noteDeallocation();
+
+        __libc_free (ptr);
+    }
+
+    int pthread_mutex_lock (pthread_mutex_t* mutex) noexcept
+    {
+        using LockFunction = int (*) (pthread_mutex_t*);
+        static std::atomic<LockFunction> realLock { nullptr };
+
+        auto lock = realLock.load (std::memory_order_acquire);
+
+        if (lock == nullptr)
+        {
+            lock = reinterpret_cast<LockFunction> (dlsym (RTLD_NEXT, "pthread_mutex_lock"));
+            realLock.store (lock, std::memory_order_release);
+        }
+
+        noteLock();
+        return lock (mutex);
+    }
+}
+#endif
+
+// ==========================================================
+// THE TESTS
+// ==========================================================
+namespace
+{
+    struct EngineConfig
+    {
+        int mode;
+        bool flip;
+        int shred; // 0 = off, 1..3 = SHRED I..III
+        bool chop;
+        int ghost; // 0 = off, 1 = record, 2 = read
+        bool externalSidechain;
+
+        juce::String describe() const
+        {
+            return "mode " + juce::String (mode) + (flip ? " FLIP" : "") + (shred > 0 ? " SHRED " + juce::String (shred) : "")
+                   + (chop ? " CHOP" : "") + (ghost == 1 ? " ghost-record" : (ghost == 2 ? " ghost-read" : ""))
+                   + (externalSidechain ? " EXT" : " INT");
+        }
+    };
+
+    void applyConfig (PluginProcessor& plugin, const EngineConfig& config)
+    {
+        plugin.parameters.mode = config.mode;
+        plugin.parameters.ratio = 1; // 3:1
+        plugin.parameters.flip = config.flip;
+        plugin.parameters.shred = config.shred > 0;
+        plugin.parameters.shredMode = juce::jmax (1, config.shred) - 1;
+        plugin.parameters.chop = config.chop;
+        plugin.isGhostRecording.store (config.ghost == 1);
+        plugin.isGhostReading.store (config.ghost == 2);
+        plugin.parameters.externalSidechain = config.externalSidechain;
+    }
+
+    void fillTestSignal (juce::AudioBuffer<float>& buffer, int blockIndex)
+    {
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        {
+            // main bus on channels 0/1, sidechain on 2/3, each with its own pitch and level
+            const auto frequency = (ch < 2) ? 220.0f : 330.0f;
+            const auto level = (ch < 2) ? 0.5f : 0.25f * (1.0f + (float) (blockIndex % 4));
+
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                const auto n = (float) (blockIndex * buffer.getNumSamples() + i);
+                buffer.setSample (ch, i, level * std::sin (juce::MathConstants<float>::twoPi * frequency * n / 48000.0f));
+            }
+        }
+    }
+
+    // A plugin on the audio-thread path at 48 kHz, with Ghost pages under the whole script so
+    // record and read really touch the map
+    struct RealtimeRig
+    {
+        explicit RealtimeRig (int blockSize)
+        {
+            plugin.setPlayHead (&playHead);
+            plugin.setNonRealtime (false);
+            plugin.prepareToPlay (playHead.sampleRate, blockSize);
+            plugin.ghostLibrary.editActiveSlot().allocateRange (0, scriptEndIndex());
+        }
+
+        ~RealtimeRig() { plugin.setPlayHead (nullptr); }
+
+        // Comfortably past the last quarter runScript reaches, on the grid the Ghost is recorded at
+        int scriptEndIndex() const { return (int) std::ceil (10.0 * GhostMap::resolutionFor (playHead.bpm)); }
+
+        PluginProcessor plugin;
+        SyntheticPlayHead playHead;
+    };
+
+    // Runs a short transport script (play, loop back, stop, restart) and reports what the audio thread did
+    RealtimeViolations runScript (PluginProcessor& plugin, SyntheticPlayHead& playHead, int blockSize)
+    {
+        juce::AudioBuffer<float> buffer (plugin.getTotalNumInputChannels(), blockSize);
+        juce::MidiBuffer midi;
+        RealtimeViolations total;
+
+        playHead.jumpTo (4.0);
+        playHead.playing = true;
+
+        for (int block = 0; block < 24; ++block)
+        {
+            if (block == 12)
+                playHead.jumpTo (4.0);
+
+            playHead.playing = (block < 16 || block >= 20);
+            fillTestSignal (buffer, block);
+
+            {
+                RealtimeScope scope;
+                plugin.processBlock (buffer, midi);
+                total.allocations += violations.allocations;
+                total.deallocations += violations.deallocations;
+                total.locks += violations.locks;
+            }
+
+            playHead.advance (blockSize);
+        }
+
+        return total;
+    }
+}
+
+TEST_CASE ("Real-time safety hooks", "[realtime]")
+{
+    SECTION ("catch allocations")
+    {
+        RealtimeViolations seen;
+        {
+            RealtimeScope scope;
+            auto* leaked = new std::vector<float> (16);
+            delete leaked;
+
+            void* volatile raw = std::malloc (64);
+            std::free (raw);
+            seen = violations;
+        }
+
+        CHECK (seen.allocations >= 3);
+        CHECK (seen.deallocations >= 3);
+    }
+
+   #if defined(__GLIBC__)
+    SECTION ("catch locks")
+    {
+        juce::CriticalSection lock;
+        RealtimeViolations seen;
+        {
+            RealtimeScope scope;
+            const juce::ScopedLock sl (lock);
+            seen = violations;
+        }
+
+        CHECK (seen.locks > 0);
+    }
+   #endif
+}
+
+TEST_CASE ("processBlock is real-time safe", "[realtime]")
+{
+    for (const int blockSize : { 32, 512 })
+    {
+        RealtimeRig rig (blockSize);
+
+        for (int mode = 0; mode < 4; ++mode)
+            for (const bool flip : { false, true })
+                for (int shred = 0; shred <= 3; ++shred)
+                    for (const bool chop : { false, true })
+                        for (int ghost = 0; ghost <= 2; ++ghost)
+                            for (const bool external : { false, true })
+                            {
+                                const EngineConfig config { mode, flip, shred, chop, ghost, external };
+                                applyConfig (rig.plugin, config);
+
+                                const auto seen = runScript (rig.plugin, rig.playHead, blockSize);
+
+                                INFO ("block size " << blockSize << ", " << config.describe().toStdString());
+                                CHECK (seen.allocations == 0);
+                                CHECK (seen.deallocations == 0);
+                                CHECK (seen.locks == 0);
+                            }
+    }
+}
+
+TEST_CASE ("Predictive Ghost replay is real-time safe", "[realtime][lookahead]")
+{
+    for (int mode = 0; mode < 4; ++mode)
+    {
+        RealtimeRig rig (512);
+        auto& plugin = rig.plugin;
+
+        applyConfig (plugin, { mode, false, 0, false, 1, false });
+        runScript (plugin, rig.playHead, 512);
+
+        applyConfig (plugin, { mode, false, 0, false, 2, false });
+        plugin.isGhostLookahead.store (true);
+        const auto seen = runScript (plugin, rig.playHead, 512);
+
+        INFO ("mode " << mode);
+        CHECK (seen.allocations == 0);
+        CHECK (seen.deallocations == 0);
+        CHECK (seen.locks == 0);
+    }
+}
+
+TEST_CASE ("Switching Ghost slots is real-time safe", "[realtime][ghost]")
+{
+    RealtimeRig rig (512); // the pages are in slot 0, the active one
+    auto& plugin = rig.plugin;
+    auto& playHead = rig.playHead;
+
+    // Recording into an empty slot only asks the pager for storage
+    plugin.ghostLibrary.selectSlot (1);
+    applyConfig (plugin, { 1, false, 0, false, 1, false });
+    const auto recording = runScript (plugin, playHead, 512);
+
+    // Reading a slot, then the same slot after it's been cleared under the audio thread
+    plugin.ghostLibrary.selectSlot (0);
+    applyConfig (plugin, { 1, false, 0, false, 2, false });
+    const auto reading = runScript (plugin, playHead, 512);
+
+    plugin.ghostLibrary.clearSlot (0);
+    const auto cleared = runScript (plugin, playHead, 512);
+
+    CHECK_FALSE (recording.any());
+    CHECK_FALSE (reading.any());
+    CHECK_FALSE (cleared.any());
+}
+
+TEST_CASE ("Lookahead processBlock is real-time safe", "[realtime][lookahead]")
+{
+    RealtimeRig rig (512);
+    auto& plugin = rig.plugin;
+    auto& playHead = rig.playHead;
+    plugin.setLookaheadEnabled (true);
+
+    for (int mode = 0; mode < 4; ++mode)
+        for (int ghost = 0; ghost <= 2; ++ghost)
+        {
+            applyConfig (plugin, { mode, false, 2, true, ghost, true });
+
+            // Switching it off and on again restarts the delay on the audio thread
+            plugin.setLookaheadEnabled (ghost != 1);
+            const auto seen = runScript (plugin, playHead, 512);
+
+            INFO ("mode " << mode << ", ghost " << ghost);
+            CHECK (seen.allocations == 0);
+            CHECK (seen.deallocations == 0);
+            CHECK (seen.locks == 0);
+        }
+}
+
+TEST_CASE ("Frozen processBlock is real-time safe", "[realtime][freeze]")
+{
+    RealtimeRig rig (512);
+    auto& plugin = rig.plugin;
+    auto& playHead = rig.playHead;
+
+    // Capture a fader on a read pass first, so the frozen pass really reads the map
+    plugin.frozenGainMap.allocateRange (0, rig.scriptEndIndex());
+    applyConfig (plugin, { 2, false, 0, false, 2, false });
+    runScript (plugin, playHead, 512);
+
+    plugin.isFrozen.store (true);
+    const auto seen = runScript (plugin, playHead, 512);
+
+    CHECK (seen.allocations == 0);
+    CHECK (seen.deallocations == 0);
+    CHECK (seen.locks == 0);
+}
+
+TEST_CASE ("processBlock stays real-time safe past the prepared block size", "[realtime]")
+{
+    RealtimeRig rig (64);
+    applyConfig (rig.plugin, { 2, false, 2, true, 2, true });
+
+    CHECK_FALSE (runScript (rig.plugin, rig.playHead, 1000).any());
+}
+
+TEST_CASE ("CLAP direct process with events is real-time safe", "[realtime][clap]")
+{
+    constexpr int blockSize = 512;
+
+    RealtimeRig rig (blockSize); // the CLAP path takes its transport from the events, not the play head
+    auto& plugin = rig.plugin;
+    auto& playHead = rig.playHead;
+    applyConfig (plugin, { 1, false, 0, true, 1, true });
+
+    juce::AudioBuffer<float> main (2, blockSize), sidechain (2, blockSize);
+    ClapProcessCall call (main, sidechain);
+    auto& parameters = plugin.parameters;
+
+    const auto runBlocks = [&] (bool withParameterEvents) {
+        RealtimeViolations total;
+
+        for (int block = 0; block < 16; ++block)
+        {
+            fillTestSignal (main, block);
+            fillTestSignal (sidechain, block + 1);
+
+            // Every block splits at a relocate, and at a mode switch and a threshold move
+            call.events.clear();
+
+            if (withParameterEvents)
+            {
+                call.events.addParameter (parameters.mode, parameters.mode.convertTo0to1 ((float) (1 + block % 3)), 64);
+                call.events.addParameter (parameters.chopThreshold, parameters.chopThreshold.convertTo0to1 (0.05f * (float) (1 + block % 4)), 200);
+            }
+
+            SyntheticPlayHead relocated = playHead;
+            relocated.jumpTo (4.0);
+            call.events.addTransport (relocated, 333);
+
+            {
+                RealtimeScope scope;
+                call.run (plugin, playHead);
+                total.allocations += violations.allocations;
+                total.deallocations += violations.deallocations;
+                total.locks += violations.locks;
+            }
+
+            playHead.advance (blockSize);
+        }
+
+        return total;
+    };
+
+    SECTION ("splitting at transport events")
+    {
+        CHECK_FALSE (runBlocks (false).any());
+    }
+
+    SECTION ("splitting at parameter events")
+    {
+        // Setting a JUCE parameter takes its uncontended listener lock, as it does under every plugin format
+        const auto seen = runBlocks (true);
+        CHECK (seen.allocations == 0);
+        CHECK (seen.deallocations == 0);
+    }
+
+    SECTION ("writing the ride out, ended by every relocate")
+    {
+        plugin.isRideWriting.store (true);
+        CHECK_FALSE (runBlocks (false).any());
+        CHECK (call.output.numEvents > 0);
+    }
+}
@@ -0,0 +1,260 @@
+#include "helpers/clap_helpers.h"
+#include <RideThinner.h>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    // A ride with slow swells, a few sharp moves and long flat stretches, in dB
+    float rideDb (int sample)
+    {
+        const auto t = (float) sample / 48000.0f;
+
+        if (t < 1.0f) return -3.0f;
+        if (t < 2.0f) return -3.0f - 6.0f * (t - 1.0f);
+        if (t < 2.5f) return -9.0f + 4.0f * std::sin (6.0f * t);
+        if (t < 2.51f) return -20.0f;
+        return -6.0f + 2.0f * std::sin (1.5f * t);
+    }
+
+    struct Breakpoint
+    {
+        std::int64_t time;
+        float gainDb;
+    };
+
+    // Runs numSamples of rideDb through the thinner as one block, in chunks like processBlock
+    std::vector<Breakpoint> thin (RideThinner& thinner, int numSamples, int chunkSize)
+    {
+        std::vector<float> gain ((size_t) chunkSize);
+        std::vector<Breakpoint> breakpoints;
+
+        thinner.beginBlock();
+
+        for (int start = 0; start < numSamples; start += chunkSize)
+        {
+            const auto n = std::min (chunkSize, numSamples - start);
+
+            for (int i = 0; i < n; ++i)
+                gain[(size_t) i] = juce::Decibels::decibelsToGain (rideDb (start + i), -100.0f);
+
+            const float* channels[] { gain.data() };
+            thinner.process (channels, 1, n);
+        }
+
+        thinner.flush();
+
+        for (int i = 0; i < thinner.getNumPoints(); ++i)
+            breakpoints.push_back ({ thinner.getPoint (i).time, thinner.getPoint (i).gainDb });
+
+        return breakpoints;
+    }
+
+    float interpolate (const std::vector<Breakpoint>& breakpoints, std::int64_t time)
+    {
+        for (size_t i = 1; i < breakpoints.size(); ++i)
+        {
+            const auto& a = breakpoints[i - 1];
+            const auto& b = breakpoints[i];
+
+            if (time <= b.time)
+                return a.gainDb + (b.gainDb - a.gainDb) * (float) (time - a.time) / (float) (b.time - a.time);
+        }
+
+        return breakpoints.back().gainDb;
+    }
+}
+
+TEST_CASE ("The ride thinner keeps the curve within its tolerance", "[ride]")
+{
+    constexpr int numSamples = 4 * 48000;
+
+    for (const auto tolerance : { 0.1f, 0.25f, 1.0f })
+    {
+        RideThinner thinner;
+        thinner.toleranceDb = tolerance;
+
+        const auto breakpoints = thin (thinner, numSamples, 333);
+        REQUIRE (breakpoints.size() >= 2);
+
+        // Every sampled point is on the line between the breakpoints, give or take the tolerance
+        float worst = 0.0f;
+
+        for (int sample = 0; sample < numSamples - RideThinner::stepSamples; sample += RideThinner::stepSamples)
+            worst = std::max (worst, std::abs (interpolate (breakpoints, sample) - rideDb (sample)));
+
+        INFO ("tolerance " << tolerance << " dB, " << breakpoints.size() << " breakpoints");
+        CHECK (worst <= tolerance + 1.0e-3f);
+
+        // And it takes a small fraction of the points to get there
+        CHECK ((int) breakpoints.size() < numSamples / RideThinner::stepSamples / 20);
+
+        for (size_t i = 1; i < breakpoints.size(); ++i)
+            REQUIRE (breakpoints[i].time > breakpoints[i - 1].time);
+    }
+}
+
+TEST_CASE ("The ride thinner leaves out a steady fader", "[ride]")
+{
+    RideThinner thinner;
+    thinner.beginBlock();
+
+    std::vector<float> unity (4096, 1.0f);
+    const float* channels[] { unity.data() };
+
+    thinner.process (channels, 1, 4096);
+    CHECK (thinner.getNumPoints() == 1);
+    CHECK (thinner.getPoint (0).time == 0);
+    CHECK (thinner.getPoint (0).gainDb == 0.0f);
+
+    // Where the line ends, its last point is sent and marked
+    thinner.beginBlock();
+    thinner.flush();
+    REQUIRE (thinner.getNumPoints() == 1);
+    CHECK (thinner.getPoint (0).endsLine);
+    CHECK (thinner.getPoint (0).time == 0); // from the block before, so at the start of this one
+
+    // A new line starts with a breakpoint straight away
+    thinner.beginBlock();
+    thinner.process (channels, 1, 100);
+    REQUIRE (thinner.getNumPoints() == 1);
+    CHECK_FALSE (thinner.getPoint (0).endsLine);
+}
+
+TEST_CASE ("A block with more breakpoints than fit starts a new line", "[ride]")
+{
+    RideThinner thinner;
+    thinner.toleranceDb = 0.1f;
+
+    // A fader that jumps 3 dB every step keeps every point
+    constexpr int numSteps = RideThinner::maxPointsPerBlock * 2;
+    std::vector<float> jumpy ((size_t) (numSteps * RideThinner::stepSamples));
+
+    for (size_t i = 0; i < jumpy.size(); ++i)
+        jumpy[i] = ((i / RideThinner::stepSamples) % 2 == 0) ? 1.0f : 0.5f;
+
+    const float* channels[] { jumpy.data() };
+
+    thinner.beginBlock();
+    thinner.process (channels, 1, (int) jumpy.size());
+
+    REQUIRE (thinner.getNumPoints() == RideThinner::maxPointsPerBlock);
+    CHECK (thinner.getPoint (RideThinner::maxPointsPerBlock - 1).endsLine);
+
+    for (int i = 1; i < thinner.getNumPoints(); ++i)
+    {
+        CHECK_FALSE (thinner.getPoint (i - 1).endsLine);
+        CHECK (thinner.getPoint (i).time > thinner.getPoint (i - 1).time);
+    }
+
+    // Nothing is left over to end the line again
+    thinner.flush();
+    CHECK (thinner.getNumPoints() == RideThinner::maxPointsPerBlock);
+
+    // The next block starts a new line at its first point, on the same step grid
+    thinner.beginBlock();
+    thinner.process (channels, 1, 100);
+    REQUIRE (thinner.getNumPoints() >= 1);
+    CHECK (thinner.getPoint (0).time == 0);
+    CHECK (thinner.getPoint (0).gainDb == 0.0f);
+}
+
+TEST_CASE ("The ride goes out to a CLAP host as Ride Gain automation", "[ride][clap]")
+{
+    constexpr int blockSize = 512;
+
+    PluginProcessor plugin;
+    SyntheticPlayHead playHead;
+    plugin.prepareToPlay (playHead.sampleRate, blockSize);
+    plugin.parameters.mode = 1;
+
+    // Only the CLAP wrapper's instances offer WRITE; this one's driven by hand
+    CHECK_FALSE (plugin.canWriteRide());
+
+    juce::AudioBuffer<float> main (2, blockSize), sidechain (2, blockSize);
+    ClapProcessCall call (main, sidechain);
+    const auto rideGainID = ClapEventList::clapIDFor (plugin.parameters.rideGain);
+
+    int numValues = 0, numBegins = 0, numEnds = 0;
+    bool inGesture = false;
+    double lastValue = 0.0;
+
+    const auto runBlock = [&] (int block) {
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < blockSize; ++i)
+            {
+                const auto n = (float) (block * blockSize + i);
+                main.setSample (ch, i, ((block / 20) % 2 == 0 ? 0.8f : 0.05f) * std::sin (n * 0.03f));
+            }
+
+        REQUIRE (call.run (plugin, playHead) == CLAP_PROCESS_CONTINUE);
+        playHead.advance (blockSize);
+
+        uint32_t lastTime = 0;
+
+        for (uint32_t i = 0; i < call.output.numEvents; ++i)
+        {
+            const auto& event = call.output.events[i];
+            const auto& header = std::visit ([] (auto& e) -> const clap_event_header& { return e.header; }, event);
+
+            CHECK (header.time >= lastTime);
+            CHECK (header.time < (uint32_t) blockSize);
+            lastTime = header.time;
+
+            if (auto* value = std::get_if<clap_event_param_value> (&event))
+            {
+                CHECK (value->param_id == rideGainID);
+                CHECK (inGesture);
+
+                // Normalised, as the wrapper advertises every parameter to the host
+                CHECK (value->value >= 0.0);
+                CHECK (value->value <= 1.0);
+                lastValue = value->value;
+                ++numValues;
+            }
+            else if (auto* gesture = std::get_if<clap_event_param_gesture> (&event))
+            {
+                CHECK (gesture->param_id == rideGainID);
+                const auto begins = header.type == CLAP_EVENT_PARAM_GESTURE_BEGIN;
+                CHECK (begins != inGesture);
+                inGesture = begins;
+                ++(begins ? numBegins : numEnds);
+            }
+        }
+    };
+
+    SECTION ("nothing while writing is off")
+    {
+        for (int block = 0; block < 100; ++block)
+            runBlock (block);
+
+        CHECK (numValues == 0);
+        CHECK (numBegins == 0);
+    }
+
+    SECTION ("a thinned curve while playing, one gesture per take")
+    {
+        plugin.isRideWriting.store (true);
+
+        for (int block = 0; block < 100; ++block)
+            runBlock (block);
+
+        CHECK (numBegins == 1);
+        CHECK (numValues > 2);
+        CHECK (numValues < 100 * blockSize / RideThinner::stepSamples / 10);
+
+        // The plugin's own value follows what it told the host
+        const auto& rideGain = static_cast<const juce::AudioProcessorParameter&> (plugin.parameters.rideGain);
+        CHECK (std::abs (rideGain.getValue() - (float) lastValue) < 1.0e-6f);
+
+        playHead.playing = false;
+        runBlock (100);
+        CHECK (numEnds == 1);
+        CHECK_FALSE (inGesture);
+
+        playHead.playing = true;
+        runBlock (101);
+        CHECK (numBegins == 2);
+    }
+}
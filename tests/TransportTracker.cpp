@@ -0,0 +1,123 @@
+#include <TransportTracker.h>
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 480;
+    constexpr double quartersPerBlock = (120.0 / 60.0) * blockSize / sampleRate;
+
+    TransportTracker::Position playingAt (double ppq)
+    {
+        TransportTracker::Position position;
+        position.ppq = ppq;
+        position.hasPPQ = true;
+        position.isPlaying = true;
+        return position;
+    }
+}
+
+TEST_CASE ("Transport tracker", "[transport]")
+{
+    TransportTracker tracker;
+
+    SECTION ("first block reports start and tempo")
+    {
+        const auto events = tracker.update (playingAt (0.0), blockSize, sampleRate);
+        CHECK (events.started);
+        CHECK (events.tempoChanged);
+        CHECK (events.discontinuity());
+    }
+
+    SECTION ("steady playback is quiet")
+    {
+        tracker.update (playingAt (0.0), blockSize, sampleRate);
+
+        for (int block = 1; block < 10; ++block)
+            CHECK_FALSE (tracker.update (playingAt (block * quartersPerBlock), blockSize, sampleRate).discontinuity());
+    }
+
+    SECTION ("jumps in either direction")
+    {
+        tracker.update (playingAt (8.0), blockSize, sampleRate);
+        CHECK (tracker.update (playingAt (4.0), blockSize, sampleRate).jumped);
+        CHECK (tracker.update (playingAt (16.0), blockSize, sampleRate).jumped);
+    }
+
+    SECTION ("no jumps without a position from the host")
+    {
+        // What a host without a PPQ looks like: playing, with the position stuck at 0
+        TransportTracker::Position position;
+        position.isPlaying = true;
+        tracker.update (position, blockSize, sampleRate);
+
+        for (int block = 1; block < 10; ++block)
+            CHECK_FALSE (tracker.update (position, blockSize, sampleRate).discontinuity());
+
+        // Once there is one, it's checked from the block after
+        CHECK_FALSE (tracker.update (playingAt (50.0), blockSize, sampleRate).jumped);
+        CHECK (tracker.update (playingAt (4.0), blockSize, sampleRate).jumped);
+    }
+
+    SECTION ("wrapping to the loop start is a loop, not a jump")
+    {
+        auto position = playingAt (7.98);
+        position.isLooping = true;
+        position.loopStartPPQ = 4.0;
+        tracker.update (position, blockSize, sampleRate);
+
+        position.ppq = 4.0;
+        const auto events = tracker.update (position, blockSize, sampleRate);
+        CHECK (events.looped);
+        CHECK_FALSE (events.jumped);
+    }
+
+    SECTION ("stop, tempo change and restart")
+    {
+        tracker.update (playingAt (0.0), blockSize, sampleRate);
+
+        auto stopped = playingAt (quartersPerBlock);
+        stopped.isPlaying = false;
+        CHECK (tracker.update (stopped, blockSize, sampleRate).stopped);
+
+        stopped.bpm = 90.0;
+        const auto tempo = tracker.update (stopped, blockSize, sampleRate);
+        CHECK (tempo.tempoChanged);
+        CHECK_FALSE (tempo.discontinuity());
+
+        auto restarted = playingAt (quartersPerBlock);
+        restarted.bpm = 90.0;
+        CHECK (tracker.update (restarted, blockSize, sampleRate).started);
+    }
+
+    SECTION ("tempo ramps are told apart from tempo steps")
+    {
+        tracker.update (playingAt (0.0), blockSize, sampleRate);
+
+        // Stepping to 150 on the boundary: the last block still ran at 120
+        auto stepped = playingAt (quartersPerBlock);
+        stepped.bpm = 150.0;
+        const auto step = tracker.update (stepped, blockSize, sampleRate);
+        CHECK (step.tempoChanged);
+        CHECK_FALSE (step.discontinuity());
+        CHECK (step.bpmPerSample == 0.0);
+
+        // Ramping from 150 to 160 across the next block: it ran at 155 on average
+        auto ramped = playingAt (quartersPerBlock + (155.0 / 60.0) * blockSize / sampleRate);
+        ramped.bpm = 160.0;
+        const auto ramp = tracker.update (ramped, blockSize, sampleRate);
+        CHECK (ramp.tempoChanged);
+        CHECK_FALSE (ramp.discontinuity());
+        CHECK (ramp.bpmPerSample == 10.0 / blockSize);
+    }
+
+    SECTION ("instances don't share state")
+    {
+        TransportTracker other;
+        tracker.update (playingAt (0.0), blockSize, sampleRate);
+        other.update (playingAt (64.0), blockSize, sampleRate);
+
+        CHECK_FALSE (tracker.update (playingAt (quartersPerBlock), blockSize, sampleRate).discontinuity());
+        CHECK_FALSE (other.update (playingAt (64.0 + quartersPerBlock), blockSize, sampleRate).discontinuity());
+    }
+}
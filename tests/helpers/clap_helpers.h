@@ -0,0 +1,153 @@
+#pragma once
+#include <PluginProcessor.h>
+#include <SyntheticPlayHead.h>
+#include <array>
+#include <variant>
+
+/* A CLAP host's side of a process call, for driving PluginProcessor::processClap()
+ * without the wrapper: an input event list, transport events built from a
+ * SyntheticPlayHead, and a parameter handler that does what the wrapper would.
+ *
+ * Nothing here allocates once constructed, so it can run inside a RealtimeScope.
+ */
+struct ClapEventList
+{
+    using Event = std::variant<clap_event_param_value, clap_event_transport>;
+
+    std::array<Event, 16> events {};
+    uint32_t numEvents { 0 };
+
+    clap_input_events list { this, &getSize, &getEvent };
+
+    void clear() noexcept { numEvents = 0; }
+
+    // Events must be added in time order, as a host sends them. value is normalised (0..1), as a host sends it.
+    void addParameter (const juce::RangedAudioParameter& parameter, float value, uint32_t time) noexcept
+    {
+        clap_event_param_value event {};
+        event.header = { sizeof (event), time, CLAP_CORE_EVENT_SPACE_ID, CLAP_EVENT_PARAM_VALUE, 0 };
+        event.param_id = clapIDFor (parameter);
+        event.cookie = const_cast<juce::RangedAudioParameter*> (&parameter);
+        event.note_id = -1;
+        event.port_index = -1;
+        event.channel = -1;
+        event.key = -1;
+        event.value = value;
+        events[numEvents++] = event;
+    }
+
+    void addTransport (const SyntheticPlayHead& playHead, uint32_t time) noexcept
+    {
+        auto event = transportFor (playHead);
+        event.header.time = time;
+        events[numEvents++] = event;
+    }
+
+    // The ID the CLAP wrapper gives a JUCE parameter
+    static clap_id clapIDFor (const juce::RangedAudioParameter& parameter) noexcept
+    {
+        return (clap_id) parameter.getParameterID().hashCode();
+    }
+
+    static clap_event_transport transportFor (const SyntheticPlayHead& playHead) noexcept
+    {
+        clap_event_transport transport {};
+        transport.header = { sizeof (transport), 0, CLAP_CORE_EVENT_SPACE_ID, CLAP_EVENT_TRANSPORT, 0 };
+        transport.flags = CLAP_TRANSPORT_HAS_TEMPO | CLAP_TRANSPORT_HAS_BEATS_TIMELINE
+                        | (playHead.playing ? CLAP_TRANSPORT_IS_PLAYING : 0u);
+        transport.tempo = playHead.bpm;
+        transport.song_pos_beats = (clap_beattime) std::llround (playHead.ppqPosition * (double) CLAP_BEATTIME_FACTOR);
+        return transport;
+    }
+
+    // Sets the parameter the way the wrapper's paramSetValueAndNotifyIfChanged() does. Without
+    // CLAP_USE_JUCE_PARAMETER_RANGES the host's value is already 0..1, so it goes straight to
+    // setValue(). The parameter's listeners hear about it, but the host isn't told.
+    static void applyParameter (PluginProcessor&, const clap_event_param_value& event) noexcept
+    {
+        auto& parameter = *static_cast<juce::AudioProcessorParameter*> (static_cast<juce::RangedAudioParameter*> (event.cookie));
+        const auto value = (float) event.value;
+
+        if (juce::exactlyEqual (parameter.getValue(), value))
+            return;
+
+        parameter.setValue (value);
+        parameter.sendValueChangedMessageToListeners (value);
+    }
+
+private:
+    static uint32_t getSize (const clap_input_events* list) noexcept
+    {
+        return static_cast<const ClapEventList*> (list->ctx)->numEvents;
+    }
+
+    static const clap_event_header* getEvent (const clap_input_events* list, uint32_t index) noexcept
+    {
+        auto& event = static_cast<const ClapEventList*> (list->ctx)->events[index];
+        return std::visit ([] (auto& e) { return &e.header; }, event);
+    }
+};
+
+// What the plugin sends back to the host in one process call: parameter values and gestures
+struct ClapOutputList
+{
+    using Event = std::variant<clap_event_param_value, clap_event_param_gesture>;
+
+    std::array<Event, 512> events {};
+    uint32_t numEvents { 0 };
+
+    clap_output_events list { this, &tryPush };
+
+    void clear() noexcept { numEvents = 0; }
+
+private:
+    static bool tryPush (const clap_output_events* list, const clap_event_header* event) noexcept
+    {
+        auto& self = *static_cast<ClapOutputList*> (list->ctx);
+
+        if (self.numEvents == self.events.size() || event->space_id != CLAP_CORE_EVENT_SPACE_ID)
+            return false;
+
+        if (event->type == CLAP_EVENT_PARAM_VALUE)
+            self.events[self.numEvents++] = *reinterpret_cast<const clap_event_param_value*> (event);
+        else if (event->type == CLAP_EVENT_PARAM_GESTURE_BEGIN || event->type == CLAP_EVENT_PARAM_GESTURE_END)
+            self.events[self.numEvents++] = *reinterpret_cast<const clap_event_param_gesture*> (event);
+        else
+            return false;
+
+        return true;
+    }
+};
+
+// One process call over a plugin's main input/output and sidechain, in place like most hosts
+struct ClapProcessCall
+{
+    ClapProcessCall (juce::AudioBuffer<float>& main, juce::AudioBuffer<float>& sidechain)
+    {
+        ports[0] = { const_cast<float**> (main.getArrayOfWritePointers()), nullptr, (uint32_t) main.getNumChannels(), 0, 0 };
+        ports[1] = { const_cast<float**> (sidechain.getArrayOfWritePointers()), nullptr, (uint32_t) sidechain.getNumChannels(), 0, 0 };
+
+        process.frames_count = (uint32_t) main.getNumSamples();
+        process.steady_time = -1;
+        process.audio_inputs = ports;
+        process.audio_outputs = ports;
+        process.audio_inputs_count = 2;
+        process.audio_outputs_count = 1;
+        process.in_events = &events.list;
+        process.out_events = &output.list;
+    }
+
+    clap_process_status run (PluginProcessor& plugin, const SyntheticPlayHead& playHead) noexcept
+    {
+        output.clear();
+        transport = ClapEventList::transportFor (playHead);
+        process.transport = &transport;
+        return plugin.processClap (process, &ClapEventList::applyParameter);
+    }
+
+    ClapEventList events;
+    ClapOutputList output;
+    clap_audio_buffer ports[2] {};
+    clap_event_transport transport {};
+    clap_process process {};
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include <OfflineRenderer.h>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+
+/* Audio files for the render tests: test signals written to WAVs in the temp
+ * folder, and read back.
+ */
+constexpr double renderSampleRate = 48000.0;
+
+// Phrases at two levels over a tone, different on each channel
+inline juce::AudioBuffer<float> makeSignal (int numChannels, double seconds, double frequency)
+{
+    juce::AudioBuffer<float> signal (numChannels, (int) (seconds * renderSampleRate));
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int i = 0; i < signal.getNumSamples(); ++i)
+        {
+            const auto t = (double) i / renderSampleRate;
+            const auto phrase = ((int) (t * (3.0 + ch)) % 3 == 0) ? 0.05 : 0.6;
+            signal.setSample (ch, i, (float) (phrase * std::sin (juce::MathConstants<double>::twoPi * frequency * t)));
+        }
+
+    return signal;
+}
+
+// A fresh name every time, even before anything is written there
+inline juce::File tempFile (const juce::String& name)
+{
+    return juce::File::getSpecialLocation (juce::File::tempDirectory).getChildFile (name + "-" + juce::Uuid().toDashedString() + ".wav");
+}
+
+inline juce::File writeWav (const juce::AudioBuffer<float>& signal, int bitsPerSample, bool floatingPoint)
+{
+    auto file = tempFile ("offline-render-in");
+    std::unique_ptr<juce::OutputStream> stream (file.createOutputStream());
+
+    const auto options = juce::AudioFormatWriterOptions {}
+                             .withSampleRate (renderSampleRate)
+                             .withNumChannels (signal.getNumChannels())
+                             .withBitsPerSample (bitsPerSample)
+                             .withSampleFormat (floatingPoint ? juce::AudioFormatWriterOptions::SampleFormat::floatingPoint
+                                                              : juce::AudioFormatWriterOptions::SampleFormat::integral);
+
+    auto writer = juce::WavAudioFormat().createWriterFor (stream, options);
+    REQUIRE (writer != nullptr);
+    writer->writeFromAudioSampleBuffer (signal, 0, signal.getNumSamples());
+
+    return file;
+}
+
+inline std::unique_ptr<juce::AudioFormatReader> openWav (const juce::File& file)
+{
+    return std::unique_ptr<juce::AudioFormatReader> (juce::WavAudioFormat().createReaderFor (file.createInputStream().release(), true));
+}
+
+inline juce::AudioBuffer<float> readWav (const juce::File& file)
+{
+    auto reader = openWav (file);
+    REQUIRE (reader != nullptr);
+
+    juce::AudioBuffer<float> signal ((int) reader->numChannels, (int) reader->lengthInSamples);
+    reader->read (&signal, 0, signal.getNumSamples(), 0, true, true);
+    return signal;
+}
+
+// The largest difference between b and a from aStart, over numSamples on b's channels
+inline float maxDifference (const juce::AudioBuffer<float>& a, int aStart, const juce::AudioBuffer<float>& b, int numSamples)
+{
+    float worst = 0.0f;
+
+    for (int ch = 0; ch < b.getNumChannels(); ++ch)
+        for (int i = 0; i < numSamples; ++i)
+            worst = std::max (worst, std::abs (a.getSample (ch, aStart + i) - b.getSample (ch, i)));
+
+    return worst;
+}